@@ -0,0 +1,105 @@
+#! /usr/bin/env python3
+# Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+import time
+import unittest
+import logging
+
+import launch
+import launch_testing.actions
+import launch_testing.markers
+import pytest
+
+import rclpy
+from geometry_msgs.msg import Pose
+from rr_sim_tests.utils.wait_for_service import wait_for_service
+from rr_sim_tests.utils.wait_for_spawned_entity import wait_for_spawned_entity
+from ue_msgs.msg import EntityState
+from ue_msgs.srv import SpawnEntities
+
+SERVICE_NAME_SPAWN_ENTITIES = 'SpawnEntities'
+
+"""
+Spawn a grid of entities with a single SpawnEntities request, and measure wall time of the service call and until the last
+entity is available.
+"""
+LAUNCH_ARG_ENTITY_MODEL = 'entity_model'
+LAUNCH_ARG_NUM_ENTITIES = 'num_entities'
+LAUNCH_ARG_ENTITY_SPACING = 'entity_spacing'
+LAUNCH_ARG_MAX_SPAWN_TIME = 'max_spawn_time'
+
+@pytest.mark.launch_test
+@launch_testing.markers.keep_alive
+def generate_test_description():
+    entity_model = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_ENTITY_MODEL, default='')
+    num_entities = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_NUM_ENTITIES, default='1000')
+    entity_spacing = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_ENTITY_SPACING, default='2.0')
+    max_spawn_time = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_MAX_SPAWN_TIME, default='0.0')
+    return launch.LaunchDescription([
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_ENTITY_MODEL,
+            default_value=entity_model,
+            description='Spawnable entity model, e.g. box'),
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_NUM_ENTITIES,
+            default_value=num_entities,
+            description='Number of entities spawned by the request'),
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_ENTITY_SPACING,
+            default_value=entity_spacing,
+            description='Distance [m] between entities of the grid'),
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_MAX_SPAWN_TIME,
+            default_value=max_spawn_time,
+            description='Max expected time [s] until the last entity is available, not checked if not positive'),
+        launch_testing.actions.ReadyToTest()
+    ])
+
+class TestEntitiesSpawnBenchmark(unittest.TestCase):
+    def test_spawn_entities(self, proc_output, test_args):
+        assert LAUNCH_ARG_ENTITY_MODEL in test_args
+        entity_model = str(test_args[LAUNCH_ARG_ENTITY_MODEL])
+        num_entities = int(test_args[LAUNCH_ARG_NUM_ENTITIES]) if LAUNCH_ARG_NUM_ENTITIES in test_args else 1000
+        entity_spacing = float(test_args[LAUNCH_ARG_ENTITY_SPACING]) if LAUNCH_ARG_ENTITY_SPACING in test_args else 2.0
+        max_spawn_time = float(test_args[LAUNCH_ARG_MAX_SPAWN_TIME]) if LAUNCH_ARG_MAX_SPAWN_TIME in test_args else 0.0
+
+        rclpy.init()
+        node = rclpy.create_node('spawn_entities_benchmark')
+        cli = wait_for_service(node, SpawnEntities, '/' + SERVICE_NAME_SPAWN_ENTITIES)
+        assert cli.service_is_ready(), f'{SERVICE_NAME_SPAWN_ENTITIES} is unavailable'
+
+        # Square grid of entities, with unique names per run
+        req = SpawnEntities.Request()
+        grid_size = max(1, int(num_entities ** 0.5))
+        name_prefix = f'bench{int(time.time())}_'
+        for i in range(num_entities):
+            state = EntityState()
+            state.name = f'{name_prefix}{i}'
+            state.pose = Pose()
+            state.pose.position.x = (i % grid_size) * entity_spacing
+            state.pose.position.y = (i // grid_size) * entity_spacing
+            state.pose.orientation.w = 1.0
+            req.type.append(entity_model)
+            req.state.append(state)
+
+        start_time = time.time()
+        future = cli.call_async(req)
+        rclpy.spin_until_future_complete(node, future, timeout_sec=max(60.0, max_spawn_time))
+        service_time = time.time() - start_time
+        assert future.done(), f'{SERVICE_NAME_SPAWN_ENTITIES} has not responded'
+        result = future.result()
+        node.destroy_node()
+
+        last_entity_name = req.state[-1].name
+        is_spawned, _ = wait_for_spawned_entity(last_entity_name, in_timeout=max(60.0, max_spawn_time))
+        spawn_time = time.time() - start_time
+        logging.info(
+            f'{SERVICE_NAME_SPAWN_ENTITIES} of {num_entities} [{entity_model}]: success: {result.success}, '
+            f'response in {service_time:.3f}s, last entity available in {spawn_time:.3f}s'
+        )
+
+        assert result.success, f'{SERVICE_NAME_SPAWN_ENTITIES} failed: {result.status_message}'
+        assert is_spawned, f'{last_entity_name} failed being spawned!'
+        if max_spawn_time > 0.0:
+            assert spawn_time <= max_spawn_time, f'{num_entities} entities spawned in {spawn_time:.3f}s > {max_spawn_time}s'
+        rclpy.shutdown()
@@ -0,0 +1,141 @@
+#! /usr/bin/env python3
+# Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+import time
+import unittest
+import logging
+
+import launch
+import launch_testing.actions
+import launch_testing.markers
+import pytest
+
+import rclpy
+from geometry_msgs.msg import Pose
+from rosgraph_msgs.msg import Clock
+from rr_sim_tests.utils.wait_for_service import wait_for_service
+from ue_msgs.msg import EntityState
+from ue_msgs.srv import GetEntityState, SpawnEntities
+
+SERVICE_NAME_SPAWN_ENTITIES = 'SpawnEntities'
+SERVICE_NAME_GET_ENTITY_STATE = 'GetEntityState'
+TOPIC_NAME_CLOCK = 'clock'
+
+"""
+Spawn a grid of entities with a single SpawnEntities request to a sim whose SimulationState has a spawn budget, and check
+that spawning is spread over frames whose wall time stays bounded, measured as intervals between /clock messages, which are
+published once per frame.
+"""
+LAUNCH_ARG_ENTITY_MODEL = 'entity_model'
+LAUNCH_ARG_NUM_ENTITIES = 'num_entities'
+LAUNCH_ARG_ENTITY_SPACING = 'entity_spacing'
+LAUNCH_ARG_SPAWN_BUDGET_ENTITIES = 'spawn_budget_entities'
+LAUNCH_ARG_MAX_FRAME_TIME = 'max_frame_time'
+LAUNCH_ARG_MAX_SPAWN_TIME = 'max_spawn_time'
+
+@pytest.mark.launch_test
+@launch_testing.markers.keep_alive
+def generate_test_description():
+    entity_model = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_ENTITY_MODEL, default='')
+    num_entities = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_NUM_ENTITIES, default='1000')
+    entity_spacing = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_ENTITY_SPACING, default='2.0')
+    spawn_budget_entities = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_SPAWN_BUDGET_ENTITIES, default='0')
+    max_frame_time = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_MAX_FRAME_TIME, default='0.1')
+    max_spawn_time = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_MAX_SPAWN_TIME, default='120.0')
+    return launch.LaunchDescription([
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_ENTITY_MODEL,
+            default_value=entity_model,
+            description='Spawnable entity model, e.g. box'),
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_NUM_ENTITIES,
+            default_value=num_entities,
+            description='Number of entities spawned by the request'),
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_ENTITY_SPACING,
+            default_value=entity_spacing,
+            description='Distance [m] between entities of the grid'),
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_SPAWN_BUDGET_ENTITIES,
+            default_value=spawn_budget_entities,
+            description='SpawnBudgetEntities of the sim, to check the min number of frames, not checked if not positive'),
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_MAX_FRAME_TIME,
+            default_value=max_frame_time,
+            description='Max expected wall time [s] between 2 /clock messages while spawning'),
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_MAX_SPAWN_TIME,
+            default_value=max_spawn_time,
+            description='Max time [s] until the last entity is available'),
+        launch_testing.actions.ReadyToTest()
+    ])
+
+class TestEntitiesSpawnBudget(unittest.TestCase):
+    def test_spawn_entities_with_budget(self, proc_output, test_args):
+        assert LAUNCH_ARG_ENTITY_MODEL in test_args
+        entity_model = str(test_args[LAUNCH_ARG_ENTITY_MODEL])
+        num_entities = int(test_args[LAUNCH_ARG_NUM_ENTITIES]) if LAUNCH_ARG_NUM_ENTITIES in test_args else 1000
+        entity_spacing = float(test_args[LAUNCH_ARG_ENTITY_SPACING]) if LAUNCH_ARG_ENTITY_SPACING in test_args else 2.0
+        spawn_budget_entities = \
+            int(test_args[LAUNCH_ARG_SPAWN_BUDGET_ENTITIES]) if LAUNCH_ARG_SPAWN_BUDGET_ENTITIES in test_args else 0
+        max_frame_time = float(test_args[LAUNCH_ARG_MAX_FRAME_TIME]) if LAUNCH_ARG_MAX_FRAME_TIME in test_args else 0.1
+        max_spawn_time = float(test_args[LAUNCH_ARG_MAX_SPAWN_TIME]) if LAUNCH_ARG_MAX_SPAWN_TIME in test_args else 120.0
+
+        rclpy.init()
+        node = rclpy.create_node('spawn_entities_budget')
+        spawn_cli = wait_for_service(node, SpawnEntities, '/' + SERVICE_NAME_SPAWN_ENTITIES)
+        assert spawn_cli.service_is_ready(), f'{SERVICE_NAME_SPAWN_ENTITIES} is unavailable'
+        state_cli = wait_for_service(node, GetEntityState, '/' + SERVICE_NAME_GET_ENTITY_STATE)
+        assert state_cli.service_is_ready(), f'{SERVICE_NAME_GET_ENTITY_STATE} is unavailable'
+
+        # Square grid of entities, with unique names per run
+        req = SpawnEntities.Request()
+        grid_size = max(1, int(num_entities ** 0.5))
+        name_prefix = f'budget{int(time.time())}_'
+        for i in range(num_entities):
+            state = EntityState()
+            state.name = f'{name_prefix}{i}'
+            state.pose = Pose()
+            state.pose.position.x = (i % grid_size) * entity_spacing
+            state.pose.position.y = (i // grid_size) * entity_spacing
+            state.pose.orientation.w = 1.0
+            req.type.append(entity_model)
+            req.state.append(state)
+
+        # Wall time of each /clock message, i.e. of each frame
+        clock_times = []
+        node.create_subscription(Clock, '/' + TOPIC_NAME_CLOCK, lambda _: clock_times.append(time.time()), 100)
+
+        start_time = time.time()
+        spawn_future = spawn_cli.call_async(req)
+        rclpy.spin_until_future_complete(node, spawn_future, timeout_sec=max_spawn_time)
+        assert spawn_future.done(), f'{SERVICE_NAME_SPAWN_ENTITIES} has not responded'
+        result = spawn_future.result()
+        assert result.success, f'{SERVICE_NAME_SPAWN_ENTITIES} failed: {result.status_message}'
+
+        # Keep receiving /clock until the last entity is available
+        state_req = GetEntityState.Request()
+        state_req.name = req.state[-1].name
+        is_spawned = False
+        while not is_spawned and (time.time() - start_time) < max_spawn_time:
+            state_future = state_cli.call_async(state_req)
+            rclpy.spin_until_future_complete(node, state_future, timeout_sec=max_spawn_time)
+            is_spawned = state_future.done() and state_future.result().success
+        spawn_time = time.time() - start_time
+        node.destroy_node()
+        rclpy.shutdown()
+
+        frame_times = [t1 - t0 for t0, t1 in zip(clock_times, clock_times[1:])]
+        max_measured_frame_time = max(frame_times, default=spawn_time)
+        logging.info(
+            f'{num_entities} [{entity_model}] spawned in {spawn_time:.3f}s over {len(clock_times)} frames, '
+            f'max frame time {max_measured_frame_time:.3f}s'
+        )
+
+        assert is_spawned, f'{state_req.name} failed being spawned in {max_spawn_time}s!'
+        assert max_measured_frame_time <= max_frame_time, \
+            f'Frame time spiked to {max_measured_frame_time:.3f}s > {max_frame_time}s while spawning'
+        if spawn_budget_entities > 0:
+            min_frames = -(-num_entities // spawn_budget_entities)
+            assert len(clock_times) >= min_frames, \
+                f'{num_entities} entities spawned in {len(clock_times)} frames, fewer than {min_frames} of the budget'
@@ -0,0 +1,175 @@
+#! /usr/bin/env python3
+# Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+import json
+import os
+import time
+import unittest
+import logging
+
+import launch
+import launch_testing.actions
+import launch_testing.markers
+from tf2_msgs.msg import TFMessage
+import pytest
+
+import rclpy
+from rclpy.node import Node
+from rclpy.serialization import deserialize_message
+from rclpy.qos import QoSDurabilityPolicy, QoSReliabilityPolicy, QoSHistoryPolicy, QoSProfile
+
+from distutils.util import strtobool
+
+# TF topics are always in global namespace
+TOPIC_NAME_TF = '/tf'
+TOPIC_NAME_TF_STATIC = '/tf_static'
+
+TF_QOS = QoSProfile(
+    reliability=QoSReliabilityPolicy.RMW_QOS_POLICY_RELIABILITY_RELIABLE,
+    history=QoSHistoryPolicy.RMW_QOS_POLICY_HISTORY_KEEP_LAST,
+    depth=100
+)
+# Same as tf2_ros static listener, so that static tfs latched by every publisher are received
+TF_STATIC_QOS = QoSProfile(
+    reliability=QoSReliabilityPolicy.RMW_QOS_POLICY_RELIABILITY_RELIABLE,
+    durability=QoSDurabilityPolicy.RMW_QOS_POLICY_DURABILITY_TRANSIENT_LOCAL,
+    history=QoSHistoryPolicy.RMW_QOS_POLICY_HISTORY_KEEP_LAST,
+    depth=100
+)
+
+class TFRateCounter(Node):
+    def __init__(self):
+        super().__init__(node_name='tf_rate_counter')
+        self.num_tf_msgs = 0
+        self.num_tf_transforms = 0
+        self.num_tf_bytes = 0
+        self.static_child_frame_ids = set()
+        self.create_subscription(TFMessage, TOPIC_NAME_TF, self.on_tf_published, TF_QOS, raw=True)
+        self.create_subscription(TFMessage, TOPIC_NAME_TF_STATIC, self.on_tf_static_published, TF_STATIC_QOS)
+
+    def on_tf_published(self, raw_msg):
+        msg = deserialize_message(raw_msg, TFMessage)
+        self.num_tf_msgs += 1
+        self.num_tf_transforms += len(msg.transforms)
+        self.num_tf_bytes += len(raw_msg)
+
+    def on_tf_static_published(self, msg):
+        # Each static tf message holds all static tfs of its publisher
+        self.static_child_frame_ids.update(tf.child_frame_id for tf in msg.transforms)
+
+    def measure(self, in_duration):
+        start_time = time.time()
+        while (time.time() - start_time) < in_duration:
+            rclpy.spin_once(self, timeout_sec=0.1)
+        return time.time() - start_time
+
+"""
+Measure messages, transforms and bytes per second published on /tf, and static tfs latched on /tf_static.
+Compare them before and after TF split or aggregation, e.g. with odom tf aggregation, /tf has a single odom tf
+publisher and one message per cycle whatever the number of robots:
+1. Run the sim with the split disabled (e.g. bSplitStaticTFs false), then this test with baseline_file:=<path>,
+   which saves the measurement to <path> since it does not exist yet.
+2. Run the same world with the split enabled, then this test with the same baseline_file, which compares the
+   measurement with the saved one and checks that /tf bytes per second are at most max_tf_bytes_ratio of it.
+"""
+LAUNCH_ARG_MEASURE_DURATION = 'measure_duration'
+LAUNCH_ARG_MAX_TF_MSG_RATE = 'max_tf_msg_rate'
+LAUNCH_ARG_TF_STATIC_EXPECTED = 'is_tf_static_expected'
+LAUNCH_ARG_MAX_TF_PUBLISHERS = 'max_tf_publishers'
+LAUNCH_ARG_BASELINE_FILE = 'baseline_file'
+LAUNCH_ARG_MAX_TF_BYTES_RATIO = 'max_tf_bytes_ratio'
+
+@pytest.mark.launch_test
+@launch_testing.markers.keep_alive
+def generate_test_description():
+    measure_duration = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_MEASURE_DURATION, default='10.0')
+    max_tf_msg_rate = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_MAX_TF_MSG_RATE, default='0.0')
+    is_tf_static_expected = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_TF_STATIC_EXPECTED, default='False')
+    max_tf_publishers = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_MAX_TF_PUBLISHERS, default='0')
+    baseline_file = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_BASELINE_FILE, default='')
+    max_tf_bytes_ratio = launch.substitutions.LaunchConfiguration(LAUNCH_ARG_MAX_TF_BYTES_RATIO, default='1.0')
+    return launch.LaunchDescription([
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_MEASURE_DURATION,
+            default_value=measure_duration,
+            description='Duration [s] of measurement'),
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_MAX_TF_MSG_RATE,
+            default_value=max_tf_msg_rate,
+            description='Max expected /tf messages per second, not checked if not positive'),
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_TF_STATIC_EXPECTED,
+            default_value=is_tf_static_expected,
+            description='Whether static tfs are expected on /tf_static'),
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_MAX_TF_PUBLISHERS,
+            default_value=max_tf_publishers,
+            description='Max expected /tf publishers, not checked if not positive'),
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_BASELINE_FILE,
+            default_value=baseline_file,
+            description='Measurement is saved to this file if it does not exist, else compared with the saved one'),
+        launch.actions.DeclareLaunchArgument(
+            LAUNCH_ARG_MAX_TF_BYTES_RATIO,
+            default_value=max_tf_bytes_ratio,
+            description='Max expected ratio of /tf bytes per second to the baseline, not checked if not positive'),
+        launch_testing.actions.ReadyToTest()
+    ])
+
+class TestTFRate(unittest.TestCase):
+    def test_measure_tf_rate(self, proc_output, test_args):
+        measure_duration = float(test_args[LAUNCH_ARG_MEASURE_DURATION]) if LAUNCH_ARG_MEASURE_DURATION in test_args else 10.0
+        max_tf_msg_rate = float(test_args[LAUNCH_ARG_MAX_TF_MSG_RATE]) if LAUNCH_ARG_MAX_TF_MSG_RATE in test_args else 0.0
+        is_tf_static_expected = bool(strtobool(test_args[LAUNCH_ARG_TF_STATIC_EXPECTED])) \
+            if LAUNCH_ARG_TF_STATIC_EXPECTED in test_args else False
+        max_tf_publishers = int(test_args[LAUNCH_ARG_MAX_TF_PUBLISHERS]) if LAUNCH_ARG_MAX_TF_PUBLISHERS in test_args else 0
+        baseline_file = test_args[LAUNCH_ARG_BASELINE_FILE] if LAUNCH_ARG_BASELINE_FILE in test_args else ''
+        max_tf_bytes_ratio = float(test_args[LAUNCH_ARG_MAX_TF_BYTES_RATIO]) \
+            if LAUNCH_ARG_MAX_TF_BYTES_RATIO in test_args else 1.0
+
+        rclpy.init()
+        counter = TFRateCounter()
+        duration = counter.measure(measure_duration)
+        measurement = {
+            'tf_publishers': counter.count_publishers(TOPIC_NAME_TF),
+            'tf_msg_rate': counter.num_tf_msgs / duration,
+            'tf_transform_rate': counter.num_tf_transforms / duration,
+            'tf_bytes_rate': counter.num_tf_bytes / duration,
+            'num_static_tfs': len(counter.static_child_frame_ids)
+        }
+        tf_msg_rate = measurement['tf_msg_rate']
+        num_tf_publishers = measurement['tf_publishers']
+        logging.info(
+            f'{TOPIC_NAME_TF} publishers: {num_tf_publishers}, '
+            f'{TOPIC_NAME_TF_STATIC} publishers: {counter.count_publishers(TOPIC_NAME_TF_STATIC)}\n'
+            f'{TOPIC_NAME_TF}: {tf_msg_rate:.1f} msgs/s, {measurement["tf_transform_rate"]:.1f} transforms/s, '
+            f'{measurement["tf_bytes_rate"]:.0f} bytes/s\n'
+            f'{TOPIC_NAME_TF_STATIC}: {measurement["num_static_tfs"]} static tfs'
+        )
+
+        baseline = None
+        if baseline_file and os.path.exists(baseline_file):
+            with open(baseline_file) as f:
+                baseline = json.load(f)
+            logging.info('Before -> after:\n' + '\n'.join(
+                f'{key}: {baseline[key]:.1f} -> {value:.1f}' for key, value in measurement.items()))
+        elif baseline_file:
+            with open(baseline_file, 'w') as f:
+                json.dump(measurement, f)
+            logging.info(f'Saved baseline to {baseline_file}')
+
+        assert (counter.num_tf_msgs > 0) or (len(counter.static_child_frame_ids) > 0), 'No tf has been received'
+        if is_tf_static_expected:
+            assert len(counter.static_child_frame_ids) > 0, f'No static tf has been latched on {TOPIC_NAME_TF_STATIC}'
+        if max_tf_msg_rate > 0.0:
+            assert tf_msg_rate <= max_tf_msg_rate, f'{tf_msg_rate:.1f} msgs/s on {TOPIC_NAME_TF} > {max_tf_msg_rate}'
+        if max_tf_publishers > 0:
+            assert num_tf_publishers <= max_tf_publishers, \
+                f'{num_tf_publishers} publishers on {TOPIC_NAME_TF} > {max_tf_publishers}'
+        if baseline is not None and max_tf_bytes_ratio > 0.0:
+            max_tf_bytes_rate = baseline['tf_bytes_rate'] * max_tf_bytes_ratio
+            assert measurement['tf_bytes_rate'] <= max_tf_bytes_rate, \
+                f'{measurement["tf_bytes_rate"]:.0f} bytes/s on {TOPIC_NAME_TF} > {max_tf_bytes_rate:.0f}'
+
+        counter.destroy_node()
+        rclpy.shutdown()
@@ -29,6 +29,8 @@
 
 IImageWrapperModule* URRCoreUtils::SImageWrapperModule = nullptr;
 TMap<ERRFileType, TSharedPtr<IImageWrapper>> URRCoreUtils::SImageWrappers;
+TMap<ERRFileType, TArray<TSharedPtr<IImageWrapper>>> URRCoreUtils::SImageWrapperPool;
+FCriticalSection URRCoreUtils::SImageWrapperPoolMutex;
 FRRLightProfileData URRCoreUtils::SLightProfileData;
 TFunction<void(uint8*, const FUpdateTextureRegion2D*)> URRCoreUtils::CleanupLightProfileData =
     [](uint8*, const FUpdateTextureRegion2D*)
@@ -62,6 +64,62 @@ void URRCoreUtils::LoadImageWrapperModule()
     }
 }
 
+TSharedPtr<IImageWrapper> URRCoreUtils::AcquireImageWrapper(const ERRFileType InImageFileType)
+{
+    {
+        FScopeLock lock(&SImageWrapperPoolMutex);
+        TArray<TSharedPtr<IImageWrapper>>* freeImageWrappers = SImageWrapperPool.Find(InImageFileType);
+        if (freeImageWrappers && (freeImageWrappers->Num() > 0))
+        {
+            return freeImageWrappers->Pop(false);
+        }
+    }
+
+    verify(SImageWrapperModule);
+    switch (InImageFileType)
+    {
+        case ERRFileType::IMAGE_JPG:
+            return SImageWrapperModule->CreateImageWrapper(EImageFormat::JPEG);
+        case ERRFileType::IMAGE_GRAYSCALE_JPG:
+            return SImageWrapperModule->CreateImageWrapper(EImageFormat::GrayscaleJPEG);
+        case ERRFileType::IMAGE_PNG:
+            return SImageWrapperModule->CreateImageWrapper(EImageFormat::PNG);
+        case ERRFileType::IMAGE_EXR:
+            return SImageWrapperModule->CreateImageWrapper(EImageFormat::EXR);
+        default:
+            return nullptr;
+    }
+}
+
+void URRCoreUtils::ReleaseImageWrapper(const ERRFileType InImageFileType, TSharedPtr<IImageWrapper> InImageWrapper)
+{
+    if (InImageWrapper.IsValid())
+    {
+        FScopeLock lock(&SImageWrapperPoolMutex);
+        SImageWrapperPool.FindOrAdd(InImageFileType).Add(MoveTemp(InImageWrapper));
+    }
+}
+
+void URRCoreUtils::CompressImageData(const ERRFileType InImageFileType,
+                                     const void* InRawData,
+                                     const int64 InRawSize,
+                                     const FIntPoint& InImageSize,
+                                     const ERGBFormat InRGBFormat,
+                                     const int8 InBitDepth,
+                                     const int32 InQuality,
+                                     TArray64<uint8>& OutCompressedData)
+{
+    TSharedPtr<IImageWrapper> imageWrapper = AcquireImageWrapper(InImageFileType);
+    verify(imageWrapper.IsValid());
+    imageWrapper->SetRaw(InRawData, InRawSize, InImageSize.X, InImageSize.Y, InRGBFormat, InBitDepth);
+    // Quality only matters to JPG, other formats use their default compression
+    const int32 defaultQuality = static_cast<int32>(EImageCompressionQuality::Default);
+    const bool bIsJPG = (ERRFileType::IMAGE_JPG == InImageFileType) || (ERRFileType::IMAGE_GRAYSCALE_JPG == InImageFileType);
+    OutCompressedData = imageWrapper->GetCompressed((bIsJPG && (InQuality != defaultQuality)) ? FMath::Clamp(InQuality, 1, 100)
+                                                                                              : defaultQuality);
+    ReleaseImageWrapper(InImageFileType, MoveTemp(imageWrapper));
+}
+
 int32 URRCoreUtils::GetMaxSplitscreenPlayers(const UObject* InContextObject)
 {
     UGameInstance* gameInstance = GetGameInstance<UGameInstance>(InContextObject);
@@ -0,0 +1,247 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+#include "Core/RREntityIndexSubsystem.h"
+
+// UE
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Kismet/KismetSystemLibrary.h"
+#include "Misc/CoreDelegates.h"
+
+URREntityIndexSubsystem* URREntityIndexSubsystem::Get(const UWorld* InWorld)
+{
+    return InWorld ? InWorld->GetSubsystem<URREntityIndexSubsystem>() : nullptr;
+}
+
+bool URREntityIndexSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+    // Actors of editor worlds are renamed, relabeled and deleted by the editor without notification
+    return (WorldType == EWorldType::Game) || (WorldType == EWorldType::PIE);
+}
+
+void URREntityIndexSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    UWorld* world = GetWorld();
+    ActorSpawnedHandle = world->AddOnActorSpawnedHandler(
+        FOnActorSpawned::FDelegate::CreateUObject(this, &URREntityIndexSubsystem::OnActorSpawned));
+    LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &URREntityIndexSubsystem::OnLevelAddedToWorld);
+#if WITH_EDITOR
+    ActorLabelChangedHandle = FCoreDelegates::OnActorLabelChanged.AddUObject(this, &URREntityIndexSubsystem::OnActorLabelChanged);
+#endif
+}
+
+void URREntityIndexSubsystem::Deinitialize()
+{
+    GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+    FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+#if WITH_EDITOR
+    FCoreDelegates::OnActorLabelChanged.Remove(ActorLabelChangedHandle);
+#endif
+    EntitiesByName.Reset();
+#if WITH_EDITOR
+    EntitiesByDisplayName.Reset();
+#endif
+    EntitiesByTag.Reset();
+    bIndexBuilt = false;
+
+    Super::Deinitialize();
+}
+
+void URREntityIndexSubsystem::BuildIndex()
+{
+    if (bIndexBuilt)
+    {
+        return;
+    }
+
+    for (TActorIterator<AActor> actorItr(GetWorld()); actorItr; ++actorItr)
+    {
+        IndexEntity(*actorItr);
+    }
+    bIndexBuilt = true;
+}
+
+void URREntityIndexSubsystem::OnActorSpawned(AActor* InActor)
+{
+    // Actors spawned before the first lookup are indexed by BuildIndex
+    if (bIndexBuilt)
+    {
+        IndexEntity(InActor);
+    }
+}
+
+void URREntityIndexSubsystem::OnLevelAddedToWorld(ULevel* InLevel, UWorld* InWorld)
+{
+    if (!bIndexBuilt || (InWorld != GetWorld()) || (InLevel == nullptr))
+    {
+        return;
+    }
+
+    for (AActor* actor : InLevel->Actors)
+    {
+        IndexEntity(actor);
+    }
+}
+
+void URREntityIndexSubsystem::OnEntityDestroyed(AActor* InEntity)
+{
+    RemoveEntity(InEntity);
+}
+
+#if WITH_EDITOR
+void URREntityIndexSubsystem::OnActorLabelChanged(AActor* InActor)
+{
+    // Previous display name is pruned on lookup
+    if (bIndexBuilt && (InActor != nullptr) && (InActor->GetWorld() == GetWorld()))
+    {
+        IndexEntity(InActor);
+    }
+}
+#endif
+
+void URREntityIndexSubsystem::IndexEntity(AActor* InEntity)
+{
+    if (!IsValid(InEntity))
+    {
+        return;
+    }
+
+    InEntity->OnDestroyed.AddUniqueDynamic(this, &URREntityIndexSubsystem::OnEntityDestroyed);
+
+    EntitiesByName.Emplace(InEntity->GetName(), InEntity);
+#if WITH_EDITOR
+    // Keep the first actor with a given display name, as a linear search would
+    const FString displayName = UKismetSystemLibrary::GetDisplayName(InEntity);
+    const TWeakObjectPtr<AActor>* displayNameEntity = EntitiesByDisplayName.Find(displayName);
+    if ((displayNameEntity == nullptr) || !displayNameEntity->IsValid())
+    {
+        EntitiesByDisplayName.Emplace(displayName, InEntity);
+    }
+#endif
+    for (const FName& tag : InEntity->Tags)
+    {
+        EntitiesByTag.FindOrAdd(tag).Emplace(InEntity);
+    }
+}
+
+void URREntityIndexSubsystem::RemoveEntity(AActor* InEntity)
+{
+    if (InEntity == nullptr)
+    {
+        return;
+    }
+
+    const FString name = InEntity->GetName();
+    if (const TWeakObjectPtr<AActor>* entity = EntitiesByName.Find(name))
+    {
+        if (entity->Get(true) == InEntity)
+        {
+            EntitiesByName.Remove(name);
+        }
+    }
+#if WITH_EDITOR
+    const FString displayName = UKismetSystemLibrary::GetDisplayName(InEntity);
+    if (const TWeakObjectPtr<AActor>* entity = EntitiesByDisplayName.Find(displayName))
+    {
+        if (entity->Get(true) == InEntity)
+        {
+            EntitiesByDisplayName.Remove(displayName);
+        }
+    }
+#endif
+    for (const FName& tag : InEntity->Tags)
+    {
+        if (TSet<TWeakObjectPtr<AActor>>* entities = EntitiesByTag.Find(tag))
+        {
+            entities->Remove(InEntity);
+        }
+    }
+}
+
+void URREntityIndexSubsystem::RenameEntity(AActor* InEntity, const FString& InNewName)
+{
+    if (InEntity == nullptr)
+    {
+        return;
+    }
+
+    URREntityIndexSubsystem* entityIndex = Get(InEntity->GetWorld());
+    if (entityIndex)
+    {
+        entityIndex->RemoveEntity(InEntity);
+    }
+    InEntity->Rename(*InNewName);
+#if WITH_EDITOR
+    InEntity->SetActorLabel(InNewName);
+#endif
+    if (entityIndex && entityIndex->bIndexBuilt)
+    {
+        entityIndex->IndexEntity(InEntity);
+    }
+}
+
+AActor* URREntityIndexSubsystem::FindEntityByName(const FString& InName, const ESearchCase::Type InCaseType)
+{
+    BuildIndex();
+
+    // FString keys are compared ignoring case, and actor names are unique ignoring case
+    auto findEntity = [&InName, InCaseType](TMap<FString, TWeakObjectPtr<AActor>>& InEntities,
+                                             TFunctionRef<FString(const AActor*)> InGetName) -> AActor*
+    {
+        const TWeakObjectPtr<AActor>* entityPtr = InEntities.Find(InName);
+        if (entityPtr == nullptr)
+        {
+            return nullptr;
+        }
+        AActor* entity = entityPtr->Get();
+        if (entity == nullptr)
+        {
+            InEntities.Remove(InName);
+            return nullptr;
+        }
+        const FString name = InGetName(entity);
+        if (!name.Equals(InName, ESearchCase::IgnoreCase))
+        {
+            // Renamed since it has been indexed
+            InEntities.Remove(InName);
+            return nullptr;
+        }
+        return name.Equals(InName, InCaseType) ? entity : nullptr;
+    };
+
+    AActor* entity = findEntity(EntitiesByName, [](const AActor* InEntity) { return InEntity->GetName(); });
+#if WITH_EDITOR
+    if (entity == nullptr)
+    {
+        entity = findEntity(EntitiesByDisplayName,
+                            [](const AActor* InEntity) { return UKismetSystemLibrary::GetDisplayName(InEntity); });
+    }
+#endif
+    return entity;
+}
+
+void URREntityIndexSubsystem::GetEntitiesWithTag(const FName& InTag, TArray<AActor*>& OutEntities)
+{
+    BuildIndex();
+
+    OutEntities.Reset();
+    TSet<TWeakObjectPtr<AActor>>* entities = EntitiesByTag.Find(InTag);
+    if (entities == nullptr)
+    {
+        return;
+    }
+
+    for (auto it = entities->CreateIterator(); it; ++it)
+    {
+        AActor* entity = it->Get();
+        if ((entity == nullptr) || !entity->ActorHasTag(InTag))
+        {
+            it.RemoveCurrent();
+            continue;
+        }
+        OutEntities.Emplace(entity);
+    }
+}
@@ -0,0 +1,490 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+#include "Core/RRImageUtils.h"
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS && PLATFORM_CPU_X86_FAMILY
+#if (defined(PLATFORM_ALWAYS_HAS_AVX_2) && PLATFORM_ALWAYS_HAS_AVX_2) || defined(__AVX2__)
+#define RR_IMAGE_SIMD_AVX2 1
+#endif
+#if (defined(PLATFORM_ALWAYS_HAS_SSE4_1) && PLATFORM_ALWAYS_HAS_SSE4_1) || defined(__SSSE3__)
+#define RR_IMAGE_SIMD_SSSE3 1
+#endif
+#endif
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS && PLATFORM_CPU_X86_FAMILY
+#define RR_IMAGE_SIMD_SSE2 1
+#else
+#define RR_IMAGE_SIMD_SSE2 0
+#endif
+
+#ifndef RR_IMAGE_SIMD_AVX2
+#define RR_IMAGE_SIMD_AVX2 0
+#endif
+#ifndef RR_IMAGE_SIMD_SSSE3
+#define RR_IMAGE_SIMD_SSSE3 0
+#endif
+
+#if RR_IMAGE_SIMD_AVX2 || RR_IMAGE_SIMD_SSSE3 || RR_IMAGE_SIMD_SSE2
+#include <immintrin.h>
+#endif
+
+// std
+#include <limits>
+
+namespace
+{
+// FColor is stored as B, G, R, A bytes
+constexpr int32 BGRA_B = 0;
+constexpr int32 BGRA_G = 1;
+constexpr int32 BGRA_R = 2;
+
+// Mono weights, summing to 128
+constexpr int32 MONO_WEIGHT_B = 15;
+constexpr int32 MONO_WEIGHT_G = 75;
+constexpr int32 MONO_WEIGHT_R = 38;
+
+// Scene depth is in cm
+constexpr float CM_TO_M = 0.01f;
+constexpr float CM_TO_MM = 10.f;
+constexpr float MAX_DEPTH_MM = 65535.f;
+
+constexpr ERRImageEncoding COLOR_ENCODINGS[] = {ERRImageEncoding::RGB8,
+                                                ERRImageEncoding::BGR8,
+                                                ERRImageEncoding::BGRA8,
+                                                ERRImageEncoding::MONO8};
+constexpr ERRImageEncoding DEPTH_ENCODINGS[] = {ERRImageEncoding::DEPTH_32FC1, ERRImageEncoding::DEPTH_16UC1};
+
+FORCEINLINE uint8 GetMono(const uint8* InBGRA)
+{
+    return static_cast<uint8>(
+        (MONO_WEIGHT_R * InBGRA[BGRA_R] + MONO_WEIGHT_G * InBGRA[BGRA_G] + MONO_WEIGHT_B * InBGRA[BGRA_B] + 64) >> 7);
+}
+
+/**
+ * @brief Convert pixels [InStartIndex, InNumPixels) with scalar code.
+ */
+void ConvertBGRAScalarRange(const uint8* InSrc,
+                            const int32 InStartIndex,
+                            const int32 InNumPixels,
+                            const ERRImageEncoding InEncoding,
+                            uint8* OutDst)
+{
+    switch (InEncoding)
+    {
+        case ERRImageEncoding::RGB8:
+            for (int32 i = InStartIndex; i < InNumPixels; ++i)
+            {
+                OutDst[i * 3 + 0] = InSrc[i * 4 + BGRA_R];
+                OutDst[i * 3 + 1] = InSrc[i * 4 + BGRA_G];
+                OutDst[i * 3 + 2] = InSrc[i * 4 + BGRA_B];
+            }
+            break;
+
+        case ERRImageEncoding::BGR8:
+            for (int32 i = InStartIndex; i < InNumPixels; ++i)
+            {
+                OutDst[i * 3 + 0] = InSrc[i * 4 + BGRA_B];
+                OutDst[i * 3 + 1] = InSrc[i * 4 + BGRA_G];
+                OutDst[i * 3 + 2] = InSrc[i * 4 + BGRA_R];
+            }
+            break;
+
+        case ERRImageEncoding::BGRA8:
+            FMemory::Memcpy(OutDst + InStartIndex * 4, InSrc + InStartIndex * 4, (InNumPixels - InStartIndex) * 4);
+            break;
+
+        case ERRImageEncoding::MONO8:
+            for (int32 i = InStartIndex; i < InNumPixels; ++i)
+            {
+                OutDst[i] = GetMono(InSrc + i * 4);
+            }
+            break;
+
+        default:
+            checkNoEntry();
+            break;
+    }
+}
+
+#if RR_IMAGE_SIMD_AVX2
+/**
+ * @brief Drop alpha and reorder channels with given per lane shuffle mask, 8 pixels per iteration.
+ * @return int32 Number of converted pixels
+ */
+int32 ConvertBGRATo3ChannelsAVX2(const uint8* InSrc, const int32 InNumPixels, const __m256i InMask, uint8* OutDst)
+{
+    // Each lane has 12 valid bytes after shuffle, which are made contiguous by moving dwords across lanes
+    const __m256i compactIndices = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+    int32 i = 0;
+    for (; i + 8 <= InNumPixels; i += 8)
+    {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(InSrc + i * 4));
+        const __m256i shuffled = _mm256_shuffle_epi8(pixels, InMask);
+        const __m256i packed = _mm256_permutevar8x32_epi32(shuffled, compactIndices);
+        uint8* dst = OutDst + i * 3;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(packed));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 16), _mm256_extracti128_si256(packed, 1));
+    }
+    return i;
+}
+
+/**
+ * @brief Compute mono, 32 pixels per iteration.
+ * @return int32 Number of converted pixels
+ */
+int32 ConvertBGRAToMonoAVX2(const uint8* InSrc, const int32 InNumPixels, uint8* OutDst)
+{
+    const __m256i weights = _mm256_set1_epi32(MONO_WEIGHT_B | (MONO_WEIGHT_G << 8) | (MONO_WEIGHT_R << 16));
+    const __m256i rounding = _mm256_set1_epi16(64);
+    // hadd and packus work per lane, thus 4 pixel groups end up interleaved between lanes
+    const __m256i orderIndices = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int32 i = 0;
+    for (; i + 32 <= InNumPixels; i += 32)
+    {
+        const __m256i* src = reinterpret_cast<const __m256i*>(InSrc + i * 4);
+        const __m256i m0 = _mm256_maddubs_epi16(_mm256_loadu_si256(src), weights);
+        const __m256i m1 = _mm256_maddubs_epi16(_mm256_loadu_si256(src + 1), weights);
+        const __m256i m2 = _mm256_maddubs_epi16(_mm256_loadu_si256(src + 2), weights);
+        const __m256i m3 = _mm256_maddubs_epi16(_mm256_loadu_si256(src + 3), weights);
+        const __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_hadd_epi16(m0, m1), rounding), 7);
+        const __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_hadd_epi16(m2, m3), rounding), 7);
+        const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lo, hi), orderIndices);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(OutDst + i), packed);
+    }
+    return i;
+}
+#elif RR_IMAGE_SIMD_SSSE3
+/**
+ * @brief Drop alpha and reorder channels with given shuffle mask, 16 pixels per iteration.
+ * @return int32 Number of converted pixels
+ */
+int32 ConvertBGRATo3ChannelsSSSE3(const uint8* InSrc, const int32 InNumPixels, const __m128i InMask, uint8* OutDst)
+{
+    int32 i = 0;
+    for (; i + 16 <= InNumPixels; i += 16)
+    {
+        const __m128i* src = reinterpret_cast<const __m128i*>(InSrc + i * 4);
+        // 12 valid bytes each, upper 4 bytes are zero
+        const __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(src), InMask);
+        const __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(src + 1), InMask);
+        const __m128i c = _mm_shuffle_epi8(_mm_loadu_si128(src + 2), InMask);
+        const __m128i d = _mm_shuffle_epi8(_mm_loadu_si128(src + 3), InMask);
+        __m128i* dst = reinterpret_cast<__m128i*>(OutDst + i * 3);
+        _mm_storeu_si128(dst, _mm_or_si128(a, _mm_slli_si128(b, 12)));
+        _mm_storeu_si128(dst + 1, _mm_or_si128(_mm_srli_si128(b, 4), _mm_slli_si128(c, 8)));
+        _mm_storeu_si128(dst + 2, _mm_or_si128(_mm_srli_si128(c, 8), _mm_slli_si128(d, 4)));
+    }
+    return i;
+}
+
+/**
+ * @brief Compute mono, 16 pixels per iteration.
+ * @return int32 Number of converted pixels
+ */
+int32 ConvertBGRAToMonoSSSE3(const uint8* InSrc, const int32 InNumPixels, uint8* OutDst)
+{
+    const __m128i weights = _mm_set1_epi32(MONO_WEIGHT_B | (MONO_WEIGHT_G << 8) | (MONO_WEIGHT_R << 16));
+    const __m128i rounding = _mm_set1_epi16(64);
+    int32 i = 0;
+    for (; i + 16 <= InNumPixels; i += 16)
+    {
+        const __m128i* src = reinterpret_cast<const __m128i*>(InSrc + i * 4);
+        const __m128i m0 = _mm_maddubs_epi16(_mm_loadu_si128(src), weights);
+        const __m128i m1 = _mm_maddubs_epi16(_mm_loadu_si128(src + 1), weights);
+        const __m128i m2 = _mm_maddubs_epi16(_mm_loadu_si128(src + 2), weights);
+        const __m128i m3 = _mm_maddubs_epi16(_mm_loadu_si128(src + 3), weights);
+        const __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_hadd_epi16(m0, m1), rounding), 7);
+        const __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_hadd_epi16(m2, m3), rounding), 7);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(OutDst + i), _mm_packus_epi16(lo, hi));
+    }
+    return i;
+}
+#endif
+
+/**
+ * @brief Convert depth of pixels [InStartIndex, InNumPixels) with scalar code.
+ * InMinDepth should not be negative.
+ */
+void ConvertDepthScalarRange(const FLinearColor* InPixels,
+                             const int32 InStartIndex,
+                             const int32 InNumPixels,
+                             const ERRImageEncoding InEncoding,
+                             const float InMinDepth,
+                             const float InMaxDepth,
+                             uint8* OutDst)
+{
+    switch (InEncoding)
+    {
+        case ERRImageEncoding::DEPTH_32FC1:
+        {
+            float* dst = reinterpret_cast<float*>(OutDst);
+            for (int32 i = InStartIndex; i < InNumPixels; ++i)
+            {
+                const float depth = InPixels[i].R * CM_TO_M;
+                // NaN depth fails comparisons as well
+                dst[i] = (depth >= InMinDepth && depth <= InMaxDepth) ? depth : std::numeric_limits<float>::quiet_NaN();
+            }
+            break;
+        }
+
+        case ERRImageEncoding::DEPTH_16UC1:
+        {
+            uint16* dst = reinterpret_cast<uint16*>(OutDst);
+            for (int32 i = InStartIndex; i < InNumPixels; ++i)
+            {
+                const float depth = InPixels[i].R * CM_TO_M;
+                const float depthMM = InPixels[i].R * CM_TO_MM;
+                const bool bValid = (depth >= InMinDepth && depth <= InMaxDepth && depthMM <= MAX_DEPTH_MM);
+                dst[i] = bValid ? static_cast<uint16>(depthMM + 0.5f) : 0;
+            }
+            break;
+        }
+
+        default:
+            checkNoEntry();
+            break;
+    }
+}
+
+#if RR_IMAGE_SIMD_SSE2
+/**
+ * @brief Gather R channel of 4 pixels.
+ */
+FORCEINLINE __m128 LoadDepthSSE2(const FLinearColor* InPixels)
+{
+    const float* src = reinterpret_cast<const float*>(InPixels);
+    const __m128 rg01 = _mm_unpacklo_ps(_mm_loadu_ps(src), _mm_loadu_ps(src + 4));
+    const __m128 rg23 = _mm_unpacklo_ps(_mm_loadu_ps(src + 8), _mm_loadu_ps(src + 12));
+    return _mm_movelh_ps(rg01, rg23);
+}
+
+/**
+ * @brief Convert depth into 32FC1, 4 pixels per iteration.
+ * @return int32 Number of converted pixels
+ */
+int32 ConvertDepthTo32FSSE2(const FLinearColor* InPixels,
+                            const int32 InNumPixels,
+                            const float InMinDepth,
+                            const float InMaxDepth,
+                            float* OutDst)
+{
+    const __m128 cmToM = _mm_set1_ps(CM_TO_M);
+    const __m128 minDepth = _mm_set1_ps(InMinDepth);
+    const __m128 maxDepth = _mm_set1_ps(InMaxDepth);
+    const __m128 invalid = _mm_set1_ps(std::numeric_limits<float>::quiet_NaN());
+    int32 i = 0;
+    for (; i + 4 <= InNumPixels; i += 4)
+    {
+        const __m128 depth = _mm_mul_ps(LoadDepthSSE2(InPixels + i), cmToM);
+        const __m128 valid = _mm_and_ps(_mm_cmpge_ps(depth, minDepth), _mm_cmple_ps(depth, maxDepth));
+        _mm_storeu_ps(OutDst + i, _mm_or_ps(_mm_and_ps(valid, depth), _mm_andnot_ps(valid, invalid)));
+    }
+    return i;
+}
+
+/**
+ * @brief Convert depth of 4 pixels into [mm] as int32, 0 if invalid.
+ */
+FORCEINLINE __m128i GetDepthMMSSE2(const FLinearColor* InPixels, const __m128 InMinDepth, const __m128 InMaxDepth)
+{
+    const __m128 rawDepth = LoadDepthSSE2(InPixels);
+    const __m128 depth = _mm_mul_ps(rawDepth, _mm_set1_ps(CM_TO_M));
+    const __m128 depthMM = _mm_mul_ps(rawDepth, _mm_set1_ps(CM_TO_MM));
+    const __m128 valid = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(depth, InMinDepth), _mm_cmple_ps(depth, InMaxDepth)),
+                                    _mm_cmple_ps(depthMM, _mm_set1_ps(MAX_DEPTH_MM)));
+    const __m128i rounded = _mm_cvttps_epi32(_mm_add_ps(depthMM, _mm_set1_ps(0.5f)));
+    return _mm_and_si128(_mm_castps_si128(valid), rounded);
+}
+
+/**
+ * @brief Convert depth into 16UC1, 8 pixels per iteration.
+ * @return int32 Number of converted pixels
+ */
+int32 ConvertDepthTo16USSE2(const FLinearColor* InPixels,
+                            const int32 InNumPixels,
+                            const float InMinDepth,
+                            const float InMaxDepth,
+                            uint16* OutDst)
+{
+    const __m128 minDepth = _mm_set1_ps(InMinDepth);
+    const __m128 maxDepth = _mm_set1_ps(InMaxDepth);
+    // SSE2 only has signed saturating pack, thus values are offset into int16 range and back
+    const __m128i offset32 = _mm_set1_epi32(0x8000);
+    const __m128i offset16 = _mm_set1_epi16(static_cast<int16>(0x8000));
+    int32 i = 0;
+    for (; i + 8 <= InNumPixels; i += 8)
+    {
+        const __m128i lo = _mm_sub_epi32(GetDepthMMSSE2(InPixels + i, minDepth, maxDepth), offset32);
+        const __m128i hi = _mm_sub_epi32(GetDepthMMSSE2(InPixels + i + 4, minDepth, maxDepth), offset32);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(OutDst + i), _mm_xor_si128(_mm_packs_epi32(lo, hi), offset16));
+    }
+    return i;
+}
+#endif
+}    // namespace
+
+bool URRImageUtils::GetImageEncoding(const FString& InEncoding, ERRImageEncoding& OutEncoding)
+{
+    for (const ERRImageEncoding encoding : COLOR_ENCODINGS)
+    {
+        if (InEncoding.Equals(GetImageEncodingName(encoding)))
+        {
+            OutEncoding = encoding;
+            return true;
+        }
+    }
+    for (const ERRImageEncoding encoding : DEPTH_ENCODINGS)
+    {
+        if (InEncoding.Equals(GetImageEncodingName(encoding)))
+        {
+            OutEncoding = encoding;
+            return true;
+        }
+    }
+    return false;
+}
+
+FString URRImageUtils::GetImageEncodingName(const ERRImageEncoding InEncoding)
+{
+    switch (InEncoding)
+    {
+        case ERRImageEncoding::RGB8:
+            return TEXT("rgb8");
+        case ERRImageEncoding::BGR8:
+            return TEXT("bgr8");
+        case ERRImageEncoding::BGRA8:
+            return TEXT("bgra8");
+        case ERRImageEncoding::MONO8:
+            return TEXT("mono8");
+        case ERRImageEncoding::DEPTH_32FC1:
+            return TEXT("32FC1");
+        case ERRImageEncoding::DEPTH_16UC1:
+            return TEXT("16UC1");
+        default:
+            checkNoEntry();
+            return FString();
+    }
+}
+
+int32 URRImageUtils::GetBytesPerPixel(const ERRImageEncoding InEncoding)
+{
+    switch (InEncoding)
+    {
+        case ERRImageEncoding::RGB8:
+        case ERRImageEncoding::BGR8:
+            return 3;
+        case ERRImageEncoding::BGRA8:
+        case ERRImageEncoding::DEPTH_32FC1:
+            return 4;
+        case ERRImageEncoding::DEPTH_16UC1:
+            return 2;
+        case ERRImageEncoding::MONO8:
+            return 1;
+        default:
+            checkNoEntry();
+            return 0;
+    }
+}
+
+bool URRImageUtils::IsDepthEncoding(const ERRImageEncoding InEncoding)
+{
+    return (ERRImageEncoding::DEPTH_32FC1 == InEncoding) || (ERRImageEncoding::DEPTH_16UC1 == InEncoding);
+}
+
+void URRImageUtils::ConvertBGRA(const FColor* InPixels,
+                                const int32 InNumPixels,
+                                const ERRImageEncoding InEncoding,
+                                uint8* OutData)
+{
+    const uint8* src = reinterpret_cast<const uint8*>(InPixels);
+    int32 nConverted = 0;
+#if RR_IMAGE_SIMD_AVX2
+    switch (InEncoding)
+    {
+        case ERRImageEncoding::RGB8:
+            nConverted = ConvertBGRATo3ChannelsAVX2(
+                src,
+                InNumPixels,
+                _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1),
+                OutData);
+            break;
+        case ERRImageEncoding::BGR8:
+            nConverted = ConvertBGRATo3ChannelsAVX2(
+                src,
+                InNumPixels,
+                _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1),
+                OutData);
+            break;
+        case ERRImageEncoding::MONO8:
+            nConverted = ConvertBGRAToMonoAVX2(src, InNumPixels, OutData);
+            break;
+        default:
+            break;
+    }
+#elif RR_IMAGE_SIMD_SSSE3
+    switch (InEncoding)
+    {
+        case ERRImageEncoding::RGB8:
+            nConverted = ConvertBGRATo3ChannelsSSSE3(
+                src, InNumPixels, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1), OutData);
+            break;
+        case ERRImageEncoding::BGR8:
+            nConverted = ConvertBGRATo3ChannelsSSSE3(
+                src, InNumPixels, _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1), OutData);
+            break;
+        case ERRImageEncoding::MONO8:
+            nConverted = ConvertBGRAToMonoSSSE3(src, InNumPixels, OutData);
+            break;
+        default:
+            break;
+    }
+#endif
+    // Remaining pixels, or all of them for passthrough and without SIMD
+    ConvertBGRAScalarRange(src, nConverted, InNumPixels, InEncoding, OutData);
+}
+
+void URRImageUtils::ConvertBGRAScalar(const FColor* InPixels,
+                                      const int32 InNumPixels,
+                                      const ERRImageEncoding InEncoding,
+                                      uint8* OutData)
+{
+    ConvertBGRAScalarRange(reinterpret_cast<const uint8*>(InPixels), 0, InNumPixels, InEncoding, OutData);
+}
+
+void URRImageUtils::ConvertDepth(const FLinearColor* InPixels,
+                                 const int32 InNumPixels,
+                                 const ERRImageEncoding InEncoding,
+                                 const float InMinDepth,
+                                 const float InMaxDepth,
+                                 uint8* OutData)
+{
+    const float minDepth = FMath::Max(InMinDepth, 0.f);
+    int32 nConverted = 0;
+#if RR_IMAGE_SIMD_SSE2
+    switch (InEncoding)
+    {
+        case ERRImageEncoding::DEPTH_32FC1:
+            nConverted = ConvertDepthTo32FSSE2(InPixels, InNumPixels, minDepth, InMaxDepth, reinterpret_cast<float*>(OutData));
+            break;
+        case ERRImageEncoding::DEPTH_16UC1:
+            nConverted = ConvertDepthTo16USSE2(InPixels, InNumPixels, minDepth, InMaxDepth, reinterpret_cast<uint16*>(OutData));
+            break;
+        default:
+            break;
+    }
+#endif
+    // Remaining pixels, or all of them without SIMD
+    ConvertDepthScalarRange(InPixels, nConverted, InNumPixels, InEncoding, minDepth, InMaxDepth, OutData);
+}
+
+void URRImageUtils::ConvertDepthScalar(const FLinearColor* InPixels,
+                                       const int32 InNumPixels,
+                                       const ERRImageEncoding InEncoding,
+                                       const float InMinDepth,
+                                       const float InMaxDepth,
+                                       uint8* OutData)
+{
+    ConvertDepthScalarRange(InPixels, 0, InNumPixels, InEncoding, FMath::Max(InMinDepth, 0.f), InMaxDepth, OutData);
+}
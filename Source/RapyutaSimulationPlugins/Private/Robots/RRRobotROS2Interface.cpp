@@ -50,6 +50,7 @@ void URRRobotROS2Interface::InitInterfaces()
             OdomComponent =
                 URRUObjectUtils::CreateChildComponent<URRBaseOdomComponent>(Robot, *FString::Printf(TEXT("%sOdom"), *GetName()));
             OdomComponent->bPublishOdomTf = bPublishOdomTf;
+            OdomComponent->bAggregateOdomTf = bAggregateOdomTf;
             OdomComponent->PublicationFrequencyHz = OdomPublicationFrequencyHz;
             OdomComponent->RootOffset = Robot->RootOffset;
         }
@@ -79,11 +80,13 @@ void URRRobotROS2Interface::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>
     DOREPLIFETIME(URRRobotROS2Interface, OdomComponent);
     DOREPLIFETIME(URRRobotROS2Interface, bPublishOdom);
     DOREPLIFETIME(URRRobotROS2Interface, bPublishOdomTf);
+    DOREPLIFETIME(URRRobotROS2Interface, bAggregateOdomTf);
     DOREPLIFETIME(URRRobotROS2Interface, OdomPublicationFrequencyHz);
     DOREPLIFETIME(URRRobotROS2Interface, CmdVelTopicName);
     DOREPLIFETIME(URRRobotROS2Interface, JointCmdTopicName);
     DOREPLIFETIME(URRRobotROS2Interface, JointStateTopicName);
     DOREPLIFETIME(URRRobotROS2Interface, bWarnAboutMissingLink);
+    DOREPLIFETIME(URRRobotROS2Interface, bSplitStaticJointTf);
 }
 
 void URRRobotROS2Interface::InitROS2NodeParam(AActor* Owner)
@@ -128,6 +131,7 @@ bool URRRobotROS2Interface::InitPublishers()
     {
         JointsTFPublisher = CastChecked<URRROS2TFsPublisher>(RobotROS2Node->CreateLoopPublisherWithClass(
             TEXT("tf"), URRROS2TFsPublisher::StaticClass(), JointTfPublicationFrequencyHz));
+        JointsTFPublisher->bSplitStaticTFs = bSplitStaticJointTf;
 
         for (const auto& joint : Robot->Joints)
         {
@@ -2,46 +2,31 @@
 
 #include "Sensors/RR3DLidarComponent.h"
 
-#include "Msgs/ROS2PointField.h"
+// UE
+#include "Async/ParallelFor.h"
+#include "Kismet/GameplayStatics.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+
+// rclUE
 #include "rclcUtilities.h"
 
+// std
+#include <atomic>
+#include <limits>
+
 URR3DLidarComponent::URR3DLidarComponent()
 {
     TopicName = TEXT("scan");
     MsgClass = UROS2PointCloud2Msg::StaticClass();
 }
-void URR3DLidarComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+
+FRRLidarScanPattern URR3DLidarComponent::GetScanPattern() const
 {
-    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-#if TRACE_ASYNC
-    verify(TraceHandles.Num() == RecordedHits.Num());
-    UWorld* world = GetWorld();
-    for (auto i = 0; i < TraceHandles.Num(); ++i)
-    {
-        FTraceHandle& traceHandle = TraceHandles[i];
-        FHitResult& recordedHit = RecordedHits[i];
-        if (traceHandle._Data.FrameNumber != 0)
-        {
-            FTraceDatum Output;
-            if (world->QueryTraceData(traceHandle, Output))
-            {
-                if (Output.OutHits.Num() > 0)
-                {
-                    traceHandle._Data.FrameNumber = 0;
-                    // We should only be tracing the first hit anyhow
-                    recordedHit = Output.OutHits[0];
-                }
-                else
-                {
-                    traceHandle._Data.FrameNumber = 0;
-                    recordedHit = FHitResult();
-                    recordedHit.TraceStart = Output.Start;
-                    recordedHit.TraceEnd = Output.End;
-                }
-            }
-        }
-    }
-#endif
+    FRRLidarScanPattern scanPattern = Super::GetScanPattern();
+    scanPattern.NChannelsPerScan = NChannelsPerScan;
+    scanPattern.StartVerticalAngle = StartVerticalAngle;
+    scanPattern.FOVVertical = FOVVertical;
+    return scanPattern;
 }
 
 void URR3DLidarComponent::Run()
@@ -61,6 +46,9 @@ void URR3DLidarComponent::Run()
 
 void URR3DLidarComponent::SensorUpdate()
 {
+    FScopedGameThreadTime scopedTime(GameThreadTimeAccum);
+    SCOPE_CYCLE_COUNTER(STAT_RRLidarSensorUpdate);
+
     // complex collisions: true
     FCollisionQueryParams TraceParams = FCollisionQueryParams(TEXT("3DLaser_Trace"), true);
     TraceParams.bReturnPhysicalMaterial = true;
@@ -74,166 +62,160 @@ void URR3DLidarComponent::SensorUpdate()
         TraceParams.AddIgnoredActor(GetOwner());
     }
 
-    FVector lidarPos = GetComponentLocation();
-    FRotator lidarRot = GetComponentRotation();
-
-#if TRACE_ASYNC
-    // This is cheesy, but basically if the first trace is in flight we assume they're all waiting and don't do another trace.
-    // This is not good if done on other threads and only works because both timers and actor ticks happen on the game thread.
-    if ((TraceHandles.Num() > 0) && (TraceHandles[0]._Data.FrameNumber == 0))
+    // Traces are issued directly or by the trace scheduler. Async ones are collected in #TickComponent.
+    if (BeginScan())
     {
-        UWorld* world = GetWorld();
-        for (auto i = 0; i < TraceHandles.Num(); ++i)
-        {
-            const int IdxX = i % NSamplesPerScan;
-            const int IdxY = i / NSamplesPerScan;
-            const float HAngle = StartAngle + DHAngle * IdxX;
-            const float VAngle = StartVerticalAngle + DVAngle * IdxY;
+        TraceScan(TraceParams);
+    }
 
-            FRotator laserRot(VAngle, HAngle, 0);
-            FRotator rot = UKismetMathLibrary::ComposeRotators(laserRot, lidarRot);
+    // need to store on a structure associating hits with time?
+    // GetROS2Data needs to get all data since the last Get? or the last within the last time interval?
+}
 
-            FVector startPos = lidarPos + MinRange * UKismetMathLibrary::GetForwardVector(rot);
-            FVector endPos = lidarPos + MaxRange * UKismetMathLibrary::GetForwardVector(rot);
-            // To be considered: += WithNoise * FVector(PositionNoise->Get(),PositionNoise->Get(),PositionNoise->Get());
+FCollisionQueryParams URR3DLidarComponent::GetVisibleTraceParams() const
+{
+    // complex collisions: true
+    FCollisionQueryParams TraceParams = FCollisionQueryParams(TEXT("3DLaser_Trace"), true, GetOwner());
+    TraceParams.bReturnPhysicalMaterial = true;
+    // TraceParams.bIgnoreTouches = true;
+    TraceParams.bTraceComplex = true;
+    TraceParams.bReturnFaceIndex = true;
 
-            TraceHandles[i] = world->AsyncLineTraceByChannel(EAsyncTraceType::Single,
-                                                             startPos,
-                                                             endPos,
-                                                             TraceCollisionChannel,
-                                                             TraceParams,
-                                                             FCollisionResponseParams::DefaultResponseParam,
-                                                             nullptr);
-        }
+    if (bIgnoreSelf)
+    {
+        TraceParams.AddIgnoredActor(GetOwner());
     }
-#else
-    ParallelFor(
-        RecordedHits.Num(),
-        [this, &TraceParams, &lidarPos, &lidarRot](int32 Index)
-        {
-            const int IdxX = Index % NSamplesPerScan;
-            const int IdxY = Index / NSamplesPerScan;
-            const float HAngle = StartAngle + DHAngle * IdxX;
-            const float VAngle = StartVerticalAngle + DVAngle * IdxY;
+    return TraceParams;
+}
 
-            FRotator laserRot(VAngle, HAngle, 0);
-            FRotator rot = UKismetMathLibrary::ComposeRotators(laserRot, lidarRot);
+bool URR3DLidarComponent::Visible(AActor* TargetActor)
+{
+    if (TargetActor == nullptr)
+    {
+        return false;
+    }
 
-            FVector startPos = lidarPos + MinRange * UKismetMathLibrary::GetForwardVector(rot);
-            FVector endPos = lidarPos + MaxRange * UKismetMathLibrary::GetForwardVector(rot);
-            // + WithNoise *  FVector(PositionNoise->Get(),PositionNoise->Get(),PositionNoise->Get());
+    const float scanAge = UGameplayStatics::GetTimeSeconds(GetWorld()) - TimeOfLastScan;
+    if ((RecordedHits.Num() > 0) && (TimeOfLastScan > 0.f) && (scanAge <= VisibleStalenessTolerance))
+    {
+        return RecordedHits.ContainsByPredicate([TargetActor](const FHitResult& InHit)
+                                                { return InHit.GetActor() == TargetActor; });
+    }
+    return VisibleInCone(TargetActor);
+}
 
-            GetWorld()->LineTraceSingleByChannel(RecordedHits[Index],
-                                                 startPos,
-                                                 endPos,
-                                                 TraceCollisionChannel,
-                                                 TraceParams,
-                                                 FCollisionResponseParams::DefaultResponseParam);
-        },
-        false);
-#endif
+bool URR3DLidarComponent::VisibleInCone(AActor* TargetActor)
+{
+    if (TargetActor == nullptr)
+    {
+        return false;
+    }
 
-    if (BWithNoise)
+    const FRRLidarScanPattern scanPattern = GetScanPattern();
+    if ((scanPattern != CachedScanPattern) ||
+        (LocalRayDirections.Num() != scanPattern.NSamplesPerScan * scanPattern.NChannelsPerScan))
     {
-        // this approach to noise is different from the above:
-        // noise on the linetrace input means that the further the hit, the larger the error, while here the error is independent
-        // from distance
-        ParallelFor(
-            RecordedHits.Num(),
-            [this, &TraceParams, &lidarPos, &lidarRot](int32 Index)
-            {
-                RecordedHits[Index].ImpactPoint += FVector(PositionNoise->Get(), PositionNoise->Get(), PositionNoise->Get());
-                RecordedHits[Index].TraceEnd += FVector(PositionNoise->Get(), PositionNoise->Get(), PositionNoise->Get());
-            },
-            false);
+        BuildLocalRayDirections(scanPattern);
+    }
+    const int32 nSamples = CachedScanPattern.NSamplesPerScan;
+    const int32 nChannels = CachedScanPattern.NChannelsPerScan;
+    if ((nSamples <= 0) || (nChannels <= 0))
+    {
+        return false;
     }
 
-    TimeOfLastScan = UGameplayStatics::GetTimeSeconds(GetWorld());
-    Dt = 1.f / static_cast<float>(PublicationFrequencyHz);
+    // Cone from the sensor to the bounding sphere of the target, in sensor frame
+    FVector boundsOrigin, boundsExtent;
+    TargetActor->GetActorBounds(false, boundsOrigin, boundsExtent);
+    const FTransform sensorTransform(GetComponentQuat(), GetComponentLocation(), FVector::OneVector);
+    const FVector toTarget = sensorTransform.InverseTransformVectorNoScale(boundsOrigin - sensorTransform.GetLocation());
+    const double targetDistance = toTarget.Size();
+    const double targetRadius = boundsExtent.Size();
+    if (targetDistance - targetRadius > MaxRange)
+    {
+        return false;
+    }
 
-    // need to store on a structure associating hits with time?
-    // GetROS2Data needs to get all data since the last Get? or the last within the last time interval?
+    // Ray index window which covers the cone. Whole scan if the sensor is inside the sphere.
+    const float dHAngle = CachedScanPattern.FOVHorizontal / static_cast<float>(nSamples);
+    const float dVAngle = CachedScanPattern.FOVVertical / static_cast<float>(nChannels);
+    const bool bInsideBounds = (targetDistance <= targetRadius);
+    const FVector coneDir = bInsideBounds ? FVector::ForwardVector : toTarget / targetDistance;
+    const double coneHalfAngle = bInsideBounds ? PI : FMath::Asin(targetRadius / targetDistance);
+    const double coneCos = FMath::Cos(coneHalfAngle);
+    const double conePitch = FMath::Asin(FMath::Clamp(coneDir.Z, -1.0, 1.0));
+    const double coneYaw = FMath::Atan2(coneDir.Y, coneDir.X);
+
+    const double pitchMin = FMath::RadiansToDegrees(conePitch - coneHalfAngle);
+    const double pitchMax = FMath::RadiansToDegrees(conePitch + coneHalfAngle);
+    const int32 idxYMin = FMath::Max(FMath::FloorToInt((pitchMin - CachedScanPattern.StartVerticalAngle) / dVAngle), 0);
+    const int32 idxYMax = FMath::Min(FMath::CeilToInt((pitchMax - CachedScanPattern.StartVerticalAngle) / dVAngle), nChannels - 1);
+
+    // Yaw half width of a cone is asin(sin(half angle) / cos(pitch)), which is unbounded if the cone contains a pole.
+    TArray<int32, TInlineAllocator<2>> idxXMins, idxXMaxs;
+    if (FMath::Abs(conePitch) + coneHalfAngle >= HALF_PI)
+    {
+        idxXMins.Add(0);
+        idxXMaxs.Add(nSamples - 1);
+    }
+    else
+    {
+        const double yawHalfWidth = FMath::RadiansToDegrees(FMath::Asin(FMath::Sin(coneHalfAngle) / FMath::Cos(conePitch)));
+        const double yawMin =
+            FMath::Fmod(FMath::RadiansToDegrees(coneYaw) - yawHalfWidth - CachedScanPattern.StartAngle + 720.0, 360.0);
+        // Window may wrap around 360 degrees, thus check both [yawMin, yawMax] and the same shifted by -360
+        for (const double windowStart : {yawMin, yawMin - 360.0})
+        {
+            idxXMins.Add(FMath::Max(FMath::FloorToInt(windowStart / dHAngle), 0));
+            idxXMaxs.Add(FMath::Min(FMath::CeilToInt((windowStart + 2.0 * yawHalfWidth) / dHAngle), nSamples - 1));
+        }
+    }
 
-    ULineBatchComponent* const LineBatcher = GetWorld()->PersistentLineBatcher;
-    if (LineBatcher != nullptr && bShowLidarRays)
+    TArray<int32> rayIndices;
+    for (int32 idxY = idxYMin; idxY <= idxYMax; ++idxY)
     {
-        for (auto& h : RecordedHits)
+        for (int32 window = 0; window < idxXMins.Num(); ++window)
         {
-            if (h.GetActor() != nullptr)
+            for (int32 idxX = idxXMins[window]; idxX <= idxXMaxs[window]; ++idxX)
             {
-                float Distance = (MinRange * (h.Distance > 0) + h.Distance) * .01f;
-                if (h.PhysMaterial != nullptr)
+                const int32 rayIndex = idxX + idxY * nSamples;
+                if (FVector::DotProduct(LocalRayDirections[rayIndex], coneDir) >= coneCos)
                 {
-                    // retroreflective material
-                    if (h.PhysMaterial->SurfaceType == EPhysicalSurface::SurfaceType1)
-                    {
-                        // UE_LOG_WITH_INFO(LogTemp, Warning, TEXT("retroreflective surface type hit"));
-                        // LineBatcher->DrawLine(h.TraceStart, h.ImpactPoint, ColorReflected, 10, .5, dt);
-                        LineBatcher->DrawPoint(h.ImpactPoint,
-                                               InterpColorFromIntensity(GetIntensityFromDist(IntensityReflective, Distance)),
-                                               5,
-                                               DrawPointDepthIntensity,
-                                               Dt);
-                    }
-                    // non reflective material
-                    else if (h.PhysMaterial->SurfaceType == EPhysicalSurface::SurfaceType_Default)
-                    {
-                        // UE_LOG_WITH_INFO(LogTemp, Warning, TEXT("default surface type hit"));
-                        // LineBatcher->DrawLine(h.TraceStart, h.ImpactPoint, ColorHit, 10, .5, dt);
-                        LineBatcher->DrawPoint(h.ImpactPoint,
-                                               InterpColorFromIntensity(GetIntensityFromDist(IntensityNonReflective, Distance)),
-                                               5,
-                                               DrawPointDepthIntensity,
-                                               Dt);
-                    }
-                    // reflective material
-                    else if (h.PhysMaterial->SurfaceType == EPhysicalSurface::SurfaceType2)
-                    {
-                        FVector HitSurfaceNormal = h.Normal;
-                        FVector RayDirection = h.TraceEnd - h.TraceStart;
-                        RayDirection.Normalize();
-
-                        float NormalAlignment = FVector::DotProduct(HitSurfaceNormal, -RayDirection);
-                        NormalAlignment *= NormalAlignment;
-                        NormalAlignment *= NormalAlignment;
-                        NormalAlignment *= NormalAlignment;
-                        NormalAlignment *= NormalAlignment;
-                        NormalAlignment *= NormalAlignment;    // pow 32
-                        // LineBatcher->DrawLine(h.TraceStart, h.ImpactPoint, FLinearColor::LerpUsingHSV(ColorHit, ColorReflected,
-                        // NormalAlignment), 10, .5, dt); NormalAlignment =
-                        // (NormalAlignment*(IntensityReflective-IntensityNonReflective) + IntensityNonReflective)/IntensityMax;
-                        // LineBatcher->DrawPoint(h.ImpactPoint, InterpolateColor(NormalAlignment), 5, 10, dt);
-                        LineBatcher->DrawPoint(
-                            h.ImpactPoint,
-                            InterpColorFromIntensity(GetIntensityFromDist(
-                                NormalAlignment * (IntensityReflective - IntensityNonReflective) + IntensityNonReflective,
-                                Distance)),
-                            5,
-                            DrawPointDepthIntensity,
-                            Dt);
-                    }
-                }
-                else
-                {
-                    // UE_LOG_WITH_INFO(LogTemp, Warning, TEXT("no physics material"));
-                    // LineBatcher->DrawLine(h.TraceStart, h.ImpactPoint, ColorHit, 10, .5, dt);
-                    LineBatcher->DrawPoint(h.ImpactPoint,
-                                           InterpColorFromIntensity(GetIntensityFromDist(IntensityNonReflective, Distance)),
-                                           5,
-                                           DrawPointDepthIntensity,
-                                           Dt);
+                    rayIndices.Add(rayIndex);
                 }
             }
-            else if (ShowLidarRayMisses)
-            {
-                // LineBatcher->DrawLine(h.TraceStart, h.TraceEnd, ColorMiss, 10, .25, dt);
-                LineBatcher->DrawPoint(h.TraceEnd, ColorMiss, 2.5, DrawPointDepthIntensity, Dt);
-            }
         }
     }
+
+    const FCollisionQueryParams TraceParams = GetVisibleTraceParams();
+    const FVector lidarPos = sensorTransform.GetLocation();
+    const FQuat lidarQuat = sensorTransform.GetRotation();
+    std::atomic<bool> bVisible{false};
+    ParallelFor(FMath::DivideAndRoundUp(rayIndices.Num(), RAY_BATCH_SIZE),
+                [this, &TraceParams, &lidarPos, &lidarQuat, &rayIndices, &bVisible, TargetActor](int32 InBatchIndex)
+                {
+                    const int32 startIndex = InBatchIndex * RAY_BATCH_SIZE;
+                    const int32 endIndex = FMath::Min(startIndex + RAY_BATCH_SIZE, rayIndices.Num());
+                    for (int32 i = startIndex; (i < endIndex) && !bVisible.load(std::memory_order_relaxed); ++i)
+                    {
+                        const FVector rayDir = lidarQuat.RotateVector(LocalRayDirections[rayIndices[i]]);
+                        FHitResult hit;
+                        GetWorld()->LineTraceSingleByChannel(hit,
+                                                             lidarPos + MinRange * rayDir,
+                                                             lidarPos + MaxRange * rayDir,
+                                                             TraceCollisionChannel,
+                                                             TraceParams,
+                                                             FCollisionResponseParams::DefaultResponseParam);
+                        if (hit.GetActor() == TargetActor)
+                        {
+                            bVisible = true;
+                        }
+                    }
+                });
+    return bVisible;
 }
 
-bool URR3DLidarComponent::Visible(AActor* TargetActor)
+bool URR3DLidarComponent::VisibleFullScan(AActor* TargetActor)
 {
     TArray<FHitResult> RecordedVizHits;
     RecordedVizHits.Init(FHitResult(ForceInit), GetTotalScan());
@@ -241,35 +223,18 @@ bool URR3DLidarComponent::Visible(AActor* TargetActor)
     DHAngle = FOVHorizontal / static_cast<float>(NSamplesPerScan);
     DVAngle = FOVVertical / static_cast<float>(NChannelsPerScan);
 
-    // complex collisions: true
-    FCollisionQueryParams TraceParams = FCollisionQueryParams(TEXT("3DLaser_Trace"), true, GetOwner());
-    TraceParams.bReturnPhysicalMaterial = true;
-    // TraceParams.bIgnoreTouches = true;
-    TraceParams.bTraceComplex = true;
-    TraceParams.bReturnFaceIndex = true;
-
-    if (bIgnoreSelf)
-    {
-        TraceParams.AddIgnoredActor(GetOwner());
-    }
-
+    const FCollisionQueryParams TraceParams = GetVisibleTraceParams();
     FVector lidarPos = GetComponentLocation();
-    FRotator lidarRot = GetComponentRotation();
-
+    // Own directions, since #WorldRayDirections may still be used by a scan queued in #URRLidarTraceScheduler
+    TArray<FVector> rayDirections;
+    UpdateRayDirections(rayDirections);
     ParallelFor(
         RecordedVizHits.Num(),
-        [this, &TraceParams, &lidarPos, &lidarRot, &RecordedVizHits](int32 Index)
+        [this, &TraceParams, &lidarPos, &rayDirections, &RecordedVizHits](int32 Index)
         {
-            const int IdxX = Index % NSamplesPerScan;
-            const int IdxY = Index / NSamplesPerScan;
-            const float HAngle = StartAngle + DHAngle * IdxX;
-            const float VAngle = StartVerticalAngle + DVAngle * IdxY;
-
-            FRotator laserRot(VAngle, HAngle, 0);
-            FRotator rot = UKismetMathLibrary::ComposeRotators(laserRot, lidarRot);
-
-            FVector startPos = lidarPos + MinRange * UKismetMathLibrary::GetForwardVector(rot);
-            FVector endPos = lidarPos + MaxRange * UKismetMathLibrary::GetForwardVector(rot);
+            const FVector& rayDir = rayDirections[Index];
+            FVector startPos = lidarPos + MinRange * rayDir;
+            FVector endPos = lidarPos + MaxRange * rayDir;
 
             GetWorld()->LineTraceSingleByChannel(RecordedVizHits[Index],
                                                  startPos,
@@ -290,143 +255,217 @@ bool URR3DLidarComponent::Visible(AActor* TargetActor)
     return false;
 }
 
-FROSPointCloud2 URR3DLidarComponent::GetROS2Data()
+uint32 URR3DLidarComponent::GetPointStep(const ERRLidarPointCloudLayout InLayout)
 {
-    FROSPointCloud2 retValue;
+    switch (InLayout)
+    {
+        case ERRLidarPointCloudLayout::XYZ:
+            return 12;
+        case ERRLidarPointCloudLayout::XYZI:
+            return 16;
+        case ERRLidarPointCloudLayout::FULL:
+        default:
+            // reference
+            // https://github.com/ToyotaResearchInstitute/velodyne_simulator
+            return 22;
+    }
+}
 
-    // time
-    retValue.Header.Stamp = URRConversionUtils::FloatToROSStamp(TimeOfLastScan);
-
-    retValue.Header.FrameId = FrameId;
-
-    // reference
-    // https://github.com/ToyotaResearchInstitute/velodyne_simulator
-    static constexpr uint32_t POINT_STEP = 22;
-    retValue.PointStep = POINT_STEP;
-
-    retValue.bIsBigendian = false;
-
-    retValue.Fields.Init(FROSPointField(), 6);
-    retValue.Fields[0].Name = "x";
-    retValue.Fields[0].Offset = 0;
-    retValue.Fields[0].Datatype = FROSPointField::FLOAT32;
-    retValue.Fields[0].Count = 1;
-    retValue.Fields[1].Name = "y";
-    retValue.Fields[1].Offset = 4;
-    retValue.Fields[1].Datatype = FROSPointField::FLOAT32;
-    retValue.Fields[1].Count = 1;
-    retValue.Fields[2].Name = "z";
-    retValue.Fields[2].Offset = 8;
-    retValue.Fields[2].Datatype = FROSPointField::FLOAT32;
-    retValue.Fields[2].Count = 1;
-    retValue.Fields[3].Name = "intensity";
-    retValue.Fields[3].Offset = 12;
-    retValue.Fields[3].Datatype = FROSPointField::FLOAT32;
-    retValue.Fields[3].Count = 1;
-    retValue.Fields[4].Name = "ring";
-    retValue.Fields[4].Offset = 16;
-    retValue.Fields[4].Datatype = FROSPointField::UINT16;
-    retValue.Fields[4].Count = 1;
-    retValue.Fields[5].Name = "time";
-    retValue.Fields[5].Offset = 18;
-    retValue.Fields[5].Datatype = FROSPointField::FLOAT32;
-    retValue.Fields[5].Count = 1;
-
-    retValue.Data.Init(0, RecordedHits.Num() * POINT_STEP);
-
-    int count = 0;
-    for (auto i = 0; i < NChannelsPerScan; i++)
+void URR3DLidarComponent::SetPointFields(const ERRLidarPointCloudLayout InLayout, TArray<FROSPointField>& OutFields)
+{
+    auto addField = [&OutFields](const TCHAR* InName, const uint32 InOffset, const uint8 InDatatype)
     {
-        for (auto j = 0; j < NSamplesPerScan; j++)
+        FROSPointField& field = OutFields.AddDefaulted_GetRef();
+        field.Name = InName;
+        field.Offset = InOffset;
+        field.Datatype = InDatatype;
+        field.Count = 1;
+    };
+
+    OutFields.Reset();
+    addField(TEXT("x"), 0, FROSPointField::FLOAT32);
+    addField(TEXT("y"), 4, FROSPointField::FLOAT32);
+    addField(TEXT("z"), 8, FROSPointField::FLOAT32);
+    if (InLayout != ERRLidarPointCloudLayout::XYZ)
+    {
+        addField(TEXT("intensity"), 12, FROSPointField::FLOAT32);
+    }
+    if (InLayout == ERRLidarPointCloudLayout::FULL)
+    {
+        addField(TEXT("ring"), 16, FROSPointField::UINT16);
+        addField(TEXT("time"), 18, FROSPointField::FLOAT32);
+    }
+}
+
+void URR3DLidarComponent::SerializePointCloud(const FRRPointCloudSerializeParams& InParams,
+                                              const TArray<FHitResult>& InHits,
+                                              const TArray<float>& InIntensityNoises,
+                                              FROSPointCloud2& OutMsg)
+{
+    const int32 nSamples = InParams.NSamplesPerScan;
+    const int32 nHits = InHits.Num();
+    verify(nHits == nSamples * InParams.NChannelsPerScan);
+
+    const ERRLidarPointCloudLayout layout = InParams.Layout;
+    const uint32 pointStep = GetPointStep(layout);
+    const bool bWithIntensity = (layout != ERRLidarPointCloudLayout::XYZ);
+    const bool bWithRingAndTime = (layout == ERRLidarPointCloudLayout::FULL);
+    const bool bWithIntensityNoises = (InIntensityNoises.Num() == nHits);
+    const bool bOrganized = InParams.bOrganizedCloud;
+
+    // Point step is unique per layout, thus fields are only rebuilt when layout is changed
+    if ((OutMsg.Fields.Num() == 0) || (OutMsg.PointStep != pointStep))
+    {
+        SetPointFields(layout, OutMsg.Fields);
+    }
+    OutMsg.bIsBigendian = false;
+    OutMsg.PointStep = pointStep;
+
+    // 1st pass: count valid hits per batch, to get each batch's output offset
+    const int32 nBatches = FMath::DivideAndRoundUp(nHits, RAY_BATCH_SIZE);
+    TArray<int32> batchOffsets;
+    batchOffsets.SetNumZeroed(nBatches + 1);
+    ParallelFor(nBatches,
+                [&InHits, &batchOffsets, nHits](int32 InBatchIndex)
+                {
+                    const int32 startIndex = InBatchIndex * RAY_BATCH_SIZE;
+                    const int32 endIndex = FMath::Min(startIndex + RAY_BATCH_SIZE, nHits);
+                    int32 nValidHits = 0;
+                    for (int32 i = startIndex; i < endIndex; ++i)
+                    {
+                        nValidHits += (InHits[nHits - 1 - i].PhysMaterial != nullptr);
+                    }
+                    batchOffsets[InBatchIndex + 1] = nValidHits;
+                });
+    for (int32 i = 0; i < nBatches; ++i)
+    {
+        batchOffsets[i + 1] += batchOffsets[i];
+    }
+    const int32 nValidHits = batchOffsets[nBatches];
+    const int32 nPoints = bOrganized ? nHits : nValidHits;
+
+    // Presize once, then workers write into their own range of the buffer
+    OutMsg.Data.SetNumUninitialized(nPoints * pointStep, false);
+    uint8* const data = OutMsg.Data.GetData();
+
+    // 2nd pass: convert and write points
+    const bool bWithColumnTransforms = (InParams.ColumnTransforms.Num() == nSamples);
+    const float timeIncrement = (nSamples > 0) ? InParams.ScanPeriod / static_cast<float>(nSamples) : 0.f;
+    ParallelFor(
+        nBatches,
+        [&, data](int32 InBatchIndex)
         {
-            int index = j + i * NSamplesPerScan;
-            // float Distance = (MinRange * (RecordedHits.Last(index).Distance > 0) + RecordedHits.Last(index).Distance) * .01f;
-            // Distance += BWithNoise * IntensityNoise->Get();
-            FVector3f pos = FVector3f::ZeroVector;
-
-            const float IntensityScale = 1.f + BWithNoise * IntensityNoise->Get();
-            float Intensity = 0.0;
-            if (RecordedHits.Last(index).PhysMaterial != nullptr)
+            const int32 startIndex = InBatchIndex * RAY_BATCH_SIZE;
+            const int32 endIndex = FMath::Min(startIndex + RAY_BATCH_SIZE, nHits);
+            uint8* dst = data + (bOrganized ? startIndex : batchOffsets[InBatchIndex]) * pointStep;
+            for (int32 i = startIndex; i < endIndex; ++i)
             {
-                // retroreflective material
-                if (RecordedHits.Last(index).PhysMaterial->SurfaceType == EPhysicalSurface::SurfaceType1)
+                // Reversed since ROS is right handed
+                const int32 hitIndex = nHits - 1 - i;
+                const FHitResult& hit = InHits[hitIndex];
+                const int32 column = hitIndex % nSamples;
+                FVector3f pos(std::numeric_limits<float>::quiet_NaN());
+                float intensity = 0.f;
+                if (hit.PhysMaterial != nullptr)
                 {
-                    Intensity = IntensityScale * IntensityReflective;
+                    // Convert pose to local coordinate, ROS unit and double -> float
+                    const FTransform& sensorTransform =
+                        bWithColumnTransforms ? InParams.ColumnTransforms[column] : InParams.SensorTransform;
+                    pos = FVector3f(
+                        URRConversionUtils::VectorUEToROS(sensorTransform.InverseTransformPositionNoScale(hit.ImpactPoint)));
+                    if (bWithIntensity)
+                    {
+                        intensity = GetIntensityFromHit(hit, InParams.IntensityNonReflective, InParams.IntensityReflective);
+                        if (bWithIntensityNoises)
+                        {
+                            intensity *= 1.f + InIntensityNoises[hitIndex];
+                        }
+                    }
                 }
-                // non-reflective material
-                else if (RecordedHits.Last(index).PhysMaterial->SurfaceType == EPhysicalSurface::SurfaceType_Default)
+                else if (!bOrganized)
                 {
-                    Intensity = IntensityScale * IntensityNonReflective;
+                    continue;
                 }
-                // reflective material
-                else if (RecordedHits.Last(index).PhysMaterial->SurfaceType == EPhysicalSurface::SurfaceType2)
+
+                FMemory::Memcpy(dst, &pos.X, 4);
+                FMemory::Memcpy(dst + 4, &pos.Y, 4);
+                FMemory::Memcpy(dst + 8, &pos.Z, 4);
+                if (bWithIntensity)
                 {
-                    FVector HitSurfaceNormal = RecordedHits.Last(index).Normal;
-                    FVector RayDirection = RecordedHits.Last(index).TraceEnd - RecordedHits.Last(index).TraceStart;
-                    RayDirection.Normalize();
-
-                    // the dot product for this should always be between 0 and 1
-                    const float UnnormalizedIntensity =
-                        FMath::Clamp(IntensityNonReflective + (IntensityReflective - IntensityNonReflective) *
-                                                                  FVector::DotProduct(HitSurfaceNormal, -RayDirection),
-                                     IntensityNonReflective,
-                                     IntensityReflective);
-                    if ((UnnormalizedIntensity <= IntensityNonReflective) || (UnnormalizedIntensity <= IntensityReflective))
-                    {
-                        UE_LOG_WITH_INFO(LogRapyutaCore, Warning, TEXT("Normalized intensity is outof range. Something is wrong."));
-                    }
-                    Intensity = IntensityScale * UnnormalizedIntensity;
+                    FMemory::Memcpy(dst + 12, &intensity, 4);
                 }
-            }
-            else
-            {
-                Intensity = 0;    // std::numeric_limits<float>::quiet_NaN();
-                if (!bOrganizedCloud)
+                if (bWithRingAndTime)
                 {
-                    continue;
+                    const uint16 ring = static_cast<uint16>(hitIndex / nSamples);
+                    const float time = timeIncrement * column;
+                    FMemory::Memcpy(dst + 16, &ring, 2);
+                    FMemory::Memcpy(dst + 18, &time, 4);
                 }
+                dst += pointStep;
             }
+        });
 
-            // Convert pose to local coordinate, ROS unit and double -> float
-            FVector posInDouble = RecordedHits.Last(index).ImpactPoint;    // + BWithNoise * PositionNoise->Get();
-            posInDouble = URRGeneralUtils::GetRelativeTransform(
-                              FTransform(GetComponentQuat(), GetComponentLocation(), FVector::OneVector), FTransform(posInDouble))
-                              .GetTranslation();
-            posInDouble = URRConversionUtils::VectorUEToROS(posInDouble);
-            pos = FVector3f(posInDouble);
-
-            float time = 0.f;    //temp
-            memcpy(&retValue.Data[count * POINT_STEP], &pos.X, 4);
-            memcpy(&retValue.Data[count * POINT_STEP + 4], &pos.Y, 4);
-            memcpy(&retValue.Data[count * POINT_STEP + 8], &pos.Z, 4);
-            memcpy(&retValue.Data[count * POINT_STEP + 12], &Intensity, 4);
-            memcpy(&retValue.Data[count * POINT_STEP + 16], &j, 2);
-            memcpy(&retValue.Data[count * POINT_STEP + 18], &time, 4);
-
-            count++;
-        }
+    if (bOrganized)
+    {
+        OutMsg.Width = nSamples;
+        OutMsg.Height = InParams.NChannelsPerScan;
+        OutMsg.RowStep = pointStep * nSamples;
+        OutMsg.bIsDense = (nValidHits == nHits);
+    }
+    else
+    {
+        OutMsg.Height = 1;
+        OutMsg.Width = nPoints;
+        OutMsg.RowStep = OutMsg.Data.Num();
+        OutMsg.bIsDense = true;
     }
+}
 
-    if (bOrganizedCloud)
+void URR3DLidarComponent::ProcessScan(FRRLidarScan& InOutScan)
+{
+    Super::ProcessScan(InOutScan);
+
+    if (BWithNoise)
     {
-        retValue.Width = NSamplesPerScan;
-        retValue.Height = NChannelsPerScan;
-        retValue.RowStep = POINT_STEP * NSamplesPerScan;
-        retValue.bIsDense = true;
+        IntensityNoise->Fill(IntensityNoises, InOutScan.Hits.Num());
     }
     else
     {
-        retValue.Data.SetNum((count + 1) * POINT_STEP, true);
-        retValue.Height = 1;
-        retValue.Width = count + 1;
-        retValue.RowStep = retValue.Data.Num();
-        retValue.bIsDense = true;
+        IntensityNoises.Reset();
     }
 
-    return retValue;
+    FRRPointCloudSerializeParams params;
+    params.SensorTransform = InOutScan.SensorTransform;
+    params.ColumnTransforms = InOutScan.ColumnTransforms;
+    params.ScanPeriod = InOutScan.Period;
+    params.NSamplesPerScan = InOutScan.Pattern.NSamplesPerScan;
+    params.NChannelsPerScan = InOutScan.Pattern.NChannelsPerScan;
+    params.bOrganizedCloud = bOrganizedCloud;
+    params.Layout = PointCloudLayout;
+    params.IntensityNonReflective = IntensityNonReflective;
+    params.IntensityReflective = IntensityReflective;
+
+    SerializePointCloud(params, InOutScan.Hits, IntensityNoises, ProcessingPointCloudMsg);
+}
+
+void URR3DLidarComponent::OnScanProcessed()
+{
+    Swap(PointCloudMsg, ProcessingPointCloudMsg);
+
+    // time
+    PointCloudMsg.Header.Stamp = URRConversionUtils::FloatToROSStamp(GetScanStartTime());
+    PointCloudMsg.Header.FrameId = FrameId;
+}
+
+FROSPointCloud2 URR3DLidarComponent::GetROS2Data()
+{
+    return PointCloudMsg;
 }
 
 void URR3DLidarComponent::SetROS2Msg(UROS2GenericMsg* InMessage)
 {
-    CastChecked<UROS2PointCloud2Msg>(InMessage)->SetMsg(GetROS2Data());
+    FScopedGameThreadTime scopedTime(GameThreadTimeAccum);
+    SCOPE_CYCLE_COUNTER(STAT_RRLidarSetROS2Msg);
+    CastChecked<UROS2PointCloud2Msg>(InMessage)->SetMsg(PointCloudMsg);
+    OnScanPublished();
 }
@@ -2,6 +2,22 @@
 
 #include "Sensors/RRBaseLidarComponent.h"
 
+// UE
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Kismet/GameplayStatics.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "UObject/GarbageCollection.h"
+
+// RapyutaSimulationPlugins
+#include "Sensors/RRLidarStaticGeometryCache.h"
+#include "Sensors/RRLidarTraceScheduler.h"
+
+DEFINE_STAT(STAT_RRLidarSensorUpdate);
+DEFINE_STAT(STAT_RRLidarCollectTraces);
+DEFINE_STAT(STAT_RRLidarProcessScan);
+DEFINE_STAT(STAT_RRLidarSetROS2Msg);
+
 URRBaseLidarComponent::URRBaseLidarComponent()
 {
     BWithNoise = true;
@@ -22,6 +38,456 @@ void URRBaseLidarComponent::BeginPlay()
     }
     PositionNoise->Init(PositionalNoiseMean, PositionalNoiseVariance);
     IntensityNoise->Init(IntensityNoiseMean, IntensityNoiseVariance);
+
+    StaticGeometryCache = bUseStaticGeometryCache ? GetWorld()->GetSubsystem<URRLidarStaticGeometryCache>() : nullptr;
+    if (StaticGeometryCache)
+    {
+        StaticGeometryCache->RegisterChannel(TraceCollisionChannel);
+    }
+}
+
+void URRBaseLidarComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (TraceScheduler)
+    {
+        TraceScheduler->UnregisterLidar(this);
+        TraceScheduler = nullptr;
+    }
+    if (ScanProcessingFuture.IsValid())
+    {
+        ScanProcessingFuture.Wait();
+        ScanProcessingFuture.Reset();
+    }
+    if (DebugPointsComponent)
+    {
+        DebugPointsComponent->DestroyComponent();
+        DebugPointsComponent = nullptr;
+    }
+    Super::EndPlay(EndPlayReason);
+}
+
+void URRBaseLidarComponent::Run()
+{
+    TraceScheduler = bUseTraceScheduler ? GetWorld()->GetSubsystem<URRLidarTraceScheduler>() : nullptr;
+    if (TraceScheduler)
+    {
+        GetWorld()->GetTimerManager().ClearTimer(TimerHandle);
+        TraceScheduler->RegisterLidar(this);
+    }
+    else
+    {
+        Super::Run();
+    }
+}
+
+void URRBaseLidarComponent::Stop()
+{
+    if (TraceScheduler)
+    {
+        TraceScheduler->UnregisterLidar(this);
+        TraceScheduler = nullptr;
+    }
+    Super::Stop();
+}
+
+void URRBaseLidarComponent::TickComponent(float DeltaTime,
+                                          enum ELevelTick TickType,
+                                          FActorComponentTickFunction* ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    // Report previous frame's time, which includes timer and publisher callbacks running after this tick
+    GameThreadTime = GameThreadTimeAccum * 1000.0;
+    GameThreadTimeAccum = 0.0;
+    FScopedGameThreadTime scopedTime(GameThreadTimeAccum);
+
+#if TRACE_ASYNC
+    if (bTracing)
+    {
+        SCOPE_CYCLE_COUNTER(STAT_RRLidarCollectTraces);
+        CollectTraces();
+    }
+#endif
+    UpdateScanPipeline();
+}
+
+#if TRACE_ASYNC
+void URRBaseLidarComponent::CollectTraces()
+{
+    verify(TraceHandles.Num() == TracingScan.Hits.Num());
+    UWorld* world = GetWorld();
+    int32 nPendingTraces = 0;
+    for (auto i = 0; i < TraceHandles.Num(); ++i)
+    {
+        FTraceHandle& traceHandle = TraceHandles[i];
+        FHitResult& recordedHit = TracingScan.Hits[i];
+        if (traceHandle._Data.FrameNumber != 0)
+        {
+            FTraceDatum Output;
+            if (world->QueryTraceData(traceHandle, Output))
+            {
+                if (Output.OutHits.Num() > 0)
+                {
+                    traceHandle._Data.FrameNumber = 0;
+                    // We should only be tracing the first hit anyhow
+                    if (bTraceStaticGeometryCache)
+                    {
+                        SetDynamicHit(recordedHit, Output.OutHits[0]);
+                    }
+                    else
+                    {
+                        recordedHit = Output.OutHits[0];
+                    }
+                }
+                else if (bTraceStaticGeometryCache)
+                {
+                    // Keep the static hit, or miss, from the cache
+                    traceHandle._Data.FrameNumber = 0;
+                }
+                else
+                {
+                    traceHandle._Data.FrameNumber = 0;
+                    recordedHit = FHitResult();
+                    recordedHit.TraceStart = Output.Start;
+                    recordedHit.TraceEnd = Output.End;
+                }
+            }
+            else if (!world->IsTraceHandleValid(traceHandle, false))
+            {
+                // Result has expired, e.g. tick was skipped. Treat it as a miss, or keep the static hit from the cache,
+                // instead of waiting forever.
+                traceHandle._Data.FrameNumber = 0;
+                if (!bTraceStaticGeometryCache)
+                {
+                    recordedHit = FHitResult();
+                }
+            }
+            else
+            {
+                ++nPendingTraces;
+            }
+        }
+    }
+
+    if (nPendingTraces == 0)
+    {
+        OnScanTraced();
+    }
+}
+#endif
+
+bool URRBaseLidarComponent::BeginScan()
+{
+    if (bTracing || bScanTraced)
+    {
+        return false;
+    }
+
+    Dt = 1.f / static_cast<float>(PublicationFrequencyHz);
+    UpdateColumnTransforms();
+    UpdateRayDirections(true);
+
+    const int32 nRays = LocalRayDirections.Num();
+    if (TracingScan.Hits.Num() != nRays)
+    {
+        // Scan pattern has been changed since #Run
+        TracingScan.Hits.Init(FHitResult(ForceInit), nRays);
+    }
+#if TRACE_ASYNC
+    if (TraceHandles.Num() != nRays)
+    {
+        TraceHandles.Init(FTraceHandle(), nRays);
+    }
+#endif
+
+    TracingScan.SensorTransform = FTransform(GetComponentQuat(), GetComponentLocation(), FVector::OneVector);
+    TracingScan.Pattern = CachedScanPattern;
+    TracingScan.Time = UGameplayStatics::GetTimeSeconds(GetWorld());
+    TracingScan.Period = Dt;
+    TracingScan.IssueTime = FPlatformTime::Seconds();
+    bTracing = true;
+    return true;
+}
+
+void URRBaseLidarComponent::TraceScan(const FCollisionQueryParams& InTraceParams)
+{
+    FCollisionQueryParams traceParams = InTraceParams;
+    bTraceStaticGeometryCache = (StaticGeometryCache != nullptr);
+    if (bTraceStaticGeometryCache)
+    {
+        StaticGeometryCache->RegisterChannel(TraceCollisionChannel);
+        StaticGeometryCache->UpdateScenes();
+        // Static geometry is traced in the cache, thus physics scene only needs to trace the rest, if all of it is cached.
+        traceParams.MobilityType = StaticGeometryCache->IsSceneComplete(TraceCollisionChannel) ? EQueryMobilityType::Dynamic
+                                                                                                 : EQueryMobilityType::Any;
+    }
+
+    if (TraceScheduler)
+    {
+        TraceScheduler->QueueScan(this, traceParams);
+        return;
+    }
+
+#if TRACE_ASYNC
+    IssueAsyncTraces(traceParams);
+#else
+    ParallelFor(
+        TracingScan.Hits.Num(), [this, &traceParams](int32 InRayIndex) { TraceRay(InRayIndex, traceParams); }, false);
+    OnScanTraced();
+#endif
+}
+
+void URRBaseLidarComponent::SetDynamicHit(FHitResult& InOutHit, const FHitResult& InDynamicHit)
+{
+    // Dynamic hit was traced up to the static hit, thus its trace end and time are restored to the full ray.
+    const FVector traceEnd = InOutHit.TraceEnd;
+    InOutHit = InDynamicHit;
+    InOutHit.TraceEnd = traceEnd;
+    const double traceLength = (traceEnd - InOutHit.TraceStart).Size();
+    InOutHit.Time = (traceLength > 0.0) ? InOutHit.Distance / traceLength : 0.f;
+}
+
+#if TRACE_ASYNC
+void URRBaseLidarComponent::IssueAsyncTraces(const FCollisionQueryParams& InTraceParams)
+{
+    UWorld* world = GetWorld();
+    const FVector lidarPos = TracingScan.SensorTransform.GetLocation();
+    if (bTraceStaticGeometryCache)
+    {
+        // Static hits are known right away, then physics only needs to find closer dynamic hits.
+        ParallelFor(TracingScan.Hits.Num(),
+                    [this, &InTraceParams, &lidarPos](int32 InRayIndex)
+                    {
+                        const FVector& rayDir = WorldRayDirections[InRayIndex];
+                        const FVector rayOrigin = GetRayOrigin(InRayIndex, lidarPos);
+                        StaticGeometryCache->Raycast(TraceCollisionChannel,
+                                                     rayOrigin + MinRange * rayDir,
+                                                     rayOrigin + MaxRange * rayDir,
+                                                     InTraceParams,
+                                                     TracingScan.Hits[InRayIndex]);
+                    });
+    }
+
+    for (auto i = 0; i < TraceHandles.Num(); ++i)
+    {
+        const FVector& rayDir = WorldRayDirections[i];
+        const FVector rayOrigin = GetRayOrigin(i, lidarPos);
+        FVector startPos = rayOrigin + MinRange * rayDir;
+        FVector endPos = rayOrigin + MaxRange * rayDir;
+        // To be considered: += WithNoise * FVector(PositionNoise->Get(),PositionNoise->Get(),PositionNoise->Get());
+        if (bTraceStaticGeometryCache && TracingScan.Hits[i].bBlockingHit)
+        {
+            endPos = TracingScan.Hits[i].ImpactPoint;
+        }
+
+        TraceHandles[i] = world->AsyncLineTraceByChannel(EAsyncTraceType::Single,
+                                                         startPos,
+                                                         endPos,
+                                                         TraceCollisionChannel,
+                                                         InTraceParams,
+                                                         FCollisionResponseParams::DefaultResponseParam,
+                                                         nullptr);
+    }
+}
+#else
+void URRBaseLidarComponent::TraceRay(const int32 InRayIndex, const FCollisionQueryParams& InTraceParams)
+{
+    const FVector& rayDir = WorldRayDirections[InRayIndex];
+    const FVector rayOrigin = GetRayOrigin(InRayIndex, TracingScan.SensorTransform.GetLocation());
+    FVector startPos = rayOrigin + MinRange * rayDir;
+    FVector endPos = rayOrigin + MaxRange * rayDir;
+    // + WithNoise *  FVector(PositionNoise->Get(),PositionNoise->Get(),PositionNoise->Get());
+
+    FHitResult& hit = TracingScan.Hits[InRayIndex];
+    if (bTraceStaticGeometryCache)
+    {
+        // Physics only needs to find dynamic hits closer than the static one
+        if (StaticGeometryCache->Raycast(TraceCollisionChannel, startPos, endPos, InTraceParams, hit))
+        {
+            endPos = hit.ImpactPoint;
+        }
+        FHitResult dynamicHit;
+        if (GetWorld()->LineTraceSingleByChannel(dynamicHit,
+                                                 startPos,
+                                                 endPos,
+                                                 TraceCollisionChannel,
+                                                 InTraceParams,
+                                                 FCollisionResponseParams::DefaultResponseParam))
+        {
+            SetDynamicHit(hit, dynamicHit);
+        }
+        return;
+    }
+
+    GetWorld()->LineTraceSingleByChannel(
+        hit, startPos, endPos, TraceCollisionChannel, InTraceParams, FCollisionResponseParams::DefaultResponseParam);
+}
+#endif
+
+void URRBaseLidarComponent::OnScanTraced()
+{
+    bTracing = false;
+    bScanTraced = true;
+    UpdateScanPipeline();
+}
+
+void URRBaseLidarComponent::CancelScan()
+{
+    bTracing = false;
+}
+
+void URRBaseLidarComponent::UpdateScanPipeline()
+{
+    if (ScanProcessingFuture.IsValid())
+    {
+        if (!ScanProcessingFuture.IsReady())
+        {
+            return;
+        }
+        ScanProcessingFuture.Reset();
+        CommitProcessedScan();
+    }
+
+    if (bScanTraced)
+    {
+        bScanTraced = false;
+        Swap(TracingScan, ProcessingScan);
+        if (bProcessScanAsync)
+        {
+            ScanProcessingFuture = Async(EAsyncExecution::ThreadPool,
+                                         [this]()
+                                         {
+                                             // Hits reference UObjects, e.g. physical materials
+                                             FGCScopeGuard gcGuard;
+                                             SCOPE_CYCLE_COUNTER(STAT_RRLidarProcessScan);
+                                             ProcessScan(ProcessingScan);
+                                         });
+        }
+        else
+        {
+            {
+                SCOPE_CYCLE_COUNTER(STAT_RRLidarProcessScan);
+                ProcessScan(ProcessingScan);
+            }
+            CommitProcessedScan();
+        }
+    }
+}
+
+void URRBaseLidarComponent::CommitProcessedScan()
+{
+    // Processed scan becomes the recorded one. Old recorded hits buffer is reused for next scans.
+    Swap(ProcessingScan.Hits, RecordedHits);
+    TimeOfLastScan = ProcessingScan.Time;
+    RecordedScanIssueTime = ProcessingScan.IssueTime;
+    UpdateDebugPoints();
+    OnScanProcessed();
+}
+
+void URRBaseLidarComponent::ProcessScan(FRRLidarScan& InOutScan)
+{
+    if (BWithNoise)
+    {
+        // this approach to noise is different from tracing with noisy input:
+        // noise on the linetrace input means that the further the hit, the larger the error, while here the error is independent
+        // from distance
+        AddPositionNoise(InOutScan.Hits);
+    }
+    BuildDebugPoints(InOutScan.Hits);
+}
+
+void URRBaseLidarComponent::BuildDebugPoints(const TArray<FHitResult>& InHits)
+{
+    ProcessingDebugPoints.Reset();
+    ProcessingDebugBounds.Init();
+    if (!bShowLidarRays)
+    {
+        return;
+    }
+
+    const int32 nHits = InHits.Num();
+    const int32 step = FMath::Max3(DebugDrawDecimation, FMath::DivideAndRoundUp(nHits, FMath::Max(MaxDebugPoints, 1)), 1);
+    ProcessingDebugPoints.Reserve(FMath::DivideAndRoundUp(nHits, step));
+    for (int32 i = 0; i < nHits; i += step)
+    {
+        const FHitResult& hit = InHits[i];
+        FRRLidarDebugPoint point;
+        if (hit.bBlockingHit)
+        {
+            point.Position = FVector3f(hit.ImpactPoint);
+            point.Size = 5.f;
+            point.Color = GetDebugColorFromHit(hit);
+        }
+        else if (ShowLidarRayMisses)
+        {
+            point.Position = FVector3f(hit.TraceEnd);
+            point.Size = 2.5f;
+            point.Color = ColorMiss;
+        }
+        else
+        {
+            continue;
+        }
+        ProcessingDebugBounds += FVector(point.Position);
+        ProcessingDebugPoints.Add(point);
+    }
+}
+
+void URRBaseLidarComponent::UpdateDebugPoints()
+{
+    if (!bShowLidarRays || !IsVisible())
+    {
+        if (DebugPointsComponent)
+        {
+            DebugPointsComponent->SetVisibility(false);
+        }
+        return;
+    }
+
+    if (DebugPointsComponent == nullptr)
+    {
+        DebugPointsComponent = NewObject<URRLidarDebugPointsComponent>(this);
+        DebugPointsComponent->DepthPriority = DrawPointDepthIntensity;
+        DebugPointsComponent->RegisterComponentWithWorld(GetWorld());
+    }
+    DebugPointsComponent->SetVisibility(true);
+    DebugPointsComponent->SetPoints(MoveTemp(ProcessingDebugPoints), ProcessingDebugBounds);
+}
+
+FLinearColor URRBaseLidarComponent::GetDebugColorFromHit(const FHitResult& InHit)
+{
+    const float distance = (MinRange * (InHit.Distance > 0) + InHit.Distance) * .01f;
+    const UPhysicalMaterial* physMat = InHit.PhysMaterial.Get();
+    float intensity = IntensityNonReflective;
+    if (physMat != nullptr)
+    {
+        // retroreflective material
+        if (physMat->SurfaceType == EPhysicalSurface::SurfaceType1)
+        {
+            intensity = IntensityReflective;
+        }
+        // reflective material
+        else if (physMat->SurfaceType == EPhysicalSurface::SurfaceType2)
+        {
+            const FVector rayDirection = (InHit.TraceEnd - InHit.TraceStart).GetSafeNormal();
+            float normalAlignment = FVector::DotProduct(InHit.Normal, -rayDirection);
+            normalAlignment *= normalAlignment;
+            normalAlignment *= normalAlignment;
+            normalAlignment *= normalAlignment;
+            normalAlignment *= normalAlignment;
+            normalAlignment *= normalAlignment;    // pow 32
+            intensity = normalAlignment * (IntensityReflective - IntensityNonReflective) + IntensityNonReflective;
+        }
+    }
+    return InterpColorFromIntensity(GetIntensityFromDist(intensity, distance));
+}
+
+void URRBaseLidarComponent::OnScanPublished()
+{
+    if (RecordedScanIssueTime > 0.0)
+    {
+        ScanLatency = FPlatformTime::Seconds() - RecordedScanIssueTime;
+    }
 }
 
 void URRBaseLidarComponent::GetData(TArray<FHitResult>& OutHits, float& OutTime) const
@@ -49,3 +515,178 @@ float URRBaseLidarComponent::GetIntensityFromDist(float InBaseIntensity, float I
     return InBaseIntensity * 1.3f * FMath::Exp(-.1f * (FMath::Pow(3.5f * InDistance, .6f))) /
            (1 + FMath::Exp(-((3.5f * InDistance))));
 }
+
+float URRBaseLidarComponent::GetIntensityFromHit(const FHitResult& InHit,
+                                                 float InIntensityNonReflective,
+                                                 float InIntensityReflective)
+{
+    const UPhysicalMaterial* physMat = InHit.PhysMaterial.Get();
+    if (nullptr == physMat)
+    {
+        return 0.f;
+    }
+
+    switch (physMat->SurfaceType)
+    {
+        // retroreflective material
+        case EPhysicalSurface::SurfaceType1:
+            return InIntensityReflective;
+
+        // non-reflective material
+        case EPhysicalSurface::SurfaceType_Default:
+            return InIntensityNonReflective;
+
+        // reflective material
+        case EPhysicalSurface::SurfaceType2:
+        {
+            const FVector rayDirection = (InHit.TraceEnd - InHit.TraceStart).GetSafeNormal();
+            // the dot product for this should always be between 0 and 1
+            return FMath::Clamp(InIntensityNonReflective + (InIntensityReflective - InIntensityNonReflective) *
+                                                               FVector::DotProduct(InHit.Normal, -rayDirection),
+                                InIntensityNonReflective,
+                                InIntensityReflective);
+        }
+
+        default:
+            return 0.f;
+    }
+}
+
+FRRLidarScanPattern URRBaseLidarComponent::GetScanPattern() const
+{
+    FRRLidarScanPattern scanPattern;
+    scanPattern.NSamplesPerScan = NSamplesPerScan;
+    scanPattern.NChannelsPerScan = 1;
+    scanPattern.StartAngle = StartAngle;
+    scanPattern.FOVHorizontal = FOVHorizontal;
+    return scanPattern;
+}
+
+void URRBaseLidarComponent::BuildLocalRayDirections(const FRRLidarScanPattern& InScanPattern)
+{
+    const int32 nSamples = FMath::Max(InScanPattern.NSamplesPerScan, 0);
+    const int32 nChannels = FMath::Max(InScanPattern.NChannelsPerScan, 0);
+    const float dHAngle = (nSamples > 0) ? InScanPattern.FOVHorizontal / static_cast<float>(nSamples) : 0.f;
+    const float dVAngle = (nChannels > 0) ? InScanPattern.FOVVertical / static_cast<float>(nChannels) : 0.f;
+
+    // Trig is only evaluated once per ring and per column, then combined
+    TArray<FVector2D> hCosSin;
+    hCosSin.SetNumUninitialized(nSamples);
+    for (int32 idxX = 0; idxX < nSamples; ++idxX)
+    {
+        double sinH, cosH;
+        FMath::SinCos(&sinH, &cosH, FMath::DegreesToRadians(InScanPattern.StartAngle + dHAngle * idxX));
+        hCosSin[idxX] = FVector2D(cosH, sinH);
+    }
+
+    LocalRayDirections.SetNumUninitialized(nSamples * nChannels);
+    for (int32 idxY = 0; idxY < nChannels; ++idxY)
+    {
+        // Same as FRotator(VAngle, HAngle, 0).Vector()
+        double sinV, cosV;
+        FMath::SinCos(&sinV, &cosV, FMath::DegreesToRadians(InScanPattern.StartVerticalAngle + dVAngle * idxY));
+        for (int32 idxX = 0; idxX < nSamples; ++idxX)
+        {
+            LocalRayDirections[idxX + idxY * nSamples] = FVector(cosV * hCosSin[idxX].X, cosV * hCosSin[idxX].Y, sinV);
+        }
+    }
+
+    CachedScanPattern = InScanPattern;
+}
+
+void URRBaseLidarComponent::AddPositionNoise(TArray<FHitResult>& InOutHits)
+{
+    const int32 nHits = InOutHits.Num();
+    PositionNoise->Fill(PositionNoiseSamples, 6 * nHits);
+    ParallelFor(FMath::DivideAndRoundUp(nHits, RAY_BATCH_SIZE),
+                [this, &InOutHits, nHits](int32 InBatchIndex)
+                {
+                    const int32 startIndex = InBatchIndex * RAY_BATCH_SIZE;
+                    const int32 endIndex = FMath::Min(startIndex + RAY_BATCH_SIZE, nHits);
+                    for (int32 i = startIndex; i < endIndex; ++i)
+                    {
+                        const float* noise = &PositionNoiseSamples[6 * i];
+                        InOutHits[i].ImpactPoint += FVector(noise[0], noise[1], noise[2]);
+                        InOutHits[i].TraceEnd += FVector(noise[3], noise[4], noise[5]);
+                    }
+                });
+}
+
+float URRBaseLidarComponent::GetScanStartTime() const
+{
+    return bSimulateMotionDistortion ? TimeOfLastScan - Dt : TimeOfLastScan;
+}
+
+void URRBaseLidarComponent::UpdateColumnTransforms()
+{
+    const FTransform currentTransform = GetComponentTransform();
+    TArray<FTransform>& columnTransforms = TracingScan.ColumnTransforms;
+    if (!bSimulateMotionDistortion)
+    {
+        columnTransforms.Reset();
+        PreviousScanTransform = currentTransform;
+        bPreviousScanTransformValid = true;
+        return;
+    }
+
+    // Column i is fired at i / NSamplesPerScan of the scan period, which starts at the previous scan's pose.
+    const FTransform startTransform = bPreviousScanTransformValid ? PreviousScanTransform : currentTransform;
+    const int32 nSamples = FMath::Max(NSamplesPerScan, 0);
+    columnTransforms.SetNum(nSamples);
+    ParallelFor(FMath::DivideAndRoundUp(nSamples, RAY_BATCH_SIZE),
+                [&columnTransforms, &startTransform, &currentTransform, nSamples](int32 InBatchIndex)
+                {
+                    const int32 startIndex = InBatchIndex * RAY_BATCH_SIZE;
+                    const int32 endIndex = FMath::Min(startIndex + RAY_BATCH_SIZE, nSamples);
+                    for (int32 i = startIndex; i < endIndex; ++i)
+                    {
+                        columnTransforms[i].Blend(startTransform, currentTransform, i / static_cast<float>(nSamples));
+                    }
+                });
+
+    PreviousScanTransform = currentTransform;
+    bPreviousScanTransformValid = true;
+}
+
+void URRBaseLidarComponent::UpdateRayDirections(const bool bInWithColumnTransforms)
+{
+    UpdateRayDirections(WorldRayDirections, bInWithColumnTransforms);
+}
+
+void URRBaseLidarComponent::UpdateRayDirections(TArray<FVector>& OutWorldRayDirections, const bool bInWithColumnTransforms)
+{
+    const FRRLidarScanPattern scanPattern = GetScanPattern();
+    if ((scanPattern != CachedScanPattern) ||
+        (LocalRayDirections.Num() != scanPattern.NSamplesPerScan * scanPattern.NChannelsPerScan))
+    {
+        BuildLocalRayDirections(scanPattern);
+    }
+
+    const int32 nRays = LocalRayDirections.Num();
+    OutWorldRayDirections.SetNumUninitialized(nRays);
+
+    const FQuat lidarQuat = GetComponentQuat();
+    const TArray<FTransform>& columnTransforms = TracingScan.ColumnTransforms;
+    const int32 nColumns = bInWithColumnTransforms ? columnTransforms.Num() : 0;
+    ParallelFor(FMath::DivideAndRoundUp(nRays, RAY_BATCH_SIZE),
+                [this, &OutWorldRayDirections, &lidarQuat, &columnTransforms, nRays, nColumns](int32 InBatchIndex)
+                {
+                    const int32 startIndex = InBatchIndex * RAY_BATCH_SIZE;
+                    const int32 endIndex = FMath::Min(startIndex + RAY_BATCH_SIZE, nRays);
+                    if (nColumns > 0)
+                    {
+                        for (int32 i = startIndex; i < endIndex; ++i)
+                        {
+                            const FQuat& columnQuat = columnTransforms[i % nColumns].GetRotation();
+                            OutWorldRayDirections[i] = columnQuat.RotateVector(LocalRayDirections[i]);
+                        }
+                    }
+                    else
+                    {
+                        for (int32 i = startIndex; i < endIndex; ++i)
+                        {
+                            OutWorldRayDirections[i] = lidarQuat.RotateVector(LocalRayDirections[i]);
+                        }
+                    }
+                });
+}
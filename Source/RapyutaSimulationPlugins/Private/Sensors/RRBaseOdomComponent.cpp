@@ -28,9 +28,20 @@ void URRBaseOdomComponent::PreInitializePublisher(UROS2NodeComponent* InROS2Node
     if (odomPub)
     {
         odomPub->bPublishOdomTf = bPublishOdomTf;
+        odomPub->bAggregateOdomTf = bAggregateOdomTf;
     }
 }
 
+void URRBaseOdomComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    URRROS2OdomPublisher* odomPub = Cast<URRROS2OdomPublisher>(SensorPublisher);
+    if (odomPub)
+    {
+        odomPub->DeInitializeTF();
+    }
+    Super::EndPlay(EndPlayReason);
+}
+
 void URRBaseOdomComponent::SetFrameIds(const FString& InFrameId, const FString& InChildFrameId)
 {
     OdomData.Header.FrameId = FrameId = InFrameId;
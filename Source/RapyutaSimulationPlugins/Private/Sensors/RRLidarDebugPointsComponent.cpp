@@ -0,0 +1,229 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+#include "Sensors/RRLidarDebugPointsComponent.h"
+
+// UE
+#include "DynamicMeshBuilder.h"
+#include "Engine/Engine.h"
+#include "LocalVertexFactory.h"
+#include "Materials/Material.h"
+#include "PrimitiveSceneProxy.h"
+#include "PrimitiveViewRelevance.h"
+#include "RenderingThread.h"
+#include "SceneManagement.h"
+#include "StaticMeshResources.h"
+
+namespace
+{
+//! Each point is drawn as an octahedron, with vertices +X, -X, +Y, -Y, +Z, -Z
+constexpr int32 NUM_POINT_VERTICES = 6;
+constexpr uint32 POINT_INDICES[] = {0, 2, 4, 2, 1, 4, 1, 3, 4, 3, 0, 4, 2, 0, 5, 1, 2, 5, 3, 1, 5, 0, 3, 5};
+constexpr int32 NUM_POINT_INDICES = UE_ARRAY_COUNT(POINT_INDICES);
+}    // namespace
+
+/**
+ * @brief Scene proxy of #URRLidarDebugPointsComponent.
+ * Vertex and index buffers are rebuilt on render thread once per scan, then drawn with one mesh batch per view.
+ */
+class FRRLidarDebugPointsSceneProxy final : public FPrimitiveSceneProxy
+{
+public:
+    FRRLidarDebugPointsSceneProxy(URRLidarDebugPointsComponent* InComponent)
+        : FPrimitiveSceneProxy(InComponent),
+          Points(InComponent->Points),
+          VertexFactory(GetScene().GetFeatureLevel(), "FRRLidarDebugPointsSceneProxy"),
+          Material(GEngine->VertexColorMaterial),
+          MaterialRelevance(Material->GetRelevance_Concurrent(GetScene().GetFeatureLevel())),
+          DepthPriority(InComponent->DepthPriority)
+    {
+    }
+
+    virtual ~FRRLidarDebugPointsSceneProxy()
+    {
+        VertexBuffers.PositionVertexBuffer.ReleaseResource();
+        VertexBuffers.StaticMeshVertexBuffer.ReleaseResource();
+        VertexBuffers.ColorVertexBuffer.ReleaseResource();
+        IndexBuffer.ReleaseResource();
+        VertexFactory.ReleaseResource();
+    }
+
+    virtual SIZE_T GetTypeHash() const override
+    {
+        static size_t UniquePointer;
+        return reinterpret_cast<size_t>(&UniquePointer);
+    }
+
+    virtual void CreateRenderThreadResources() override
+    {
+        BuildBuffers();
+    }
+
+    void SetPoints_RenderThread(const FRRLidarDebugPointsPtr& InPoints)
+    {
+        check(IsInRenderingThread());
+        Points = InPoints;
+        BuildBuffers();
+    }
+
+    virtual void GetDynamicMeshElements(const TArray<const FSceneView*>& Views,
+                                        const FSceneViewFamily& ViewFamily,
+                                        uint32 VisibilityMap,
+                                        FMeshElementCollector& Collector) const override
+    {
+        if (NumPoints == 0)
+        {
+            return;
+        }
+
+        FMaterialRenderProxy* materialProxy = Material->GetRenderProxy();
+        for (int32 viewIndex = 0; viewIndex < Views.Num(); ++viewIndex)
+        {
+            if (VisibilityMap & (1 << viewIndex))
+            {
+                FMeshBatch& mesh = Collector.AllocateMesh();
+                mesh.VertexFactory = &VertexFactory;
+                mesh.MaterialRenderProxy = materialProxy;
+                mesh.ReverseCulling = IsLocalToWorldDeterminantNegative();
+                mesh.Type = PT_TriangleList;
+                mesh.DepthPriorityGroup = static_cast<ESceneDepthPriorityGroup>(DepthPriority);
+                mesh.bCanApplyViewModeOverrides = false;
+
+                FMeshBatchElement& element = mesh.Elements[0];
+                element.IndexBuffer = &IndexBuffer;
+                element.FirstIndex = 0;
+                element.NumPrimitives = NumPoints * NUM_POINT_INDICES / 3;
+                element.MinVertexIndex = 0;
+                element.MaxVertexIndex = NumPoints * NUM_POINT_VERTICES - 1;
+
+                Collector.AddMesh(viewIndex, mesh);
+            }
+        }
+    }
+
+    virtual FPrimitiveViewRelevance GetViewRelevance(const FSceneView* View) const override
+    {
+        FPrimitiveViewRelevance result;
+        result.bDrawRelevance = IsShown(View);
+        result.bDynamicRelevance = true;
+        result.bShadowRelevance = false;
+        result.bEditorPrimitiveRelevance = UseEditorCompositing(View);
+        MaterialRelevance.SetPrimitiveViewRelevance(result);
+        return result;
+    }
+
+    virtual uint32 GetMemoryFootprint() const override
+    {
+        return sizeof(*this) + GetAllocatedSize();
+    }
+
+    uint32 GetAllocatedSize() const
+    {
+        return FPrimitiveSceneProxy::GetAllocatedSize() + IndexBuffer.Indices.GetAllocatedSize() +
+               VertexBuffers.PositionVertexBuffer.GetAllocatedSize() +
+               VertexBuffers.StaticMeshVertexBuffer.GetResourceSize() + VertexBuffers.ColorVertexBuffer.GetAllocatedSize();
+    }
+
+private:
+    //! Rebuild vertex and index buffers from #Points. Existing resources are updated in place.
+    void BuildBuffers()
+    {
+        NumPoints = Points.IsValid() ? Points->Num() : 0;
+        if (NumPoints == 0)
+        {
+            return;
+        }
+
+        TArray<FDynamicMeshVertex> vertices;
+        vertices.SetNumUninitialized(NumPoints * NUM_POINT_VERTICES);
+        IndexBuffer.Indices.SetNumUninitialized(NumPoints * NUM_POINT_INDICES);
+        for (int32 i = 0; i < NumPoints; ++i)
+        {
+            const FRRLidarDebugPoint& point = (*Points)[i];
+            const float halfSize = 0.5f * point.Size;
+            const FColor color = point.Color.ToFColor(true);
+            const FVector3f offsets[NUM_POINT_VERTICES] = {FVector3f(halfSize, 0.f, 0.f),
+                                                           FVector3f(-halfSize, 0.f, 0.f),
+                                                           FVector3f(0.f, halfSize, 0.f),
+                                                           FVector3f(0.f, -halfSize, 0.f),
+                                                           FVector3f(0.f, 0.f, halfSize),
+                                                           FVector3f(0.f, 0.f, -halfSize)};
+            for (int32 v = 0; v < NUM_POINT_VERTICES; ++v)
+            {
+                vertices[i * NUM_POINT_VERTICES + v] =
+                    FDynamicMeshVertex(point.Position + offsets[v], FVector2f::ZeroVector, color);
+            }
+            for (int32 j = 0; j < NUM_POINT_INDICES; ++j)
+            {
+                IndexBuffer.Indices[i * NUM_POINT_INDICES + j] = i * NUM_POINT_VERTICES + POINT_INDICES[j];
+            }
+        }
+
+        // Initializes or updates vertex buffers and binds them to VertexFactory, inline since on render thread.
+        VertexBuffers.InitFromDynamicVertex(&VertexFactory, vertices);
+        if (IndexBuffer.IsInitialized())
+        {
+            IndexBuffer.ReleaseResource();
+        }
+        IndexBuffer.InitResource();
+    }
+
+    FRRLidarDebugPointsPtr Points;
+    int32 NumPoints = 0;
+
+    FStaticMeshVertexBuffers VertexBuffers;
+    FDynamicMeshIndexBuffer32 IndexBuffer;
+    FLocalVertexFactory VertexFactory;
+
+    UMaterialInterface* Material = nullptr;
+    FMaterialRelevance MaterialRelevance;
+    uint8 DepthPriority = SDPG_World;
+};
+
+URRLidarDebugPointsComponent::URRLidarDebugPointsComponent()
+{
+    PrimaryComponentTick.bCanEverTick = false;
+    SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    SetGenerateOverlapEvents(false);
+    CastShadow = false;
+    bUseAttachParentBound = false;
+
+    // Points are in world frame
+    SetUsingAbsoluteLocation(true);
+    SetUsingAbsoluteRotation(true);
+    SetUsingAbsoluteScale(true);
+}
+
+void URRLidarDebugPointsComponent::SetPoints(TArray<FRRLidarDebugPoint>&& InPoints, const FBox& InBounds)
+{
+    Points = MakeShared<TArray<FRRLidarDebugPoint>, ESPMode::ThreadSafe>(MoveTemp(InPoints));
+    PointsBounds = InBounds;
+    UpdateBounds();
+    MarkRenderTransformDirty();
+
+    FRRLidarDebugPointsSceneProxy* proxy = static_cast<FRRLidarDebugPointsSceneProxy*>(SceneProxy);
+    if (proxy == nullptr)
+    {
+        // Taken by next #CreateSceneProxy from Points
+        return;
+    }
+
+    // Proxy is released by a render command enqueued after this one, thus it is still valid when this one runs.
+    ENQUEUE_RENDER_COMMAND(RRLidarDebugPointsUpdate)
+    ([proxy, points = Points](FRHICommandListImmediate& RHICmdList) { proxy->SetPoints_RenderThread(points); });
+}
+
+FPrimitiveSceneProxy* URRLidarDebugPointsComponent::CreateSceneProxy()
+{
+    return new FRRLidarDebugPointsSceneProxy(this);
+}
+
+FBoxSphereBounds URRLidarDebugPointsComponent::CalcBounds(const FTransform& LocalToWorld) const
+{
+    return PointsBounds.IsValid ? FBoxSphereBounds(PointsBounds)
+                                : FBoxSphereBounds(LocalToWorld.GetLocation(), FVector::ZeroVector, 0.f);
+}
+
+void URRLidarDebugPointsComponent::GetUsedMaterials(TArray<UMaterialInterface*>& OutMaterials, bool bGetDebugMaterials) const
+{
+    OutMaterials.Add(GEngine->VertexColorMaterial);
+}
@@ -0,0 +1,710 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+#include "Sensors/RRLidarStaticGeometryCache.h"
+
+// UE
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "EngineUtils.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "StaticMeshResources.h"
+
+// std
+#include <algorithm>
+
+// rclUE
+#include "logUtilities.h"
+
+// RapyutaSimulationPlugins
+#include "RapyutaSimulationPlugins.h"
+
+namespace
+{
+constexpr int32 BVH_MAX_LEAF_SIZE = 4;
+constexpr int32 BVH_NUM_BINS = 16;
+constexpr int32 BVH_MAX_DEPTH = 64;
+
+//! Max magnitude of inverse ray direction, so that slab tests of axis-aligned rays do not compute 0 * inf = NaN
+constexpr float BVH_MAX_INV_DIR = 1e30f;
+
+float GetHalfArea(const FBox3f& InBox)
+{
+    if (!InBox.IsValid)
+    {
+        return 0.f;
+    }
+    const FVector3f extent = InBox.Max - InBox.Min;
+    return extent.X * extent.Y + extent.Y * extent.Z + extent.Z * extent.X;
+}
+
+/**
+ * @brief Build BVH over primitive bounds with binned SAH.
+ * @param InPrimBounds
+ * @param OutNodes
+ * @param OutPrimOrder Primitive index for each leaf slot
+ */
+void BuildBVH(const TArray<FBox3f>& InPrimBounds, TArray<FRRBVHNode>& OutNodes, TArray<int32>& OutPrimOrder)
+{
+    const int32 nPrims = InPrimBounds.Num();
+    OutNodes.Reset();
+    OutPrimOrder.SetNumUninitialized(nPrims);
+    if (nPrims == 0)
+    {
+        return;
+    }
+
+    TArray<FVector3f> centroids;
+    centroids.SetNumUninitialized(nPrims);
+    for (int32 i = 0; i < nPrims; ++i)
+    {
+        OutPrimOrder[i] = i;
+        centroids[i] = InPrimBounds[i].GetCenter();
+    }
+
+    struct FBuildTask
+    {
+        int32 NodeIndex;
+        int32 First;
+        int32 Count;
+        int32 Depth;
+    };
+    TArray<FBuildTask, TInlineAllocator<BVH_MAX_DEPTH>> tasks;
+    OutNodes.Reserve(2 * FMath::DivideAndRoundUp(nPrims, BVH_MAX_LEAF_SIZE));
+    OutNodes.AddDefaulted();
+    tasks.Add({0, 0, nPrims, 0});
+    while (tasks.Num() > 0)
+    {
+        const FBuildTask task = tasks.Pop(false);
+        FBox3f bounds(ForceInit), centroidBounds(ForceInit);
+        for (int32 i = task.First; i < task.First + task.Count; ++i)
+        {
+            bounds += InPrimBounds[OutPrimOrder[i]];
+            centroidBounds += centroids[OutPrimOrder[i]];
+        }
+        OutNodes[task.NodeIndex].Min = bounds.Min;
+        OutNodes[task.NodeIndex].Max = bounds.Max;
+
+        // Find the cheapest split plane among bin boundaries of all axes
+        int32 bestAxis = INDEX_NONE;
+        float bestSplit = 0.f;
+        float bestCost = task.Count * GetHalfArea(bounds);
+        if ((task.Count > BVH_MAX_LEAF_SIZE) && (task.Depth < BVH_MAX_DEPTH - 1))
+        {
+            for (int32 axis = 0; axis < 3; ++axis)
+            {
+                const float axisMin = centroidBounds.Min[axis];
+                const float axisExtent = centroidBounds.Max[axis] - axisMin;
+                if (axisExtent <= 0.f)
+                {
+                    continue;
+                }
+
+                FBox3f binBounds[BVH_NUM_BINS];
+                int32 binCounts[BVH_NUM_BINS] = {};
+                for (int32 b = 0; b < BVH_NUM_BINS; ++b)
+                {
+                    binBounds[b] = FBox3f(ForceInit);
+                }
+                const float binScale = BVH_NUM_BINS / axisExtent;
+                for (int32 i = task.First; i < task.First + task.Count; ++i)
+                {
+                    const int32 prim = OutPrimOrder[i];
+                    const int32 b = FMath::Min(static_cast<int32>((centroids[prim][axis] - axisMin) * binScale), BVH_NUM_BINS - 1);
+                    binBounds[b] += InPrimBounds[prim];
+                    ++binCounts[b];
+                }
+
+                // Sweep from the right to get costs of right sides, then from the left
+                float rightAreas[BVH_NUM_BINS];
+                int32 rightCounts[BVH_NUM_BINS];
+                FBox3f rightBounds(ForceInit);
+                int32 rightCount = 0;
+                for (int32 b = BVH_NUM_BINS - 1; b > 0; --b)
+                {
+                    rightBounds += binBounds[b];
+                    rightCount += binCounts[b];
+                    rightAreas[b] = GetHalfArea(rightBounds);
+                    rightCounts[b] = rightCount;
+                }
+                FBox3f leftBounds(ForceInit);
+                int32 leftCount = 0;
+                for (int32 b = 1; b < BVH_NUM_BINS; ++b)
+                {
+                    leftBounds += binBounds[b - 1];
+                    leftCount += binCounts[b - 1];
+                    const float cost = leftCount * GetHalfArea(leftBounds) + rightCounts[b] * rightAreas[b];
+                    if ((leftCount > 0) && (rightCounts[b] > 0) && (cost < bestCost))
+                    {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = axisMin + b / binScale;
+                    }
+                }
+            }
+        }
+
+        if (bestAxis == INDEX_NONE)
+        {
+            OutNodes[task.NodeIndex].FirstOrLeft = task.First;
+            OutNodes[task.NodeIndex].Count = task.Count;
+            continue;
+        }
+
+        int32* const primBegin = OutPrimOrder.GetData() + task.First;
+        int32* const primMid = std::partition(primBegin,
+                                              primBegin + task.Count,
+                                              [&centroids, bestAxis, bestSplit](const int32 InPrim)
+                                              { return centroids[InPrim][bestAxis] < bestSplit; });
+        const int32 nLeft = static_cast<int32>(primMid - primBegin);
+
+        const int32 leftIndex = OutNodes.Num();
+        OutNodes.AddDefaulted(2);
+        OutNodes[task.NodeIndex].FirstOrLeft = leftIndex;
+        OutNodes[task.NodeIndex].Count = 0;
+        tasks.Add({leftIndex, task.First, nLeft, task.Depth + 1});
+        tasks.Add({leftIndex + 1, task.First + nLeft, task.Count - nLeft, task.Depth + 1});
+    }
+}
+
+/**
+ * @brief Get triangles of simple collision shapes, which complex traces hit instead of mesh if CTF_UseSimpleAsComplex.
+ * @param InAggGeom
+ * @param OutVertices 3 vertices per triangle in component frame
+ * @return false if a shape can not be triangulated exactly, e.g. sphere and capsule.
+ */
+bool GetSimpleCollisionTriangles(const FKAggregateGeom& InAggGeom, TArray<FVector>& OutVertices)
+{
+    if ((InAggGeom.SphereElems.Num() > 0) || (InAggGeom.SphylElems.Num() > 0) || (InAggGeom.TaperedCapsuleElems.Num() > 0))
+    {
+        return false;
+    }
+
+    // 2 triangles per face of the box whose corner i is at (+-X, +-Y, +-Z) by bits 0, 1, 2 of i
+    static constexpr int32 BOX_INDICES[36] = {0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+                                              2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5};
+    for (const FKBoxElem& box : InAggGeom.BoxElems)
+    {
+        const FTransform boxTransform = box.GetTransform();
+        const FVector halfExtent(0.5f * box.X, 0.5f * box.Y, 0.5f * box.Z);
+        for (const int32 corner : BOX_INDICES)
+        {
+            OutVertices.Add(boxTransform.TransformPosition(FVector((corner & 1) ? halfExtent.X : -halfExtent.X,
+                                                                   (corner & 2) ? halfExtent.Y : -halfExtent.Y,
+                                                                   (corner & 4) ? halfExtent.Z : -halfExtent.Z)));
+        }
+    }
+
+    for (const FKConvexElem& convex : InAggGeom.ConvexElems)
+    {
+        if ((convex.IndexData.Num() == 0) || (convex.IndexData.Num() % 3 != 0))
+        {
+            return false;
+        }
+        const FTransform convexTransform = convex.GetTransform();
+        for (const int32 index : convex.IndexData)
+        {
+            OutVertices.Add(convexTransform.TransformPosition(convex.VertexData[index]));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Get triangles of the static mesh LOD which complex collision is built from.
+ * @param InComponent
+ * @param OutVertices 3 vertices per triangle in component frame
+ * @param OutFaceIndices Face index in the LOD per triangle
+ * @param OutMaterialIndices Index into OutPhysMaterials per triangle
+ * @param OutPhysMaterials Physical materials of complex collision, added uniquely
+ * @return false if mesh data is not accessible from CPU.
+ */
+bool GetComplexCollisionTriangles(UStaticMeshComponent* InComponent,
+                                  TArray<FVector>& OutVertices,
+                                  TArray<int32>& OutFaceIndices,
+                                  TArray<uint16>& OutMaterialIndices,
+                                  TArray<TWeakObjectPtr<UPhysicalMaterial>>& OutPhysMaterials)
+{
+    const UStaticMesh* staticMesh = InComponent->GetStaticMesh();
+#if !WITH_EDITOR
+    if (!staticMesh->bAllowCPUAccess)
+    {
+        return false;
+    }
+#endif
+    const FStaticMeshRenderData* renderData = staticMesh->GetRenderData();
+    if ((renderData == nullptr) || (renderData->LODResources.Num() == 0))
+    {
+        return false;
+    }
+
+    // Complex collision is built from LODForCollision
+    const FStaticMeshLODResources& lod =
+        renderData->LODResources[FMath::Clamp(staticMesh->LODForCollision, 0, renderData->LODResources.Num() - 1)];
+    const FPositionVertexBuffer& positions = lod.VertexBuffers.PositionVertexBuffer;
+    const FIndexArrayView indices = lod.IndexBuffer.GetArrayView();
+    if ((positions.GetNumVertices() == 0) || (indices.Num() == 0))
+    {
+        return false;
+    }
+
+    // Physical materials of complex collision, per material index
+    TArray<UPhysicalMaterial*> physMaterials;
+    InComponent->BodyInstance.GetComplexPhysicalMaterials(physMaterials);
+
+    for (const FStaticMeshSection& section : lod.Sections)
+    {
+        if (!section.bEnableCollision)
+        {
+            continue;
+        }
+
+        UPhysicalMaterial* physMaterial = physMaterials.IsValidIndex(section.MaterialIndex)
+                                              ? physMaterials[section.MaterialIndex]
+                                              : GEngine->DefaultPhysMaterial.Get();
+        const uint16 materialIndex = static_cast<uint16>(OutPhysMaterials.AddUnique(physMaterial));
+        for (uint32 tri = 0; tri < section.NumTriangles; ++tri)
+        {
+            const uint32 firstIndex = section.FirstIndex + 3 * tri;
+            for (uint32 corner = 0; corner < 3; ++corner)
+            {
+                OutVertices.Add(FVector(positions.VertexPosition(indices[firstIndex + corner])));
+            }
+            OutFaceIndices.Add(firstIndex / 3);
+            OutMaterialIndices.Add(materialIndex);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Ray in the form used by slab and triangle tests, with parameter t in [0, MaxT] along Start -> End.
+ */
+struct FBVHRay
+{
+    FBVHRay(const FVector& InStart, const FVector& InEnd)
+        : Origin(InStart), Dir(InEnd - InStart), InvDir(GetSafeInv(Dir.X), GetSafeInv(Dir.Y), GetSafeInv(Dir.Z))
+    {
+    }
+
+    //! Inverse clamped to #BVH_MAX_INV_DIR, e.g. for Dir.Z == 0 of 2D lidars, whose origin may lie on a box plane.
+    static FORCEINLINE float GetSafeInv(const float InValue)
+    {
+        if (FMath::Abs(InValue) * BVH_MAX_INV_DIR > 1.f)
+        {
+            return 1.f / InValue;
+        }
+        return FMath::IsNegativeOrNegativeZero(InValue) ? -BVH_MAX_INV_DIR : BVH_MAX_INV_DIR;
+    }
+
+    FORCEINLINE bool IntersectBox(const FRRBVHNode& InNode, const float InMaxT, float& OutNearT) const
+    {
+        const FVector3f t0 = (InNode.Min - Origin) * InvDir;
+        const FVector3f t1 = (InNode.Max - Origin) * InvDir;
+        const float nearT = FMath::Max3(FMath::Min(t0.X, t1.X), FMath::Min(t0.Y, t1.Y), FMath::Min(t0.Z, t1.Z));
+        const float farT = FMath::Min3(FMath::Max(t0.X, t1.X), FMath::Max(t0.Y, t1.Y), FMath::Max(t0.Z, t1.Z));
+        OutNearT = nearT;
+        return (nearT <= farT) && (farT >= 0.f) && (nearT <= InMaxT);
+    }
+
+    //! Two sided Moller-Trumbore test, as complex collision is hit from both sides.
+    FORCEINLINE bool IntersectTriangle(const FVector3f& InV0, const FVector3f& InV1, const FVector3f& InV2, float& InOutT) const
+    {
+        const FVector3f e1 = InV1 - InV0;
+        const FVector3f e2 = InV2 - InV0;
+        const FVector3f p = FVector3f::CrossProduct(Dir, e2);
+        const float det = FVector3f::DotProduct(e1, p);
+        if (FMath::Abs(det) < UE_SMALL_NUMBER)
+        {
+            return false;
+        }
+        const float invDet = 1.f / det;
+        const FVector3f s = Origin - InV0;
+        const float u = FVector3f::DotProduct(s, p) * invDet;
+        if ((u < 0.f) || (u > 1.f))
+        {
+            return false;
+        }
+        const FVector3f q = FVector3f::CrossProduct(s, e1);
+        const float v = FVector3f::DotProduct(Dir, q) * invDet;
+        if ((v < 0.f) || (u + v > 1.f))
+        {
+            return false;
+        }
+        const float t = FVector3f::DotProduct(e2, q) * invDet;
+        if ((t < 0.f) || (t >= InOutT))
+        {
+            return false;
+        }
+        InOutT = t;
+        return true;
+    }
+
+    FVector3f Origin;
+    FVector3f Dir;
+    FVector3f InvDir;
+};
+
+/**
+ * @brief Traverse BVH nearest child first.
+ * @param InLeafFunc Called with leaf primitive index range, should return true and lower InOutT if it found a closer hit.
+ */
+template<typename TLeafFunc>
+void TraverseBVH(const TArray<FRRBVHNode>& InNodes, const FBVHRay& InRay, float& InOutT, TLeafFunc&& InLeafFunc)
+{
+    if (InNodes.Num() == 0)
+    {
+        return;
+    }
+
+    float nearT;
+    if (!InRay.IntersectBox(InNodes[0], InOutT, nearT))
+    {
+        return;
+    }
+
+    int32 stack[BVH_MAX_DEPTH];
+    int32 stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const FRRBVHNode& node = InNodes[stack[--stackSize]];
+        if (node.Count > 0)
+        {
+            InLeafFunc(node.FirstOrLeft, node.Count, InOutT);
+            continue;
+        }
+
+        float nearT0, nearT1;
+        const bool bHit0 = InRay.IntersectBox(InNodes[node.FirstOrLeft], InOutT, nearT0);
+        const bool bHit1 = InRay.IntersectBox(InNodes[node.FirstOrLeft + 1], InOutT, nearT1);
+        // Push the farther child first, so that the nearer one is visited first
+        if (bHit0 && bHit1)
+        {
+            const bool bFirstNearer = (nearT0 <= nearT1);
+            stack[stackSize++] = node.FirstOrLeft + (bFirstNearer ? 1 : 0);
+            stack[stackSize++] = node.FirstOrLeft + (bFirstNearer ? 0 : 1);
+        }
+        else if (bHit0)
+        {
+            stack[stackSize++] = node.FirstOrLeft;
+        }
+        else if (bHit1)
+        {
+            stack[stackSize++] = node.FirstOrLeft + 1;
+        }
+    }
+}
+}    // namespace
+
+void URRLidarStaticGeometryCache::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+    ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(
+        FOnActorSpawned::FDelegate::CreateUObject(this, &URRLidarStaticGeometryCache::OnActorSpawned));
+    ActorDestroyedHandle = InWorld.AddOnActorDestroyededHandler(
+        FOnActorDestroyed::FDelegate::CreateUObject(this, &URRLidarStaticGeometryCache::OnActorDestroyed));
+}
+
+void URRLidarStaticGeometryCache::Deinitialize()
+{
+    UWorld* world = GetWorld();
+    if (world)
+    {
+        world->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+        world->RemoveOnActorDestroyededHandler(ActorDestroyedHandle);
+    }
+    Scenes.Empty();
+    Super::Deinitialize();
+}
+
+void URRLidarStaticGeometryCache::RegisterChannel(const ECollisionChannel InChannel)
+{
+    if (Scenes.Contains(InChannel))
+    {
+        return;
+    }
+
+    const double startTime = FPlatformTime::Seconds();
+    FRRLidarStaticScene& scene = Scenes.Add(InChannel);
+    for (TActorIterator<AActor> actorIt(GetWorld()); actorIt; ++actorIt)
+    {
+        AddActor(*actorIt, InChannel, scene);
+    }
+    UpdateScenes();
+
+    UE_LOG_WITH_INFO(LogRapyutaCore,
+                     Log,
+                     TEXT("Built static geometry cache of channel %d: %d components, %d triangles in %.1fms%s"),
+                     static_cast<int32>(InChannel),
+                     scene.Meshes.Num(),
+                     NumTriangles,
+                     (FPlatformTime::Seconds() - startTime) * 1000.0,
+                     scene.bComplete ? TEXT("") : TEXT(", incomplete thus static objects are still traced in physics scene"));
+}
+
+bool URRLidarStaticGeometryCache::IsSceneComplete(const ECollisionChannel InChannel) const
+{
+    const FRRLidarStaticScene* scene = Scenes.Find(InChannel);
+    return scene && scene->bComplete;
+}
+
+void URRLidarStaticGeometryCache::AddActor(AActor* InActor, const ECollisionChannel InChannel, FRRLidarStaticScene& InOutScene)
+{
+    if (!IsValid(InActor))
+    {
+        return;
+    }
+
+    TInlineComponentArray<UPrimitiveComponent*> components(InActor);
+    for (UPrimitiveComponent* component : components)
+    {
+        // Stationary components can not move either, and are static shapes for physics queries
+        if (!component->IsRegistered() || (component->Mobility == EComponentMobility::Movable) ||
+            !component->IsQueryCollisionEnabled() || (component->GetCollisionResponseToChannel(InChannel) != ECR_Block))
+        {
+            continue;
+        }
+
+        FRRStaticMeshBVH mesh;
+        UStaticMeshComponent* staticMeshComponent = Cast<UStaticMeshComponent>(component);
+        if ((staticMeshComponent == nullptr) || !BuildMeshBVH(staticMeshComponent, mesh))
+        {
+            UE_LOG_WITH_INFO(LogRapyutaCore,
+                             Warning,
+                             TEXT("[%s] static component [%s] can not be cached, thus is traced in physics scene."),
+                             *InActor->GetName(),
+                             *component->GetName());
+            InOutScene.bComplete = false;
+            continue;
+        }
+        if (mesh.GetNumTriangles() == 0)
+        {
+            continue;
+        }
+
+        mesh.Actor = InActor;
+        mesh.ActorId = InActor->GetUniqueID();
+        NumTriangles += mesh.GetNumTriangles();
+        InOutScene.Meshes.Add(MoveTemp(mesh));
+        InOutScene.bDirty = true;
+    }
+}
+
+bool URRLidarStaticGeometryCache::BuildMeshBVH(UStaticMeshComponent* InComponent, FRRStaticMeshBVH& OutMesh)
+{
+    OutMesh.Component = InComponent;
+    OutMesh.ComponentId = InComponent->GetUniqueID();
+
+    UStaticMesh* staticMesh = InComponent->GetStaticMesh();
+    if (staticMesh == nullptr)
+    {
+        return true;
+    }
+
+    // Triangles in component frame, as complex traces see them
+    TArray<FVector> localVertices;
+    TArray<int32> localFaceIndices;
+    TArray<uint16> localMaterialIndices;
+    const UBodySetup* bodySetup = staticMesh->GetBodySetup();
+    if (bodySetup && (bodySetup->GetCollisionTraceFlag() == CTF_UseSimpleAsComplex))
+    {
+        if (!GetSimpleCollisionTriangles(bodySetup->AggGeom, localVertices))
+        {
+            return false;
+        }
+        const int32 nLocalTriangles = localVertices.Num() / 3;
+        localFaceIndices.Init(INDEX_NONE, nLocalTriangles);
+        localMaterialIndices.Init(
+            static_cast<uint16>(OutMesh.PhysMaterials.Add(InComponent->BodyInstance.GetSimplePhysicalMaterial())),
+            nLocalTriangles);
+    }
+    else if (!GetComplexCollisionTriangles(
+                 InComponent, localVertices, localFaceIndices, localMaterialIndices, OutMesh.PhysMaterials))
+    {
+        return false;
+    }
+
+    TArray<FTransform> transforms;
+    const UInstancedStaticMeshComponent* instancedComponent = Cast<UInstancedStaticMeshComponent>(InComponent);
+    if (instancedComponent)
+    {
+        transforms.SetNum(instancedComponent->GetInstanceCount());
+        for (int32 i = 0; i < transforms.Num(); ++i)
+        {
+            instancedComponent->GetInstanceTransform(i, transforms[i], true);
+        }
+    }
+    else
+    {
+        transforms.Add(InComponent->GetComponentTransform());
+    }
+
+    TArray<FVector3f> vertices;
+    TArray<FBox3f> triangleBounds;
+    vertices.Reserve(transforms.Num() * localVertices.Num());
+    triangleBounds.Reserve(transforms.Num() * localFaceIndices.Num());
+    for (const FTransform& transform : transforms)
+    {
+        for (int32 tri = 0; tri < localFaceIndices.Num(); ++tri)
+        {
+            for (int32 corner = 0; corner < 3; ++corner)
+            {
+                vertices.Add(FVector3f(transform.TransformPosition(localVertices[3 * tri + corner])));
+            }
+            triangleBounds.Add(FBox3f(&vertices[vertices.Num() - 3], 3));
+            OutMesh.FaceIndices.Add(localFaceIndices[tri]);
+            OutMesh.MaterialIndices.Add(localMaterialIndices[tri]);
+        }
+    }
+
+    // Reorder triangles by BVH leaves for locality
+    TArray<int32> triangleOrder;
+    BuildBVH(triangleBounds, OutMesh.Nodes, triangleOrder);
+    const TArray<int32> faceIndices = MoveTemp(OutMesh.FaceIndices);
+    const TArray<uint16> materialIndices = MoveTemp(OutMesh.MaterialIndices);
+    OutMesh.Vertices.SetNumUninitialized(vertices.Num());
+    OutMesh.FaceIndices.SetNumUninitialized(faceIndices.Num());
+    OutMesh.MaterialIndices.SetNumUninitialized(materialIndices.Num());
+    OutMesh.Bounds = FBox3f(ForceInit);
+    for (int32 i = 0; i < triangleOrder.Num(); ++i)
+    {
+        const int32 src = triangleOrder[i];
+        FMemory::Memcpy(&OutMesh.Vertices[3 * i], &vertices[3 * src], 3 * sizeof(FVector3f));
+        OutMesh.FaceIndices[i] = faceIndices[src];
+        OutMesh.MaterialIndices[i] = materialIndices[src];
+        OutMesh.Bounds += triangleBounds[src];
+    }
+    return true;
+}
+
+void URRLidarStaticGeometryCache::UpdateScenes()
+{
+    for (auto& channelScene : Scenes)
+    {
+        FRRLidarStaticScene& scene = channelScene.Value;
+        if (!scene.bDirty)
+        {
+            continue;
+        }
+
+        TArray<FBox3f> meshBounds;
+        meshBounds.Reserve(scene.Meshes.Num());
+        for (const FRRStaticMeshBVH& mesh : scene.Meshes)
+        {
+            meshBounds.Add(mesh.Bounds);
+        }
+        BuildBVH(meshBounds, scene.Nodes, scene.MeshOrder);
+        scene.bDirty = false;
+    }
+}
+
+void URRLidarStaticGeometryCache::OnActorSpawned(AActor* InActor)
+{
+    for (auto& channelScene : Scenes)
+    {
+        AddActor(InActor, channelScene.Key, channelScene.Value);
+    }
+}
+
+void URRLidarStaticGeometryCache::OnActorDestroyed(AActor* InActor)
+{
+    for (auto& channelScene : Scenes)
+    {
+        FRRLidarStaticScene& scene = channelScene.Value;
+        const int32 nRemoved = scene.Meshes.RemoveAll(
+            [this, InActor](const FRRStaticMeshBVH& InMesh)
+            {
+                if (InMesh.Actor == InActor)
+                {
+                    NumTriangles -= InMesh.GetNumTriangles();
+                    return true;
+                }
+                return false;
+            });
+        scene.bDirty |= (nRemoved > 0);
+    }
+}
+
+bool URRLidarStaticGeometryCache::Raycast(const ECollisionChannel InChannel,
+                                          const FVector& InStart,
+                                          const FVector& InEnd,
+                                          const FCollisionQueryParams& InParams,
+                                          FHitResult& OutHit) const
+{
+    OutHit = FHitResult();
+    OutHit.TraceStart = InStart;
+    OutHit.TraceEnd = InEnd;
+
+    const FRRLidarStaticScene* scene = Scenes.Find(InChannel);
+    if ((scene == nullptr) || scene->bDirty)
+    {
+        return false;
+    }
+
+    const FBVHRay ray(InStart, InEnd);
+    float hitT = 1.f;
+    int32 hitMesh = INDEX_NONE;
+    int32 hitTriangle = INDEX_NONE;
+    TraverseBVH(scene->Nodes,
+                ray,
+                hitT,
+                [scene, &ray, &InParams, &hitMesh, &hitTriangle](const int32 InFirst, const int32 InCount, float& InOutT)
+                {
+                    for (int32 i = InFirst; i < InFirst + InCount; ++i)
+                    {
+                        const int32 meshIndex = scene->MeshOrder[i];
+                        const FRRStaticMeshBVH& mesh = scene->Meshes[meshIndex];
+                        if (InParams.GetIgnoredActors().Contains(mesh.ActorId) ||
+                            InParams.GetIgnoredComponents().Contains(mesh.ComponentId))
+                        {
+                            continue;
+                        }
+                        TraverseBVH(mesh.Nodes,
+                                    ray,
+                                    InOutT,
+                                    [&mesh, &ray, &hitMesh, &hitTriangle, meshIndex](
+                                        const int32 InFirstTriangle, const int32 InTriangleCount, float& InOutMeshT)
+                                    {
+                                        for (int32 tri = InFirstTriangle; tri < InFirstTriangle + InTriangleCount; ++tri)
+                                        {
+                                            const FVector3f* v = &mesh.Vertices[3 * tri];
+                                            if (ray.IntersectTriangle(v[0], v[1], v[2], InOutMeshT))
+                                            {
+                                                hitMesh = meshIndex;
+                                                hitTriangle = tri;
+                                            }
+                                        }
+                                    });
+                    }
+                });
+    if (hitMesh == INDEX_NONE)
+    {
+        return false;
+    }
+
+    const FRRStaticMeshBVH& mesh = scene->Meshes[hitMesh];
+    const FVector3f* v = &mesh.Vertices[3 * hitTriangle];
+    const FVector traceDir = InEnd - InStart;
+    FVector normal = FVector(FVector3f::CrossProduct(v[2] - v[0], v[1] - v[0]).GetSafeNormal());
+    if (FVector::DotProduct(normal, traceDir) > 0.f)
+    {
+        normal = -normal;
+    }
+
+    OutHit.bBlockingHit = true;
+    OutHit.Time = hitT;
+    OutHit.Distance = hitT * traceDir.Size();
+    OutHit.Location = OutHit.ImpactPoint = InStart + hitT * traceDir;
+    OutHit.Normal = OutHit.ImpactNormal = normal;
+    OutHit.FaceIndex = mesh.FaceIndices[hitTriangle];
+    OutHit.Component = mesh.Component;
+    OutHit.HitObjectHandle = FActorInstanceHandle(mesh.Actor);
+    if (InParams.bReturnPhysicalMaterial)
+    {
+        OutHit.PhysMaterial = mesh.PhysMaterials[mesh.MaterialIndices[hitTriangle]];
+    }
+    return true;
+}
@@ -0,0 +1,146 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+#include "Sensors/RRLidarTraceScheduler.h"
+
+// UE
+#include "Async/ParallelFor.h"
+#include "Kismet/GameplayStatics.h"
+
+DECLARE_CYCLE_STAT(TEXT("Lidar scheduled traces"), STAT_RRLidarScheduledTraces, STATGROUP_RRLidar);
+
+void URRLidarTraceScheduler::RegisterLidar(URRBaseLidarComponent* InLidar)
+{
+    if ((InLidar == nullptr) || ScheduledLidars.ContainsByPredicate([InLidar](const FRRScheduledLidar& InScheduledLidar)
+                                                                    { return InScheduledLidar.Lidar.Get() == InLidar; }))
+    {
+        return;
+    }
+
+    // Golden ratio low discrepancy sequence: phases of lidars with the same frequency stay evenly spread whatever their count.
+    static constexpr double GOLDEN_RATIO_CONJUGATE = 0.6180339887498949;
+    const double phase = FMath::Frac(GOLDEN_RATIO_CONJUGATE * NumRegistrations++);
+    const double period = 1.0 / static_cast<double>(FMath::Max(InLidar->PublicationFrequencyHz, 1));
+
+    FRRScheduledLidar& scheduledLidar = ScheduledLidars.AddDefaulted_GetRef();
+    scheduledLidar.Lidar = InLidar;
+    scheduledLidar.NextUpdateTime = UGameplayStatics::GetTimeSeconds(GetWorld()) + phase * period;
+    NumRegisteredLidars = ScheduledLidars.Num();
+}
+
+void URRLidarTraceScheduler::UnregisterLidar(URRBaseLidarComponent* InLidar)
+{
+    ScheduledLidars.RemoveAll([InLidar](const FRRScheduledLidar& InScheduledLidar)
+                              { return !InScheduledLidar.Lidar.IsValid() || (InScheduledLidar.Lidar.Get() == InLidar); });
+    NumRegisteredLidars = ScheduledLidars.Num();
+
+    const int32 nRemovedScans =
+        QueuedScans.RemoveAll([InLidar](const FRRQueuedLidarScan& InQueuedScan) { return InQueuedScan.Lidar == InLidar; });
+    if (nRemovedScans > 0)
+    {
+        InLidar->CancelScan();
+    }
+}
+
+void URRLidarTraceScheduler::QueueScan(URRBaseLidarComponent* InLidar, const FCollisionQueryParams& InTraceParams)
+{
+    FRRQueuedLidarScan& queuedScan = QueuedScans.AddDefaulted_GetRef();
+    queuedScan.Lidar = InLidar;
+    queuedScan.TraceParams = InTraceParams;
+}
+
+void URRLidarTraceScheduler::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    const double now = UGameplayStatics::GetTimeSeconds(GetWorld());
+    for (int32 i = ScheduledLidars.Num() - 1; i >= 0; --i)
+    {
+        FRRScheduledLidar& scheduledLidar = ScheduledLidars[i];
+        URRBaseLidarComponent* lidar = scheduledLidar.Lidar.Get();
+        if (lidar == nullptr)
+        {
+            ScheduledLidars.RemoveAtSwap(i);
+            continue;
+        }
+        if (now < scheduledLidar.NextUpdateTime)
+        {
+            continue;
+        }
+
+        // Keep the same period grid as a looping timer. Missed updates are skipped, as lidar can not start more than one scan
+        // per frame anyway.
+        const double period = 1.0 / static_cast<double>(FMath::Max(lidar->PublicationFrequencyHz, 1));
+        scheduledLidar.NextUpdateTime += period * (FMath::FloorToDouble((now - scheduledLidar.NextUpdateTime) / period) + 1.0);
+        lidar->SensorUpdate();
+    }
+    NumRegisteredLidars = ScheduledLidars.Num();
+
+    FlushQueuedScans();
+
+    const double platformNow = FPlatformTime::Seconds();
+    const double windowDuration = platformNow - RaysPerSecondWindowStart;
+    if (windowDuration >= RAYS_PER_SECOND_WINDOW)
+    {
+        RaysPerSecond = (RaysPerSecondWindowStart > 0.0) ? static_cast<float>(NumWindowRays / windowDuration) : 0.f;
+        NumWindowRays = 0;
+        RaysPerSecondWindowStart = platformNow;
+    }
+}
+
+void URRLidarTraceScheduler::FlushQueuedScans()
+{
+    if (QueuedScans.Num() == 0)
+    {
+        return;
+    }
+
+    SCOPE_CYCLE_COUNTER(STAT_RRLidarScheduledTraces);
+#if TRACE_ASYNC
+    // Async traces of a frame are already executed in parallel as a single batch by the world.
+    for (const FRRQueuedLidarScan& queuedScan : QueuedScans)
+    {
+        NumWindowRays += queuedScan.Lidar->TracingScan.Hits.Num();
+        queuedScan.Lidar->IssueAsyncTraces(queuedScan.TraceParams);
+    }
+#else
+    // Flatten rays of all scans into batches, thus a single ParallelFor traces all of them.
+    struct FRayBatch
+    {
+        int32 ScanIndex;
+        int32 StartIndex;
+        int32 EndIndex;
+    };
+    TArray<FRayBatch> rayBatches;
+    for (int32 scanIndex = 0; scanIndex < QueuedScans.Num(); ++scanIndex)
+    {
+        const int32 nRays = QueuedScans[scanIndex].Lidar->TracingScan.Hits.Num();
+        for (int32 startIndex = 0; startIndex < nRays; startIndex += URRBaseLidarComponent::RAY_BATCH_SIZE)
+        {
+            rayBatches.Add({scanIndex, startIndex, FMath::Min(startIndex + URRBaseLidarComponent::RAY_BATCH_SIZE, nRays)});
+        }
+        NumWindowRays += nRays;
+    }
+
+    ParallelFor(rayBatches.Num(),
+                [this, &rayBatches](int32 InBatchIndex)
+                {
+                    const FRayBatch& rayBatch = rayBatches[InBatchIndex];
+                    const FRRQueuedLidarScan& queuedScan = QueuedScans[rayBatch.ScanIndex];
+                    for (int32 i = rayBatch.StartIndex; i < rayBatch.EndIndex; ++i)
+                    {
+                        queuedScan.Lidar->TraceRay(i, queuedScan.TraceParams);
+                    }
+                });
+
+    for (const FRRQueuedLidarScan& queuedScan : QueuedScans)
+    {
+        queuedScan.Lidar->OnScanTraced();
+    }
+#endif
+    QueuedScans.Reset();
+}
+
+TStatId URRLidarTraceScheduler::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(URRLidarTraceScheduler, STATGROUP_Tickables);
+}
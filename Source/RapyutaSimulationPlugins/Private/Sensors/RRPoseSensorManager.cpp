@@ -71,9 +71,11 @@ void URRPoseSensorManager::UpdateReferenceActorWithTag()
     // do not use GetAllActorsWithTag since it is slow.
     // set nearest actor in z axis as ReferenceActor
     AActor* nearestActor = nullptr;
-    const TArray<AActor*> actors = ServerSimState->EntitiesWithTag.FindRef(FName(ReferenceTag)).Actors;
-    if (actors.Num() > 0)
+    // Tagged actors are iterated in place, without copying them
+    const FRREntities* taggedEntities = ServerSimState->EntitiesWithTag.Find(FName(ReferenceTag));
+    if (taggedEntities && (taggedEntities->Actors.Num() > 0))
     {
+        const TArray<AActor*>& actors = taggedEntities->Actors;
         float sensorPoseZ = GetComponentTransform().GetTranslation().Z;
         int32 nearestActorIndex = 0;
 
@@ -2,8 +2,16 @@
 
 #include "Sensors/RRROS2CameraComponent.h"
 
+#include "Async/Async.h"
 #include "BufferVisualizationData.h"
 
+// rclUE
+#include "logUtilities.h"
+
+// RapyutaSimulationPlugins
+#include "Core/RRCoreUtils.h"
+#include "RapyutaSimulationPlugins.h"
+
 URRROS2CameraComponent::URRROS2CameraComponent()
 {
     // component initialization
@@ -22,29 +30,117 @@ void URRROS2CameraComponent::PreInitializePublisher(UROS2NodeComponent* InROS2No
     SceneCaptureComponent->FOVAngle = CameraComponent->FieldOfView;
     SceneCaptureComponent->OrthoWidth = CameraComponent->OrthoWidth;
 
-    if (CameraType == EROS2CameraType::DEPTH)
+    // Parse encoding
+    if (!URRImageUtils::GetImageEncoding(Encoding, ImageEncoding))
+    {
+        UE_LOG_WITH_INFO(LogRapyutaCore, Warning, TEXT("[%s] Unsupported encoding %s, rgb8 is used."), *GetName(), *Encoding);
+        ImageEncoding = ERRImageEncoding::RGB8;
+        Encoding = URRImageUtils::GetImageEncodingName(ImageEncoding);
+    }
+    const bool bDepthEncoding = URRImageUtils::IsDepthEncoding(ImageEncoding);
+    if (bDepthEncoding && (CameraType != EROS2CameraType::DEPTH))
+    {
+        UE_LOG_WITH_INFO(
+            LogRapyutaCore, Warning, TEXT("[%s] Encoding %s needs depth camera type, rgb8 is used."), *GetName(), *Encoding);
+        ImageEncoding = ERRImageEncoding::RGB8;
+        Encoding = URRImageUtils::GetImageEncodingName(ImageEncoding);
+    }
+    else if (bDepthEncoding && bPublishCompressed)
     {
-        FWeightedBlendable blendable(1.0f, GetBufferVisualizationData().GetMaterial(TEXT("SceneDepth")));
-        CameraComponent->PostProcessSettings.WeightedBlendables.Array.Add(blendable);
-        SceneCaptureComponent->PostProcessSettings = CameraComponent->PostProcessSettings;
-        SceneCaptureComponent->CaptureSource = ESceneCaptureSource::SCS_FinalColorHDR;
+        UE_LOG_WITH_INFO(LogRapyutaCore,
+                         Warning,
+                         TEXT("[%s] Encoding %s can not be compressed, raw image is published."),
+                         *GetName(),
+                         *Encoding);
+        bPublishCompressed = false;
     }
 
     RenderTarget = NewObject<UTextureRenderTarget2D>(this, UTextureRenderTarget2D::StaticClass());
-    RenderTarget->InitCustomFormat(Width, Height, EPixelFormat::PF_B8G8R8A8, true);
+    if (URRImageUtils::IsDepthEncoding(ImageEncoding))
+    {
+        // Scene depth [cm] is written into R channel as is, without post process
+        SceneCaptureComponent->CaptureSource = ESceneCaptureSource::SCS_SceneDepth;
+        RenderTarget->InitCustomFormat(Width, Height, EPixelFormat::PF_R32_FLOAT, true);
+    }
+    else
+    {
+        if (CameraType == EROS2CameraType::DEPTH)
+        {
+            FWeightedBlendable blendable(1.0f, GetBufferVisualizationData().GetMaterial(TEXT("SceneDepth")));
+            CameraComponent->PostProcessSettings.WeightedBlendables.Array.Add(blendable);
+            SceneCaptureComponent->PostProcessSettings = CameraComponent->PostProcessSettings;
+            SceneCaptureComponent->CaptureSource = ESceneCaptureSource::SCS_FinalColorHDR;
+        }
+        RenderTarget->InitCustomFormat(Width, Height, EPixelFormat::PF_B8G8R8A8, true);
+    }
     SceneCaptureComponent->TextureTarget = RenderTarget;
 
     // Initialize image data
-    Data.Header.FrameId = FrameId;
+    const int32 bytesPerPixel = URRImageUtils::GetBytesPerPixel(ImageEncoding);
     Data.Width = Width;
     Data.Height = Height;
     Data.Encoding = Encoding;
-    Data.Step = Width * 3;    // todo should be variable based on encoding
-    Data.Data.AddUninitialized(Width * Height * 3);
+    Data.Step = Width * bytesPerPixel;
 
     QueueSize = QueueSize < 1 ? 1 : QueueSize;    // QueueSize should be more than 1
+    RenderRequests.Init(QueueSize,
+                        [this](FRenderRequest& InRenderRequest)
+                        {
+                            if (URRImageUtils::IsDepthEncoding(ImageEncoding))
+                            {
+                                InRenderRequest.DepthImage.SetNumUninitialized(Width * Height);
+                            }
+                            else
+                            {
+                                InRenderRequest.Image.SetNumUninitialized(Width * Height);
+                            }
+                        });
+
+    FString topicName = InTopicName.IsEmpty() ? TopicName : InTopicName;
+    if (bPublishCompressed)
+    {
+        // Image wrapper module can only be loaded on game thread
+        URRCoreUtils::LoadImageWrapperModule();
+        MsgClass = UROS2CompressedImageMsg::StaticClass();
+        topicName += TEXT("/compressed");
+
+        const bool bIsMono = (ERRImageEncoding::MONO8 == ImageEncoding);
+        CompressedData.Format = FString::Printf(TEXT("%s; %s compressed %s"),
+                                                *Encoding,
+                                                (ERRCompressedImageFormat::JPEG == CompressedFormat) ? TEXT("jpeg") : TEXT("png"),
+                                                bIsMono ? TEXT("mono8") : TEXT("bgr8"));
+        NumCompressionTasks = FMath::Max(NumCompressionTasks, 1);
+        CompressionTasks.Init(NumCompressionTasks,
+                              [this](FRRImageCompressionTask& InTask) { InTask.Input.SetNumUninitialized(Width * Height); });
+    }
+    else
+    {
+        Data.Data.SetNumUninitialized(Width * Height * bytesPerPixel);
+    }
+
+    Super::PreInitializePublisher(InROS2Node, topicName);
 
-    Super::PreInitializePublisher(InROS2Node, InTopicName);
+    // FrameId may have been prefixed with node namespace
+    Data.Header.FrameId = FrameId;
+    CompressedData.Header.FrameId = FrameId;
+}
+
+void URRROS2CameraComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    while (FRRImageCompressionTask* compressionTask = CompressionTasks.PeekOldest())
+    {
+        compressionTask->Future.Wait();
+        compressionTask->Future.Reset();
+        CompressionTasks.PopOldest();
+    }
+
+    // Dropped requests were issued before the ones in flight, thus they are done as well.
+    while (FRenderRequest* renderRequest = RenderRequests.PeekOldest())
+    {
+        renderRequest->RenderFence.Wait();
+        RenderRequests.PopOldest();
+    }
+    Super::EndPlay(EndPlayReason);
 }
 
 void URRROS2CameraComponent::SensorUpdate()
@@ -66,74 +162,174 @@ void URRROS2CameraComponent::CaptureNonBlocking()
     {
         FRenderTarget* SrcRenderTarget;
         TArray<FColor>* OutData;
+        //! Used instead of OutData if not null
+        TArray<FLinearColor>* OutDepthData;
         FIntRect Rect;
         FReadSurfaceDataFlags Flags;
     };
 
-    // Init new RenderRequest
-    FRenderRequest* renderRequest = new FRenderRequest();
+    // Reuse a RenderRequest of the ring. If the oldest one is dropped, its pending readback is executed before the new one,
+    // since render commands are executed in order.
+    FRenderRequest* renderRequest = &RenderRequests.Push();
 
-    // Setup GPU command
+    // Setup GPU command. Depth is read back as is, without normalization.
+    const bool bDepthEncoding = URRImageUtils::IsDepthEncoding(ImageEncoding);
     FReadSurfaceContext readSurfaceContext = {
         renderTargetResource,
         &(renderRequest->Image),
+        bDepthEncoding ? &(renderRequest->DepthImage) : nullptr,
         FIntRect(0, 0, renderTargetResource->GetSizeXY().X, renderTargetResource->GetSizeXY().Y),
-        FReadSurfaceDataFlags(RCM_UNorm, CubeFace_MAX)};
+        FReadSurfaceDataFlags(bDepthEncoding ? RCM_MinMax : RCM_UNorm, CubeFace_MAX)};
 
     // Above 4.22 use this
     ENQUEUE_RENDER_COMMAND(SceneDrawCompletion)
     (
         [readSurfaceContext, this](FRHICommandListImmediate& RHICmdList)
         {
-            RHICmdList.ReadSurfaceData(readSurfaceContext.SrcRenderTarget->GetRenderTargetTexture(),
-                                       readSurfaceContext.Rect,
-                                       *readSurfaceContext.OutData,
-                                       readSurfaceContext.Flags);
+            if (readSurfaceContext.OutDepthData)
+            {
+                RHICmdList.ReadSurfaceData(readSurfaceContext.SrcRenderTarget->GetRenderTargetTexture(),
+                                           readSurfaceContext.Rect,
+                                           *readSurfaceContext.OutDepthData,
+                                           readSurfaceContext.Flags);
+            }
+            else
+            {
+                RHICmdList.ReadSurfaceData(readSurfaceContext.SrcRenderTarget->GetRenderTargetTexture(),
+                                           readSurfaceContext.Rect,
+                                           *readSurfaceContext.OutData,
+                                           readSurfaceContext.Flags);
+            }
         });
 
-    // Notify new task in RenderQueue
-    RenderRequestQueue.Enqueue(renderRequest);
-    if (QueueCount > QueueSize)
+    // Set RenderCommandFence
+    renderRequest->RenderFence.BeginFence();
+
+    NumRequestsInFlight = RenderRequests.GetNumInFlight();
+    NumDroppedRequests = RenderRequests.GetNumDropped();
+}
+
+void URRROS2CameraComponent::UpdateImageData()
+{
+    // Peek the next RenderRequest from ring
+    FRenderRequest* nextRenderRequest = RenderRequests.PeekOldest();
+    if (nextRenderRequest == nullptr)
     {
-        RenderRequestQueue.Pop();
+        return;
     }
-    else
+
+    // Timestamp
+    Data.Header.Stamp = URRConversionUtils::FloatToROSStamp(UGameplayStatics::GetTimeSeconds(GetWorld()));
+
+    if (nextRenderRequest->RenderFence.IsFenceComplete())
+    {    // Check if rendering is done, indicated by RenderFence
+        const int32 nDataPixels = Data.Data.Num() / URRImageUtils::GetBytesPerPixel(ImageEncoding);
+        if (URRImageUtils::IsDepthEncoding(ImageEncoding))
+        {
+            const int32 nPixels = FMath::Min(nextRenderRequest->DepthImage.Num(), nDataPixels);
+            URRImageUtils::ConvertDepth(
+                nextRenderRequest->DepthImage.GetData(), nPixels, ImageEncoding, MinDepth, MaxDepth, Data.Data.GetData());
+        }
+        else
+        {
+            const int32 nPixels = FMath::Min(nextRenderRequest->Image.Num(), nDataPixels);
+            URRImageUtils::ConvertBGRA(nextRenderRequest->Image.GetData(), nPixels, ImageEncoding, Data.Data.GetData());
+        }
+
+        // Release the first element of the ring, to be reused by next captures
+        RenderRequests.PopOldest();
+        NumRequestsInFlight = RenderRequests.GetNumInFlight();
+    }
+}
+
+void URRROS2CameraComponent::UpdateCompressedImageData()
+{
+    // Finished compressions are taken in capture order, thus the latest one overwrites older ones
+    while (FRRImageCompressionTask* compressionTask = CompressionTasks.PeekOldest())
     {
-        QueueCount++;
+        if (!compressionTask->Future.IsReady())
+        {
+            break;
+        }
+        compressionTask->Future.Reset();
+
+        const TArray64<uint8>& output = compressionTask->Output;
+        CompressedData.Header.Stamp = compressionTask->Stamp;
+        CompressedData.Data.SetNumUninitialized(output.Num(), false);
+        FMemory::Memcpy(CompressedData.Data.GetData(), output.GetData(), output.Num());
+
+        CompressionLatency = (compressionTask->EndTime - compressionTask->StartTime) * 1000.0;
+        const int64 rawSize = static_cast<int64>(Width) * Height * URRImageUtils::GetBytesPerPixel(ImageEncoding);
+        CompressionRatio = (output.Num() > 0) ? static_cast<double>(rawSize) / output.Num() : 0.f;
+        CompressionTasks.PopOldest();
     }
 
-    // Set RenderCommandFence
-    renderRequest->RenderFence.BeginFence();
+    while (CompressionTasks.GetNumInFlight() < CompressionTasks.GetDepth())
+    {
+        FRenderRequest* nextRenderRequest = RenderRequests.PeekOldest();
+        if ((nextRenderRequest == nullptr) || !nextRenderRequest->RenderFence.IsFenceComplete())
+        {
+            break;
+        }
+
+        // Take the pixels without copying them. Request keeps the previous input buffer, which has the same size.
+        FRRImageCompressionTask& compressionTask = CompressionTasks.Push();
+        Swap(compressionTask.Input, nextRenderRequest->Image);
+        RenderRequests.PopOldest();
+
+        compressionTask.Stamp = URRConversionUtils::FloatToROSStamp(UGameplayStatics::GetTimeSeconds(GetWorld()));
+        compressionTask.StartTime = FPlatformTime::Seconds();
+        // Tasks are not reallocated after Init, thus the reference stays valid until the task is popped
+        compressionTask.Future =
+            Async(EAsyncExecution::ThreadPool, [this, &compressionTask]() { CompressImage(compressionTask); });
+    }
+    NumRequestsInFlight = RenderRequests.GetNumInFlight();
 }
 
-FROSImg URRROS2CameraComponent::GetROS2Data()
+void URRROS2CameraComponent::CompressImage(FRRImageCompressionTask& InOutTask)
 {
-    if (!RenderRequestQueue.IsEmpty())
-    {
-        // Timestamp
-        Data.Header.Stamp = URRConversionUtils::FloatToROSStamp(UGameplayStatics::GetTimeSeconds(GetWorld()));
-
-        // Peek the next RenderRequest from queue
-        FRenderRequest* nextRenderRequest = nullptr;
-        RenderRequestQueue.Peek(nextRenderRequest);
-        if (nextRenderRequest)
-        {    // nullptr check
-            if (nextRenderRequest->RenderFence.IsFenceComplete())
-            {    // Check if rendering is done, indicated by RenderFence
-                for (int I = 0; I < nextRenderRequest->Image.Num(); I++)
-                {
-                    Data.Data[I * 3 + 0] = nextRenderRequest->Image[I].R;
-                    Data.Data[I * 3 + 1] = nextRenderRequest->Image[I].G;
-                    Data.Data[I * 3 + 2] = nextRenderRequest->Image[I].B;
-                }
-
-                // Delete the first element from RenderQueue
-                RenderRequestQueue.Pop();
-                QueueCount--;
-                delete nextRenderRequest;
+    const FIntPoint imageSize(Width, Height);
+    TArray<FColor>& input = InOutTask.Input;
+    const int32 nPixels = input.Num();
+    const bool bIsJPEG = (ERRCompressedImageFormat::JPEG == CompressedFormat);
+    if (ERRImageEncoding::MONO8 == ImageEncoding)
+    {
+        InOutTask.MonoPixels.SetNumUninitialized(nPixels, false);
+        URRImageUtils::ConvertBGRA(input.GetData(), nPixels, ERRImageEncoding::MONO8, InOutTask.MonoPixels.GetData());
+        URRCoreUtils::CompressImageData(bIsJPEG ? ERRFileType::IMAGE_GRAYSCALE_JPG : ERRFileType::IMAGE_PNG,
+                                        InOutTask.MonoPixels.GetData(),
+                                        nPixels,
+                                        imageSize,
+                                        ERGBFormat::Gray,
+                                        URRActorCommon::IMAGE_BIT_DEPTH_INT8,
+                                        CompressionQuality,
+                                        InOutTask.Output);
+    }
+    else
+    {
+        if (!bIsJPEG)
+        {
+            // Render target alpha is not opacity
+            for (FColor& pixel : input)
+            {
+                pixel.A = 255;
             }
         }
+        URRCoreUtils::CompressImageData(bIsJPEG ? ERRFileType::IMAGE_JPG : ERRFileType::IMAGE_PNG,
+                                        input.GetData(),
+                                        nPixels * input.GetTypeSize(),
+                                        imageSize,
+                                        ERGBFormat::BGRA,
+                                        URRActorCommon::IMAGE_BIT_DEPTH_INT8,
+                                        CompressionQuality,
+                                        InOutTask.Output);
     }
+    InOutTask.EndTime = FPlatformTime::Seconds();
+}
+
+FROSImg URRROS2CameraComponent::GetROS2Data()
+{
+    UpdateImageData();
 
     // SceneCaptureComponent->CaptureScene();
     // FTextureRenderTarget2DResource* RenderTargetResource;
@@ -154,5 +350,14 @@ FROSImg URRROS2CameraComponent::GetROS2Data()
 
 void URRROS2CameraComponent::SetROS2Msg(UROS2GenericMsg* InMessage)
 {
-    CastChecked<UROS2ImgMsg>(InMessage)->SetMsg(GetROS2Data());
+    if (bPublishCompressed)
+    {
+        UpdateCompressedImageData();
+        CastChecked<UROS2CompressedImageMsg>(InMessage)->SetMsg(CompressedData);
+        return;
+    }
+
+    // Set #Data directly instead of copying it through #GetROS2Data
+    UpdateImageData();
+    CastChecked<UROS2ImgMsg>(InMessage)->SetMsg(Data);
 }
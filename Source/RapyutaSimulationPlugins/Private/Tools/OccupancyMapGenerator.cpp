@@ -3,6 +3,8 @@
 #include "Tools/OccupancyMapGenerator.h"
 
 // UE
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
 #include "DrawDebugHelpers.h"
 #include "HAL/PlatformFileManager.h"
 #include "Misc/FileHelper.h"
@@ -12,11 +14,15 @@
 #include "Misc/FileHelper.h"
 
 // RapyutaSimulationPlugins
+#include "Core/RRCoreUtils.h"
 #include "RapyutaSimulationPlugins.h"
 
 // Sets default values
 AOccupancyMapGenerator::AOccupancyMapGenerator()
 {
+    // Only ticks during asynchronous generation
+    PrimaryActorTick.bCanEverTick = true;
+    PrimaryActorTick.bStartWithTickEnabled = false;
 }
 
 // Called when the game starts or when spawned
@@ -30,59 +36,203 @@ void AOccupancyMapGenerator::BeginPlay()
         return;
     }
 
+    if (bGenerateAsync)
+    {
+        GenerateOccupancyGridAsync();
+    }
+    else if (GenerateOccupancyGrid())
+    {
+        SaveOccupancyGrid();
+    }
+}
+
+void AOccupancyMapGenerator::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (GenerationFuture.IsValid())
+    {
+        CancelGeneration();
+        FinishGeneration();
+    }
+    Super::EndPlay(EndPlayReason);
+}
+
+void AOccupancyMapGenerator::Tick(float DeltaSeconds)
+{
+    Super::Tick(DeltaSeconds);
+
+    if (!GenerationFuture.IsValid() || !GenerationFuture.IsReady())
+    {
+        return;
+    }
+
+    if (FinishGeneration())
+    {
+        SaveOccupancyGrid();
+    }
+}
+
+bool AOccupancyMapGenerator::FinishGeneration()
+{
+    const bool bGenerated = GenerationFuture.Get();
+    GenerationFuture.Reset();
+    bGenerating = false;
+    SetActorTickEnabled(false);
+    if (bGenerated)
+    {
+        Swap(OccupancyGrid, AsyncGrid);
+    }
+    AsyncGrid.Empty();
+    return bGenerated;
+}
+
+bool AOccupancyMapGenerator::InitGrid()
+{
+    if (Map == nullptr)
+    {
+        UE_LOG_WITH_INFO_NAMED(LogRapyutaCore, Warning, TEXT("Map is nullptr. Please sepcify Map to generate occupancy map."));
+        return false;
+    }
+
     // this could be done via shader if GPU raycast is accessible
     // result would be saved on texture
-    FVector Center;
-    FVector Extent;
-    Map->GetActorBounds(false, Center, Extent, true);
+    Map->GetActorBounds(false, GridCenter, GridExtent, true);
     UE_LOG_WITH_INFO_NAMED(LogRapyutaCore,
                            Display,
                            TEXT("Generate occupancy map with %s whose center is %s, box extent is %s"),
                            *Map->GetName(),
-                           *Center.ToString(),
-                           *Extent.ToString());
+                           *GridCenter.ToString(),
+                           *GridExtent.ToString());
 
-    FVector Origin = Center - Extent;
+    GridOrigin = GridCenter - GridExtent;
 
     float GridRes_cm = GridRes * 100;
+    NCellsX = 2 * GridExtent.X / GridRes_cm;
+    NCellsY = 2 * GridExtent.Y / GridRes_cm;
+    return true;
+}
 
-    // cell-centered sampling
-    float XPos = Origin.X + GridRes_cm * .5;
-    float YPos = Origin.Y + GridRes_cm * .5;
-
-    int NCellsX = 2 * Extent.X / GridRes_cm;
-    int NCellsY = 2 * Extent.Y / GridRes_cm;
-
-    OccupancyGrid.Reserve(NCellsX * NCellsY);
+bool AOccupancyMapGenerator::TraceGrid(const bool bInParallel, TArray<uint8>& OutGrid)
+{
+    const int32 nCells = NCellsX * NCellsY;
+    OutGrid.SetNumUninitialized(nCells);
+    NumTracedCells = 0;
 
     FCollisionQueryParams TraceParams = FCollisionQueryParams(FName(TEXT("Laser_Trace")), false, this);
     TraceParams.bReturnPhysicalMaterial = false;
     TraceParams.bIgnoreTouches = true;
 
-    UWorld* world = GetWorld();
-    for (auto j = 0; j < NCellsY; j++)
-    {
-        for (auto i = 0; i < NCellsX; i++)
+    // cell-centered sampling, each cell being traced into its own place whatever the order of tiles
+    const float GridRes_cm = GridRes * 100;
+    const int32 tileSize = FMath::Max(TileSize, 1);
+    const int32 nTilesX = FMath::DivideAndRoundUp(NCellsX, tileSize);
+    const int32 nTilesY = FMath::DivideAndRoundUp(NCellsY, tileSize);
+    const UWorld* world = GetWorld();
+    ParallelFor(
+        nTilesX * nTilesY,
+        [&](int32 InTileIndex)
         {
-            FVector OccupancyRayStart(
-                Origin.X + GridRes_cm * (.5 + i), Origin.Y + GridRes_cm * (.5 + j), Center.Z + Extent.Z + GridRes_cm);
-            FVector OccupancyRayEnd(
-                Origin.X + GridRes_cm * (.5 + i), Origin.Y + GridRes_cm * (.5 + j), Center.Z + Extent.Z + MaxVerticalHeight * 100);
-
-            FHitResult hit;
-            world->LineTraceSingleByChannel(hit,
-                                            OccupancyRayStart,
-                                            OccupancyRayEnd,
-                                            ECC_Visibility,
-                                            TraceParams,
-                                            FCollisionResponseParams::DefaultResponseParam);
-
-            OccupancyGrid.Add(hit.bBlockingHit ? 0 : 255);
-        }
+            if (bCancelRequested)
+            {
+                return;
+            }
+
+            const int32 tileX = InTileIndex % nTilesX;
+            const int32 tileY = InTileIndex / nTilesX;
+            const int32 iStart = tileX * tileSize;
+            const int32 iEnd = FMath::Min(iStart + tileSize, NCellsX);
+            const int32 jStart = tileY * tileSize;
+            const int32 jEnd = FMath::Min(jStart + tileSize, NCellsY);
+            for (int32 j = jStart; j < jEnd; j++)
+            {
+                for (int32 i = iStart; i < iEnd; i++)
+                {
+                    FVector OccupancyRayStart(GridOrigin.X + GridRes_cm * (.5 + i),
+                                              GridOrigin.Y + GridRes_cm * (.5 + j),
+                                              GridCenter.Z + GridExtent.Z + GridRes_cm);
+                    FVector OccupancyRayEnd(GridOrigin.X + GridRes_cm * (.5 + i),
+                                            GridOrigin.Y + GridRes_cm * (.5 + j),
+                                            GridCenter.Z + GridExtent.Z + MaxVerticalHeight * 100);
+
+                    FHitResult hit;
+                    world->LineTraceSingleByChannel(hit,
+                                                    OccupancyRayStart,
+                                                    OccupancyRayEnd,
+                                                    ECC_Visibility,
+                                                    TraceParams,
+                                                    FCollisionResponseParams::DefaultResponseParam);
+
+                    OutGrid[j * NCellsX + i] = hit.bBlockingHit ? 0 : 255;
+                }
+            }
+
+            // Log progress every 10%
+            const int64 nTileCells = static_cast<int64>(iEnd - iStart) * (jEnd - jStart);
+            const int64 nPrevTracedCells = NumTracedCells.fetch_add(nTileCells);
+            const int64 prevDecile = nPrevTracedCells * 10 / nCells;
+            const int64 decile = (nPrevTracedCells + nTileCells) * 10 / nCells;
+            if (decile != prevDecile)
+            {
+                UE_LOG_WITH_INFO_NAMED(LogRapyutaCore, Display, TEXT("Occupancy map traced %lld%%"), decile * 10);
+            }
+        },
+        bInParallel ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+
+    if (bCancelRequested)
+    {
+        UE_LOG_WITH_INFO_NAMED(LogRapyutaCore, Warning, TEXT("Occupancy map generation has been cancelled"));
+        return false;
+    }
+    return true;
+}
+
+bool AOccupancyMapGenerator::GenerateOccupancyGrid()
+{
+    if (bGenerating || !InitGrid())
+    {
+        return false;
+    }
+
+    bGenerating = true;
+    bCancelRequested = false;
+    const bool bGenerated = TraceGrid(bParallelTrace, OccupancyGrid);
+    bGenerating = false;
+    return bGenerated;
+}
+
+bool AOccupancyMapGenerator::GenerateOccupancyGridAsync()
+{
+    if (bGenerating || !InitGrid())
+    {
+        return false;
     }
 
+    bGenerating = true;
+    bCancelRequested = false;
+    GenerationFuture = Async(EAsyncExecution::ThreadPool, [this]() { return TraceGrid(bParallelTrace, AsyncGrid); });
+    SetActorTickEnabled(true);
+    return true;
+}
+
+void AOccupancyMapGenerator::CancelGeneration()
+{
+    bCancelRequested = true;
+}
+
+bool AOccupancyMapGenerator::WaitForGeneration()
+{
+    return GenerationFuture.IsValid() && FinishGeneration();
+}
+
+float AOccupancyMapGenerator::GetGenerationProgress() const
+{
+    const int64 nCells = static_cast<int64>(NCellsX) * NCellsY;
+    return (nCells > 0) ? static_cast<float>(static_cast<double>(NumTracedCells) / nCells) : 0.f;
+}
+
+void AOccupancyMapGenerator::SaveOccupancyGrid()
+{
     // write to file
-    bool res = WriteToFile(NCellsX, NCellsY, Origin.X / 100.f, -(Center.Y + Extent.Y) / 100.f);
+    bool res = WriteToFile(NCellsX, NCellsY, GridOrigin.X / 100.f, -(GridCenter.Y + GridExtent.Y) / 100.f);
     if (!res)
     {
         UE_LOG_WITH_INFO(LogRapyutaCore, Error, TEXT("Failed to save files."));
@@ -91,26 +241,61 @@ void AOccupancyMapGenerator::BeginPlay()
 
 bool AOccupancyMapGenerator::WriteToFile(int width, int height, float originx, float originy)
 {
-    FString Directory = FPaths::ProjectContentDir();
-
-    FString TargetFile = Directory + "/" + Filename + ".pgm";
-    FString TargetInfoFile = Directory + "/" + Filename + ".yaml";
-
-    FString yamlContent = "image: " + Filename + ".pgm\n" + "resolution: " + FString::SanitizeFloat(GridRes) + "\n" + "origin: [" +
-                          FString::SanitizeFloat(originx) + ", " + FString::SanitizeFloat(originy) + ", 0.0]\n" + "negate: 0\n" +
-                          "occupied_thresh: 0.65\n" + "free_thresh: 0.196\n";
-
-    FString pgmHeader = "P5\n" + FString::FromInt(width) + " " + FString::FromInt(height) + "\n" + FString::FromInt(255) + "\n";
+    return WriteMapFiles(OccupancyGrid, width, height, originx, originy, FPaths::ProjectContentDir(), Filename, MapFormat);
+}
 
-    TArrayView<uint8> data = OccupancyGrid;
+bool AOccupancyMapGenerator::WriteMapFiles(const TArray<uint8>& InGrid,
+                                           const int32 InWidth,
+                                           const int32 InHeight,
+                                           const float InOriginX,
+                                           const float InOriginY,
+                                           const FString& InDirectory,
+                                           const FString& InFilename,
+                                           const ERROccupancyMapFormat InFormat) const
+{
+    const bool bIsPNG = (ERROccupancyMapFormat::PNG == InFormat);
+    const FString imageFilename = InFilename + (bIsPNG ? TEXT(".png") : TEXT(".pgm"));
+    FString TargetFile = InDirectory + "/" + imageFilename;
+    FString TargetInfoFile = InDirectory + "/" + InFilename + ".yaml";
 
-    bool res = true;
-    res &= FFileHelper::SaveStringToFile(yamlContent, *TargetInfoFile);
-    res &= FFileHelper::SaveStringToFile(pgmHeader, *TargetFile);
-    for (int i = 0; i < height; i++)
+    // Image first, thus .yaml never refers to a missing or partial image
+    bool res = false;
+    if (bIsPNG)
+    {
+        URRCoreUtils::LoadImageWrapperModule();
+        TArray64<uint8> pngData;
+        URRCoreUtils::CompressImageData(ERRFileType::IMAGE_PNG,
+                                        InGrid.GetData(),
+                                        InGrid.Num(),
+                                        FIntPoint(InWidth, InHeight),
+                                        ERGBFormat::Gray,
+                                        8,
+                                        0,
+                                        pngData);
+        res = FFileHelper::SaveArrayToFile(pngData, *TargetFile);
+    }
+    else
+    {
+        // PGM header and cells through a single writer, thus the file is opened once and large rows are not copied
+        TUniquePtr<FArchive> writer(IFileManager::Get().CreateFileWriter(*TargetFile));
+        if (writer)
+        {
+            FString pgmHeader = FString::Printf(TEXT("P5\n%d %d\n255\n"), InWidth, InHeight);
+            auto pgmHeaderChars = StringCast<ANSICHAR>(*pgmHeader);
+            writer->Serialize(const_cast<ANSICHAR*>(pgmHeaderChars.Get()), pgmHeaderChars.Length());
+            writer->Serialize(const_cast<uint8*>(InGrid.GetData()), InGrid.Num());
+            res = writer->Close();
+        }
+    }
+    if (!res)
     {
-        res &= FFileHelper::SaveArrayToFile(data.Slice(i * width, width), *TargetFile, &IFileManager::Get(), FILEWRITE_Append);
+        UE_LOG_WITH_INFO_NAMED(
+            LogRapyutaCore, Error, TEXT("Failed to write %s, thus %s is not written"), *TargetFile, *TargetInfoFile);
+        return false;
     }
 
-    return res;
+    FString yamlContent = "image: " + imageFilename + "\n" + "resolution: " + FString::SanitizeFloat(GridRes) + "\n" +
+                          "origin: [" + FString::SanitizeFloat(InOriginX) + ", " + FString::SanitizeFloat(InOriginY) + ", 0.0]\n" +
+                          "negate: 0\n" + "occupied_thresh: 0.65\n" + "free_thresh: 0.196\n";
+    return FFileHelper::SaveStringToFile(yamlContent, *TargetInfoFile);
 }
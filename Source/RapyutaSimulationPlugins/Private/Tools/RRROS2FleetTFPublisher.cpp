@@ -0,0 +1,140 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+#include "Tools/RRROS2FleetTFPublisher.h"
+
+// UE
+#include "Kismet/GameplayStatics.h"
+
+// rclUE
+#include "ROS2NodeComponent.h"
+
+// RapyutaSimulationPlugins
+#include "Tools/RRROS2OdomPublisher.h"
+
+URRROS2FleetTFPublisher::URRROS2FleetTFPublisher()
+{
+    // Published by URRROS2FleetTFSubsystem::Tick
+    PublicationFrequencyHz = -1;
+}
+
+void URRROS2FleetTFPublisher::RegisterOdomPublisher(URRROS2OdomPublisher* InOdomPublisher)
+{
+    if ((InOdomPublisher == nullptr) || OdomTFs.ContainsByPredicate([InOdomPublisher](const FRRFleetOdomTF& InOdomTF)
+                                                                    { return InOdomTF.OdomPublisher.Get() == InOdomPublisher; }))
+    {
+        return;
+    }
+
+    const double period = 1.0 / static_cast<double>(FMath::Max(InOdomPublisher->PublicationFrequencyHz, 1));
+    FRRFleetOdomTF& odomTF = OdomTFs.AddDefaulted_GetRef();
+    odomTF.OdomPublisher = InOdomPublisher;
+    odomTF.NextTime = period * FMath::CeilToDouble(UGameplayStatics::GetTimeSeconds(GetWorld()) / period);
+    TFMsg.Transforms.Reserve(OdomTFs.Num());
+}
+
+void URRROS2FleetTFPublisher::UnregisterOdomPublisher(URRROS2OdomPublisher* InOdomPublisher)
+{
+    OdomTFs.RemoveAll([InOdomPublisher](const FRRFleetOdomTF& InOdomTF)
+                      { return !InOdomTF.OdomPublisher.IsValid() || (InOdomTF.OdomPublisher.Get() == InOdomPublisher); });
+}
+
+void URRROS2FleetTFPublisher::GetROS2Msg(FROSTFMsg& OutROSTf)
+{
+    const double now = UGameplayStatics::GetTimeSeconds(GetWorld());
+    for (int32 i = OdomTFs.Num() - 1; i >= 0; --i)
+    {
+        FRRFleetOdomTF& odomTF = OdomTFs[i];
+        URRROS2OdomPublisher* odomPublisher = odomTF.OdomPublisher.Get();
+        if (odomPublisher == nullptr)
+        {
+            OdomTFs.RemoveAtSwap(i);
+            continue;
+        }
+        if (now < odomTF.NextTime)
+        {
+            continue;
+        }
+
+        // Keep the same period grid as a looping timer. Missed cycles are skipped, as only the latest odom tf matters.
+        const double period = 1.0 / static_cast<double>(FMath::Max(odomPublisher->PublicationFrequencyHz, 1));
+        odomTF.NextTime += period * (FMath::FloorToDouble((now - odomTF.NextTime) / period) + 1.0);
+
+        FTransform tf;
+        const FRRROS2TFFrameIds* frameIds = odomPublisher->GetOdomTF(tf);
+        if (frameIds)
+        {
+            AddTFtoMsg(OutROSTf, frameIds->FullFrameId, frameIds->FullChildFrameId, tf);
+        }
+    }
+    Super::GetROS2Msg(OutROSTf);
+}
+
+void URRROS2FleetTFSubsystem::RegisterOdomPublisher(URRROS2OdomPublisher* InOdomPublisher)
+{
+    if (InitFleetTFPublisher())
+    {
+        FleetTFPublisher->RegisterOdomPublisher(InOdomPublisher);
+        NumRegisteredOdomPublishers = FleetTFPublisher->GetNumOdomTFs();
+    }
+}
+
+void URRROS2FleetTFSubsystem::UnregisterOdomPublisher(URRROS2OdomPublisher* InOdomPublisher)
+{
+    if (FleetTFPublisher)
+    {
+        FleetTFPublisher->UnregisterOdomPublisher(InOdomPublisher);
+        NumRegisteredOdomPublishers = FleetTFPublisher->GetNumOdomTFs();
+    }
+}
+
+bool URRROS2FleetTFSubsystem::InitFleetTFPublisher()
+{
+    if (FleetTFPublisher)
+    {
+        return true;
+    }
+
+    if (!IsValid(FleetTFNode))
+    {
+        FActorSpawnParameters spawnParams;
+        spawnParams.Name = *FString::Printf(TEXT("%sActor"), *FleetTFNodeName);
+        spawnParams.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+        AActor* nodeActor = GetWorld()->SpawnActor<AActor>(spawnParams);
+        if (nodeActor == nullptr)
+        {
+            UE_LOG_WITH_INFO(LogRapyutaCore, Error, TEXT("Failed to spawn actor of %s"), *FleetTFNodeName);
+            return false;
+        }
+        // (NOTE) [/tf] is in global namespace, and frame ids keep their robot prefix
+        FleetTFNode = UROS2NodeComponent::CreateNewNode(nodeActor, FleetTFNodeName, TEXT("/"));
+    }
+
+    FleetTFPublisher = NewObject<URRROS2FleetTFPublisher>(this);
+    FleetTFNode->AddPublisher(FleetTFPublisher);
+    FleetTFPublisher->StopPublishTimer();
+    return true;
+}
+
+void URRROS2FleetTFSubsystem::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    if ((FleetTFPublisher == nullptr) || (FleetTFPublisher->GetNumOdomTFs() == 0))
+    {
+        return;
+    }
+
+    FleetTFPublisher->UpdateMessage(FleetTFPublisher->TopicMessage);
+    NumRegisteredOdomPublishers = FleetTFPublisher->GetNumOdomTFs();
+    if (FleetTFPublisher->GetNumTransforms() > 0)
+    {
+        FleetTFPublisher->Publish();
+        ++NumPublishedMsgs;
+        NumPublishedTFs += FleetTFPublisher->GetNumTransforms();
+    }
+}
+
+TStatId URRROS2FleetTFSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(URRROS2FleetTFSubsystem, STATGROUP_Tickables);
+}
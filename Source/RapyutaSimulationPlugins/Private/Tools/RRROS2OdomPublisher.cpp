@@ -5,6 +5,7 @@
 // RapyutaSimulationPlugins
 #include "Drives/RobotVehicleMovementComponent.h"
 #include "Robots/RobotVehicle.h"
+#include "Tools/RRROS2FleetTFPublisher.h"
 
 URRROS2OdomPublisher::URRROS2OdomPublisher()
 {
@@ -28,6 +29,18 @@ bool URRROS2OdomPublisher::InitializeWithROS2(UROS2NodeComponent* InROS2Node)
 
 void URRROS2OdomPublisher::InitializeTFWithROS2(UROS2NodeComponent* InROS2Node)
 {
+    if (bPublishOdomTf && bAggregateOdomTf)
+    {
+        URRROS2FleetTFSubsystem* fleetTF = GetWorld()->GetSubsystem<URRROS2FleetTFSubsystem>();
+        if (fleetTF)
+        {
+            fleetTF->RegisterOdomPublisher(this);
+            FleetTFSubsystem = fleetTF;
+            return;
+        }
+        UE_LOG_WITH_INFO(LogRapyutaCore, Warning, TEXT("No fleet tf subsystem, publish odom tf with its own publisher."));
+    }
+
     if (bPublishOdomTf && nullptr == TFPublisher)
     {
         TFPublisher = CastChecked<URRROS2TFPublisher>(
@@ -35,6 +48,22 @@ void URRROS2OdomPublisher::InitializeTFWithROS2(UROS2NodeComponent* InROS2Node)
     }
 }
 
+void URRROS2OdomPublisher::DeInitializeTF()
+{
+    URRROS2FleetTFSubsystem* fleetTF = FleetTFSubsystem.Get();
+    if (fleetTF)
+    {
+        fleetTF->UnregisterOdomPublisher(this);
+    }
+    FleetTFSubsystem.Reset();
+}
+
+void URRROS2OdomPublisher::BeginDestroy()
+{
+    DeInitializeTF();
+    Super::BeginDestroy();
+}
+
 void URRROS2OdomPublisher::UpdateMessage(UROS2GenericMsg* InMessage)
 {
     FROSOdom odomData;
@@ -71,3 +100,21 @@ bool URRROS2OdomPublisher::GetOdomData(FROSOdom& OutOdomData) const
         return false;
     }
 }
+
+const FRRROS2TFFrameIds* URRROS2OdomPublisher::GetOdomTF(FTransform& OutTF)
+{
+    URRBaseOdomComponent* odomSource = Cast<URRBaseOdomComponent>(DataSourceComponent);
+    if (!IsValid(odomSource))
+    {
+        return nullptr;
+    }
+
+    // Same frame ids as GetOdomData, i.e. only ChildFrameId is prefixed
+    static const FString emptyPrefix;
+    OdomTFFrameIds.Update((bAppendNodeNamespace && OwnerNode) ? OwnerNode->Namespace : emptyPrefix,
+                          odomSource->OdomData.Header.FrameId,
+                          odomSource->OdomData.ChildFrameId,
+                          false);
+    OutTF = odomSource->GetOdomTF();
+    return &OdomTFFrameIds;
+}
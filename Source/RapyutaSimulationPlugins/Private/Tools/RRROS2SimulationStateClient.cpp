@@ -237,7 +237,7 @@ void URRROS2SimulationStateClient::ServerAttach_Implementation(const FROSAttachR
     ServerSimState->ServerAttach(InRequest);
 }
 
-FROSSpawnEntityRes URRROS2SimulationStateClient::SpawnEntityImpl(FROSSpawnEntityReq& InRequest)
+FROSSpawnEntityRes URRROS2SimulationStateClient::CheckSpawnEntity(const FROSSpawnEntityReq& InRequest)
 {
     FROSSpawnEntityRes response;
     response.bSuccess = CheckSpawnableEntity(InRequest.Xml, false) && CheckEntity(InRequest.State.ReferenceFrame, true);
@@ -255,30 +255,7 @@ FROSSpawnEntityRes URRROS2SimulationStateClient::SpawnEntityImpl(FROSSpawnEntity
             response.StatusMessage = FString::Printf(
                 TEXT("[%s] Failed to spawn entity of model [%s]. Entity Name is empty"), *GetName(), *entityModelName);
         }
-        else if (nullptr == URRGeneralUtils::FindActorByName<AActor>(GetWorld(), entityName))
-        {
-            // RPC to Server's Spawn entity
-            ServerSpawnEntity(InRequest);
-
-            // RPC is not blocking and can't get actor even if it is spawned.
-            // todo: handle failed to spawn with collision and etc.
-
-            // AActor* newEntity = URRGeneralUtils::FindActorByName<AActor>(GetWorld(), entityName);
-            // if (nullptr == newEntity)
-            // {
-            //     response.bSuccess = false;
-            //     response.StatusMessage =
-            //         FString::Printf(TEXT("[%s] Failed to spawn entity named %s, probably out of collision!"), *GetName(),
-            //         *entityName);
-            // }
-            // else
-            // {
-            response.bSuccess = true;
-            // response.StatusMessage = FString::Printf(TEXT("Spawning Entity of model [%s] as [%s]"), *entityModelName,
-            // *entityName);
-            // }
-        }
-        else
+        else if (nullptr != URRGeneralUtils::FindActorByName<AActor>(GetWorld(), entityName))
         {
             response.bSuccess = false;
             response.StatusMessage = FString::Printf(
@@ -289,6 +266,20 @@ FROSSpawnEntityRes URRROS2SimulationStateClient::SpawnEntityImpl(FROSSpawnEntity
     return response;
 }
 
+FROSSpawnEntityRes URRROS2SimulationStateClient::SpawnEntityImpl(FROSSpawnEntityReq& InRequest)
+{
+    FROSSpawnEntityRes response = CheckSpawnEntity(InRequest);
+    if (response.bSuccess)
+    {
+        // RPC to Server's Spawn entity
+        ServerSpawnEntity(InRequest);
+
+        // RPC is not blocking and can't get actor even if it is spawned.
+        // todo: handle failed to spawn with collision and etc.
+    }
+    return response;
+}
+
 void URRROS2SimulationStateClient::SpawnEntitySrv(UROS2GenericSrv* InService)
 {
     UROS2SpawnEntitySrv* SpawnEntityService = Cast<UROS2SpawnEntitySrv>(InService);
@@ -304,35 +295,110 @@ void URRROS2SimulationStateClient::SpawnEntitiesSrv(UROS2GenericSrv* InService)
     FROSSpawnEntitiesReq entityListRequest;
     spawnEntitiesService->GetRequest(entityListRequest);
 
-    int32 numEntitySpawned = 0;
-    FString statusMessage;
-    for (uint32 i = 0; i < entityListRequest.State.Num(); ++i)
+    const int32 nRequestedEntities = entityListRequest.State.Num();
+    UE_LOG_WITH_INFO(LogRapyutaCore, Log, TEXT("Spawning %d entities"), nRequestedEntities);
+
+    // Check all entities, and batch valid ones into a single request
+    TArray<FString> statusMessages;
+    statusMessages.SetNum(nRequestedEntities);
+    FROSSpawnEntitiesReq validRequest;
+    validRequest.Tags = entityListRequest.Tags;
+    validRequest.Type.Reserve(nRequestedEntities);
+    validRequest.State.Reserve(nRequestedEntities);
+    TArray<int32> validIndices;
+    validIndices.Reserve(nRequestedEntities);
+    TSet<FString> requestedNames;
+    requestedNames.Reserve(nRequestedEntities);
+    // Valid entities so far, which are spawned before next ones and thus can be their reference frame
+    TSet<FString> validNames;
+    validNames.Reserve(nRequestedEntities);
+    FROSSpawnEntityReq entityRequest;
+    entityRequest.RobotNamespace = EMPTY_STR;
+    entityRequest.Tags = entityListRequest.Tags;
+    for (int32 i = 0; i < nRequestedEntities; ++i)
     {
-        UE_LOG_WITH_INFO(LogRapyutaCore,
-                         Log,
-                         TEXT("Spawning Entity : %s (name: %s)"),
-                         *entityListRequest.Type[i],
-                         *entityListRequest.State[i].Name);
-        FROSSpawnEntityReq entityRequest;
-        entityRequest.Xml = entityListRequest.Type[i];
-        entityRequest.RobotNamespace = EMPTY_STR;
+        entityRequest.Xml = entityListRequest.Type.IsValidIndex(i) ? entityListRequest.Type[i] : EMPTY_STR;
         entityRequest.State = entityListRequest.State[i];
-        entityRequest.Tags = entityListRequest.Tags;
 
-        FROSSpawnEntityRes res = SpawnEntityImpl(entityRequest);
+        bool bNameRequested = false;
+        requestedNames.Emplace(entityRequest.State.Name, &bNameRequested);
+        const bool bBatchReferenceFrame = validNames.Contains(entityRequest.State.ReferenceFrame);
+        if (bBatchReferenceFrame)
+        {
+            entityRequest.State.ReferenceFrame.Reset();
+        }
+        FROSSpawnEntityRes res = CheckSpawnEntity(entityRequest);
+        if (bBatchReferenceFrame)
+        {
+            entityRequest.State.ReferenceFrame = entityListRequest.State[i].ReferenceFrame;
+        }
+        if (res.bSuccess && bNameRequested)
+        {
+            res.bSuccess = false;
+            res.StatusMessage = FString::Printf(TEXT("[%s] Failed to spawn entity named %s, given name is requested twice!"),
+                                                *GetName(),
+                                                *entityRequest.State.Name);
+        }
         if (res.bSuccess)
         {
-            numEntitySpawned++;
+            validNames.Emplace(entityRequest.State.Name);
+            validRequest.Type.Emplace(MoveTemp(entityRequest.Xml));
+            validRequest.State.Emplace(MoveTemp(entityRequest.State));
+            validIndices.Emplace(i);
         }
-        statusMessage.Append(FString::Printf(TEXT("%s:%s, "), *entityRequest.State.Name, *res.StatusMessage));
+        statusMessages[i] = MoveTemp(res.StatusMessage);
+    }
+
+    int32 numEntitySpawned = validIndices.Num();
+    if (validIndices.Num() > 0)
+    {
+        if (GetOwner() && GetOwner()->HasAuthority())
+        {
+            // Spawn directly, to get result of each entity
+            TArray<FString> spawnStatusMessages;
+            numEntitySpawned = ServerSimState->ServerSpawnEntities(validRequest, NetworkPlayerId, spawnStatusMessages);
+            for (int32 i = 0; i < validIndices.Num(); ++i)
+            {
+                statusMessages[validIndices[i]] = MoveTemp(spawnStatusMessages[i]);
+            }
+        }
+        else
+        {
+            // RPCs to Server's SpawnEntities, which are not blocking. Reliable RPCs are received in order, thus entities of a
+            // batch can refer to ones of previous batches.
+            const int32 batchSize = FMath::Max(SpawnEntitiesRPCBatchSize, 1);
+            FROSSpawnEntitiesReq batchRequest;
+            batchRequest.Tags = validRequest.Tags;
+            for (int32 batchStart = 0; batchStart < validIndices.Num(); batchStart += batchSize)
+            {
+                const int32 batchNum = FMath::Min(batchSize, validIndices.Num() - batchStart);
+                batchRequest.Type.Reset(batchNum);
+                batchRequest.State.Reset(batchNum);
+                batchRequest.Type.Append(validRequest.Type.GetData() + batchStart, batchNum);
+                batchRequest.State.Append(validRequest.State.GetData() + batchStart, batchNum);
+                ServerSpawnEntities(batchRequest);
+            }
+        }
+    }
+
+    FString statusMessage;
+    for (int32 i = 0; i < nRequestedEntities; ++i)
+    {
+        statusMessage.Append(FString::Printf(TEXT("%s:%s, "), *entityListRequest.State[i].Name, *statusMessages[i]));
     }
 
     FROSSpawnEntitiesRes entityListResponse;
-    entityListResponse.bSuccess = (numEntitySpawned == entityListRequest.State.Num());
-    entityListResponse.StatusMessage = statusMessage;
+    entityListResponse.bSuccess = (numEntitySpawned == nRequestedEntities);
+    entityListResponse.StatusMessage = MoveTemp(statusMessage);
     spawnEntitiesService->SetResponse(entityListResponse);
 }
 
+void URRROS2SimulationStateClient::ServerSpawnEntities_Implementation(const FROSSpawnEntitiesReq& InRequest)
+{
+    TArray<FString> statusMessages;
+    ServerSimState->ServerSpawnEntities(InRequest, NetworkPlayerId, statusMessages);
+}
+
 void URRROS2SimulationStateClient::ServerSpawnEntity_Implementation(const FROSSpawnEntityReq& InRequest)
 {
     ServerSimState->ServerSpawnEntity(InRequest, NetworkPlayerId);
@@ -350,7 +416,7 @@ void URRROS2SimulationStateClient::SpawnEntityCheck()
         SpawnEntityService->GetRequest(request);
 
         AActor* matchingEntity;
-        for (auto& entity : SimulationState->EntityList)
+        for (auto& entity : SimulationState->GetEntityList())
         {
             if (entity)
             {
@@ -2,10 +2,51 @@
 
 #include "Tools/RRROS2TFPublisher.h"
 
+// UE
+#include "PhysicsEngine/PhysicsConstraintComponent.h"
+#include "TimerManager.h"
+
 // rclUE
 #include "Msgs/ROS2TFMsg.h"
+#include "ROS2NodeComponent.h"
 #include "rclcUtilities.h"
 
+namespace
+{
+//! Whether constraint allows no relative motion between its components
+bool IsConstraintLocked(const UPhysicsConstraintComponent* InConstraint)
+{
+    const FConstraintInstance& instance = InConstraint->ConstraintInstance;
+    return (instance.GetLinearXMotion() == ELinearConstraintMotion::LCM_Locked) &&
+           (instance.GetLinearYMotion() == ELinearConstraintMotion::LCM_Locked) &&
+           (instance.GetLinearZMotion() == ELinearConstraintMotion::LCM_Locked) &&
+           (instance.GetAngularSwing1Motion() == EAngularConstraintMotion::ACM_Locked) &&
+           (instance.GetAngularSwing2Motion() == EAngularConstraintMotion::ACM_Locked) &&
+           (instance.GetAngularTwistMotion() == EAngularConstraintMotion::ACM_Locked);
+}
+}    // namespace
+
+bool FRRROS2TFFrameIds::Update(const FString& InPrefix,
+                               const FString& InFrameId,
+                               const FString& InChildFrameId,
+                               const bool bInPrefixFrameId)
+{
+    if (bComposed && (bPrefixFrameId == bInPrefixFrameId) && Prefix.Equals(InPrefix, ESearchCase::CaseSensitive) &&
+        FrameId.Equals(InFrameId, ESearchCase::CaseSensitive) && ChildFrameId.Equals(InChildFrameId, ESearchCase::CaseSensitive))
+    {
+        return false;
+    }
+
+    Prefix = InPrefix;
+    FrameId = InFrameId;
+    ChildFrameId = InChildFrameId;
+    bPrefixFrameId = bInPrefixFrameId;
+    FullFrameId = bPrefixFrameId ? URRGeneralUtils::ComposeROSFullFrameId(Prefix, *FrameId) : FrameId;
+    FullChildFrameId = URRGeneralUtils::ComposeROSFullFrameId(Prefix, *ChildFrameId);
+    bComposed = true;
+    return true;
+}
+
 URRROS2TFPublisherBase::URRROS2TFPublisherBase()
 {
     PublicationFrequencyHz = 10;
@@ -29,35 +70,54 @@ bool URRROS2TFPublisherBase::InitializeWithROS2(UROS2NodeComponent* InROS2Node)
     return Super::InitializeWithROS2(InROS2Node);
 }
 
+const FString& URRROS2TFPublisherBase::GetFramePrefix() const
+{
+    static const FString emptyPrefix;
+    return (bAppendNodeNamespace && OwnerNode) ? OwnerNode->Namespace : emptyPrefix;
+}
+
 void URRROS2TFPublisherBase::AddTFtoMsg(FROSTFMsg& OutROSTf,
                                         const FString& InFrameId,
                                         const FString& InChildFrameId,
                                         const FTransform& InTf)
 {
-    FROSTFStamped tfData;
+    // Overwrite transforms of previous message in order, to keep their allocation
+    FROSTFStamped& tfData = (NumTransforms < OutROSTf.Transforms.Num()) ? OutROSTf.Transforms[NumTransforms]
+                                                                         : OutROSTf.Transforms.AddDefaulted_GetRef();
+    ++NumTransforms;
 
     // time
-    tfData.Header.Stamp = URRConversionUtils::FloatToROSStamp(UGameplayStatics::GetTimeSeconds(GetWorld()));
-    tfData.Header.FrameId = InFrameId;
-    tfData.ChildFrameId = InChildFrameId;
+    tfData.Header.Stamp = Stamp;
+    if (!tfData.Header.FrameId.Equals(InFrameId, ESearchCase::CaseSensitive))
+    {
+        tfData.Header.FrameId = InFrameId;
+    }
+    if (!tfData.ChildFrameId.Equals(InChildFrameId, ESearchCase::CaseSensitive))
+    {
+        tfData.ChildFrameId = InChildFrameId;
+    }
 
     tfData.Transform = URRConversionUtils::TransformUEToROS(InTf);
-
-    OutROSTf.Transforms.Emplace(MoveTemp(tfData));
 }
 
 void URRROS2TFPublisherBase::AddTFtoMsg(FROSTFMsg& OutROSTf, URRROS2TFComponent* InTfc)
 {
-    AddTFtoMsg(OutROSTf, InTfc->FrameId, InTfc->ChildFrameId, InTfc->GetTF());
+    InTfc->FullFrameIds.Update(GetFramePrefix(), InTfc->FrameId, InTfc->ChildFrameId);
+    AddTFtoMsg(OutROSTf, InTfc->FullFrameIds.FullFrameId, InTfc->FullFrameIds.FullChildFrameId, InTfc->GetTF());
 }
 
 void URRROS2TFPublisherBase::UpdateMessage(UROS2GenericMsg* InMessage)
 {
-    FROSTFMsg tf;
+    // time, shared by all transforms
+    Stamp = URRConversionUtils::FloatToROSStamp(UGameplayStatics::GetTimeSeconds(GetWorld()));
+    NumTransforms = 0;
+
+    GetROS2Msg(TFMsg);
 
-    GetROS2Msg(tf);
+    // Drop transforms left from previous message, if fewer were added
+    TFMsg.Transforms.SetNum(NumTransforms, false);
 
-    CastChecked<UROS2TFMsgMsg>(InMessage)->SetMsg(tf);
+    CastChecked<UROS2TFMsgMsg>(InMessage)->SetMsg(TFMsg);
 }
 
 void URRROS2TFPublisher::SetTransform(const FVector& Translation, const FQuat& Rotation)
@@ -68,19 +128,159 @@ void URRROS2TFPublisher::SetTransform(const FVector& Translation, const FQuat& R
 
 void URRROS2TFPublisher::GetROS2Msg(FROSTFMsg& OutROSTf)
 {
-    AddTFtoMsg(OutROSTf, FrameId, ChildFrameId, TF);
+    FullFrameIds.Update(GetFramePrefix(), FrameId, ChildFrameId);
+    AddTFtoMsg(OutROSTf, FullFrameIds.FullFrameId, FullFrameIds.FullChildFrameId, TF);
     Super::GetROS2Msg(OutROSTf);
 }
 
+void URRROS2TFsPublisher::AddTFComponent(URRROS2TFComponent* InTfc)
+{
+    if (InTfc == nullptr)
+    {
+        return;
+    }
+    InTfc->FullFrameIds.Update(GetFramePrefix(), InTfc->FrameId, InTfc->ChildFrameId);
+    TFComponents.Add(InTfc);
+    TFMsg.Transforms.Reserve(TFComponents.Num());
+}
+
+void URRROS2TFsPublisher::UpdateMessage(UROS2GenericMsg* InMessage)
+{
+    if (bSplitStaticTFs && !bSplitStarted && !IsStatic)
+    {
+        StartSplitStaticTFs();
+    }
+    Super::UpdateMessage(InMessage);
+
+    // Message is published by publish timer after update
+    ++NumPublishedMsgs;
+    NumPublishedTFs += NumTransforms;
+}
+
 void URRROS2TFsPublisher::GetROS2Msg(FROSTFMsg& OutROSTf)
 {
-    for (auto& tfc : TFComponents)
+    if (!bSplitStarted)
     {
-        AddTFtoMsg(OutROSTf, tfc);
+        for (auto& tfc : TFComponents)
+        {
+            AddTFtoMsg(OutROSTf, tfc);
+        }
+    }
+    else
+    {
+        SortTFComponents();
+        const double time = GetWorld()->GetTimeSeconds();
+        for (URRROS2TFComponent* tfc : DynamicTFComponents)
+        {
+            const FTransform tf = tfc->GetTF();
+            if (ShouldPublishTF(tfc, tf, time))
+            {
+                tfc->FullFrameIds.Update(GetFramePrefix(), tfc->FrameId, tfc->ChildFrameId);
+                AddTFtoMsg(OutROSTf, tfc->FullFrameIds.FullFrameId, tfc->FullFrameIds.FullChildFrameId, tf);
+                tfc->LastPublishedTF = tf;
+                tfc->LastPublishedTime = time;
+            }
+        }
     }
     Super::GetROS2Msg(OutROSTf);
 }
 
+void URRROS2TFsPublisher::StartSplitStaticTFs()
+{
+    if (!IsValid(OwnerNode))
+    {
+        return;
+    }
+
+    StaticTFPublisher = NewObject<URRROS2TFsPublisher>(this);
+    StaticTFPublisher->IsStatic = true;
+    StaticTFPublisher->bAppendNodeNamespace = bAppendNodeNamespace;
+    OwnerNode->AddPublisher(StaticTFPublisher);
+    // Published only when static tfs are added
+    StaticTFPublisher->StopPublishTimer();
+
+    // Publish timer publishes every cycle, even if no tf has changed
+    StopPublishTimer();
+    GetWorld()->GetTimerManager().SetTimer(
+        PublishTimerHandle, this, &URRROS2TFsPublisher::PublishDynamicTFs, 1.f / PublicationFrequencyHz, true);
+    bSplitStarted = true;
+}
+
+void URRROS2TFsPublisher::StopPublishTimer()
+{
+    Super::StopPublishTimer();
+    if (UWorld* world = GetWorld())
+    {
+        world->GetTimerManager().ClearTimer(PublishTimerHandle);
+    }
+}
+
+void URRROS2TFsPublisher::SortTFComponents()
+{
+    if (TFComponents.Num() < NumSortedTFComponents)
+    {
+        DynamicTFComponents.Reset();
+        StaticTFPublisher->TFComponents.Reset();
+        NumSortedTFComponents = 0;
+    }
+
+    for (int32 i = NumSortedTFComponents; i < TFComponents.Num(); ++i)
+    {
+        URRROS2TFComponent* tfc = TFComponents[i];
+        if (tfc == nullptr)
+        {
+            continue;
+        }
+        if (tfc->IsStaticTF())
+        {
+            StaticTFPublisher->AddTFComponent(tfc);
+            bStaticTFsAdded = true;
+        }
+        else
+        {
+            tfc->LastPublishedTime = -1.0;
+            DynamicTFComponents.Add(tfc);
+        }
+    }
+    NumSortedTFComponents = TFComponents.Num();
+}
+
+bool URRROS2TFsPublisher::ShouldPublishTF(const URRROS2TFComponent* InTfc, const FTransform& InTF, const double InTime) const
+{
+    if (InTfc->LastPublishedTime < 0.0)
+    {
+        return true;
+    }
+    if ((KeepAliveInterval > 0.f) && (InTime - InTfc->LastPublishedTime >= KeepAliveInterval))
+    {
+        return true;
+    }
+    return (FVector::DistSquared(InTF.GetTranslation(), InTfc->LastPublishedTF.GetTranslation()) >
+            FMath::Square(TranslationEpsilon)) ||
+           (InTF.GetRotation().AngularDistance(InTfc->LastPublishedTF.GetRotation()) > RotationEpsilon);
+}
+
+void URRROS2TFsPublisher::PublishDynamicTFs()
+{
+    SortTFComponents();
+
+    // /tf_static is latched, thus every static tf is republished together with added ones
+    if (bStaticTFsAdded)
+    {
+        StaticTFPublisher->UpdateMessage(StaticTFPublisher->TopicMessage);
+        StaticTFPublisher->Publish();
+        bStaticTFsAdded = false;
+    }
+
+    Super::UpdateMessage(TopicMessage);
+    if (NumTransforms > 0)
+    {
+        Publish();
+        ++NumPublishedMsgs;
+        NumPublishedTFs += NumTransforms;
+    }
+}
+
 FTransform URRROS2LinksTFComponent::GetTF()
 {
     if (ParentLink != nullptr && ChildLink != nullptr)
@@ -90,6 +290,45 @@ FTransform URRROS2LinksTFComponent::GetTF()
     return Super::GetTF();
 }
 
+bool URRROS2LinksTFComponent::IsStaticTF()
+{
+    if (bStatic)
+    {
+        return true;
+    }
+    if (ParentLink == nullptr || ChildLink == nullptr)
+    {
+        return false;
+    }
+
+    // Links of a robot are movable, thus the joint between them tells whether they move relative to each other
+    for (const AActor* owner : {ChildLink->GetOwner(), ParentLink->GetOwner()})
+    {
+        if (owner == nullptr)
+        {
+            continue;
+        }
+        TInlineComponentArray<URRJointComponent*> joints(owner);
+        for (const URRJointComponent* joint : joints)
+        {
+            if ((joint->ParentLink == ParentLink) && (joint->ChildLink == ChildLink))
+            {
+                return (joint->LinearDOF == 0) && (joint->RotationalDOF == 0);
+            }
+        }
+        TInlineComponentArray<UPhysicsConstraintComponent*> constraints(owner);
+        for (const UPhysicsConstraintComponent* constraint : constraints)
+        {
+            if ((URRGeneralUtils::GetPhysicsConstraintComponent(constraint, EConstraintFrame::Frame1) == ParentLink) &&
+                (URRGeneralUtils::GetPhysicsConstraintComponent(constraint, EConstraintFrame::Frame2) == ChildLink))
+            {
+                return IsConstraintLocked(constraint);
+            }
+        }
+    }
+    return (ParentLink->Mobility == EComponentMobility::Static) && (ChildLink->Mobility == EComponentMobility::Static);
+}
+
 void URRROS2LinksTFComponent::AddLinks(UPrimitiveComponent* InParentLink,
                                        UPrimitiveComponent* InChildLink,
                                        const FString& InFrameId,
@@ -98,7 +337,7 @@ void URRROS2LinksTFComponent::AddLinks(UPrimitiveComponent* InParentLink,
 {
     URRROS2LinksTFComponent* linksTF = NewObject<URRROS2LinksTFComponent>(OutTFsPublisher);
     linksTF->InitLinksTFComponent(InFrameId, InChildFrameId, InParentLink, InChildLink);
-    OutTFsPublisher->TFComponents.Add(linksTF);
+    OutTFsPublisher->AddTFComponent(linksTF);
 }
 
 void URRROS2PhysicsConstraintTFComponent::AddConstraint(UPhysicsConstraintComponent* InConstraint,
@@ -108,7 +347,12 @@ void URRROS2PhysicsConstraintTFComponent::AddConstraint(UPhysicsConstraintCompon
 {
     URRROS2PhysicsConstraintTFComponent* constraintTF = NewObject<URRROS2PhysicsConstraintTFComponent>(OutTFsPublisher);
     constraintTF->InitPhysicsConstraintTFComponent(InFrameId, InChildFrameId, InConstraint);
-    OutTFsPublisher->TFComponents.Add(constraintTF);
+    OutTFsPublisher->AddTFComponent(constraintTF);
+}
+
+bool URRROS2PhysicsConstraintTFComponent::IsStaticTF()
+{
+    return bStatic || ((Constraint != nullptr) && IsConstraintLocked(Constraint));
 }
 
 FTransform URRROS2JointTFComponent::GetTF()
@@ -122,6 +366,11 @@ FTransform URRROS2JointTFComponent::GetTF()
     return TF;
 }
 
+bool URRROS2JointTFComponent::IsStaticTF()
+{
+    return bStatic || ((Joint != nullptr) && (Joint->LinearDOF == 0) && (Joint->RotationalDOF == 0));
+}
+
 void URRROS2JointTFComponent::AddJoint(URRJointComponent* InJoint,
                                        const FString& InFrameId,
                                        const FString& InChildFrameId,
@@ -129,5 +378,5 @@ void URRROS2JointTFComponent::AddJoint(URRJointComponent* InJoint,
 {
     URRROS2JointTFComponent* jointTF = NewObject<URRROS2JointTFComponent>(OutTFsPublisher);
     jointTF->InitJointTFComponent(InFrameId, InChildFrameId, InJoint);
-    OutTFsPublisher->TFComponents.Add(jointTF);
+    OutTFsPublisher->AddTFComponent(jointTF);
 }
@@ -3,6 +3,7 @@
 #include "Tools/SimulationState.h"
 
 // UE
+#include "Components/PrimitiveComponent.h"
 #include "Engine/World.h"
 #include "EngineUtils.h"
 #include "Kismet/GameplayStatics.h"
@@ -20,16 +21,188 @@
 #include "Core/RRActorCommon.h"
 #include "Core/RRAssetUtils.h"
 #include "Core/RRConversionUtils.h"
+#include "Core/RREntityIndexSubsystem.h"
 #include "Core/RRUObjectUtils.h"
 #include "Net/UnrealNetwork.h"
 #include "Robots/RRBaseRobot.h"
 #include "Tools/ROS2Spawnable.h"
 
+void FRREntityInfo::PreReplicatedRemove(const FRRSpawnableEntityInfoArray& InArraySerializer)
+{
+    if (InArraySerializer.Owner)
+    {
+        InArraySerializer.Owner->SpawnableEntityTypes.Remove(EntityTypeName);
+    }
+}
+
+void FRREntityInfo::PostReplicatedAdd(const FRRSpawnableEntityInfoArray& InArraySerializer)
+{
+    if (InArraySerializer.Owner)
+    {
+        InArraySerializer.Owner->SpawnableEntityTypes.Emplace(EntityTypeName, EntityClass);
+    }
+}
+
+void FRREntityInfo::PostReplicatedChange(const FRRSpawnableEntityInfoArray& InArraySerializer)
+{
+    PostReplicatedAdd(InArraySerializer);
+}
+
+bool FRRSpawnableEntityInfoArray::AddOrUpdate(const FString& InEntityTypeName, const TSubclassOf<AActor>& InEntityClass)
+{
+    if (const int32* index = ItemIndices.Find(InEntityTypeName))
+    {
+        FRREntityInfo& item = Items[*index];
+        if (item.EntityClass == InEntityClass)
+        {
+            return false;
+        }
+        item.EntityClass = InEntityClass;
+        MarkItemDirty(item);
+        return true;
+    }
+
+    ItemIndices.Emplace(InEntityTypeName, Items.Num());
+    FRREntityInfo& item = Items.Emplace_GetRef(TPair<FString, TSubclassOf<AActor>>(InEntityTypeName, InEntityClass));
+    MarkItemDirty(item);
+    return true;
+}
+
+bool FRRSpawnableEntityInfoArray::Remove(const FString& InEntityTypeName)
+{
+    int32 index = INDEX_NONE;
+    if (!ItemIndices.RemoveAndCopyValue(InEntityTypeName, index))
+    {
+        return false;
+    }
+
+    // Swap the last item into the removed slot, thus only its index changes
+    Items.RemoveAtSwap(index);
+    if (Items.IsValidIndex(index))
+    {
+        ItemIndices[Items[index].EntityTypeName] = index;
+    }
+    MarkArrayDirty();
+    return true;
+}
+
+void FRRReplicatedEntity::PreReplicatedRemove(const FRRReplicatedEntityArray& InArraySerializer)
+{
+    if (InArraySerializer.Owner)
+    {
+        InArraySerializer.Owner->RemoveReplicatedEntity(Entity);
+    }
+}
+
+void FRRReplicatedEntity::PostReplicatedAdd(const FRRReplicatedEntityArray& InArraySerializer)
+{
+    if (InArraySerializer.Owner)
+    {
+        InArraySerializer.Owner->AddReplicatedEntity(Entity);
+    }
+}
+
+void FRRReplicatedEntity::PostReplicatedChange(const FRRReplicatedEntityArray& InArraySerializer)
+{
+    PostReplicatedAdd(InArraySerializer);
+}
+
+bool FRRReplicatedEntityArray::Add(AActor* InEntity)
+{
+    const TWeakObjectPtr<const AActor> key(InEntity);
+    if (ItemIndices.Contains(key))
+    {
+        return false;
+    }
+
+    ItemIndices.Emplace(key, Items.Num());
+    MarkItemDirty(Items.Emplace_GetRef(InEntity));
+    return true;
+}
+
+bool FRRReplicatedEntityArray::Remove(AActor* InEntity)
+{
+    int32 index = INDEX_NONE;
+    if (!ItemIndices.RemoveAndCopyValue(TWeakObjectPtr<const AActor>(InEntity), index))
+    {
+        return false;
+    }
+
+    // Swap the last item into the removed slot, thus only its index changes
+    Items.RemoveAtSwap(index);
+    if (Items.IsValidIndex(index))
+    {
+        if (int32* movedIndex = ItemIndices.Find(TWeakObjectPtr<const AActor>(Items[index].Entity)))
+        {
+            *movedIndex = index;
+        }
+    }
+    MarkArrayDirty();
+    return true;
+}
+
+TArray<AActor*> FRRReplicatedEntityArray::GetEntities() const
+{
+    TArray<AActor*> entities;
+    entities.Reserve(Items.Num());
+    for (const FRRReplicatedEntity& item : Items)
+    {
+        entities.Emplace(item.Entity);
+    }
+    return entities;
+}
+
+bool FRREntities::Add(AActor* InActor)
+{
+    bool bAlreadyAdded = false;
+    ActorSet.Emplace(InActor, &bAlreadyAdded);
+    if (bAlreadyAdded)
+    {
+        return false;
+    }
+    Actors.Emplace(InActor);
+    return true;
+}
+
+bool FRREntities::Remove(AActor* InActor)
+{
+    if (ActorSet.Remove(InActor) == 0)
+    {
+        return false;
+    }
+    Actors.RemoveSingleSwap(InActor);
+    return true;
+}
+
+int32 FRREntities::RemoveInvalid()
+{
+    for (auto it = ActorSet.CreateIterator(); it; ++it)
+    {
+        if (!it->IsValid())
+        {
+            it.RemoveCurrent();
+        }
+    }
+    return Actors.RemoveAllSwap([](const AActor* InActor) { return !IsValid(InActor); });
+}
+
 ASimulationState::ASimulationState()
 {
     bReplicates = true;
     PrimaryActorTick.bCanEverTick = true;
     bAlwaysRelevant = true;
+    SpawnableEntityInfoList.Owner = this;
+    EntityList.Owner = this;
+}
+
+void ASimulationState::Tick(float DeltaSeconds)
+{
+    Super::Tick(DeltaSeconds);
+
+    if ((NumPendingSpawns > 0) && HasAuthority())
+    {
+        ServerSpawnPendingEntities();
+    }
 }
 
 void ASimulationState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
@@ -75,9 +248,11 @@ void ASimulationState::InitEntities()
         ServerAddEntity(actor);
     }
 
-    // NOTE: [SpawnableEntityInfoList] is a TArray<> thus replicatable, which is not supported for [SpawnableEntities] as a TMap
+    // NOTE: [SpawnableEntityInfoList] is a fast array thus replicatable, which is not supported for [SpawnableEntities] as a TMap
     GetWorld()->GetTimerManager().SetTimer(
         FetchEntityListTimerHandle, this, &ASimulationState::GetSpawnableEntityInfoList, 1.0f, true);
+
+    ServerWarmupEntityPools();
 }
 
 void ASimulationState::ServerAddEntity(AActor* InEntity)
@@ -87,21 +262,17 @@ void ASimulationState::ServerAddEntity(AActor* InEntity)
         return;
     }
 
-    GetSpawnableEntityInfoList();
     Entities.Emplace(InEntity->GetName(), InEntity);
-    EntityList.Emplace(InEntity);
-    for (auto& tag : InEntity->Tags)
+    EntityList.Add(InEntity);
+    for (const auto& tag : InEntity->Tags)
     {
-        if (EntitiesWithTag.Contains(tag))
-        {
-            EntitiesWithTag[tag].Actors.Emplace(InEntity);
-        }
-        else
-        {
-            FRREntities actors;
-            actors.Actors.Emplace(InEntity);
-            EntitiesWithTag.Emplace(tag, MoveTemp(actors));
-        }
+        AddTaggedEntity(InEntity, tag);
+    }
+
+    // Entity may have been renamed or tagged since it was spawned
+    if (URREntityIndexSubsystem* entityIndex = URREntityIndexSubsystem::Get(GetWorld()))
+    {
+        entityIndex->IndexEntity(InEntity);
     }
 
 #if WITH_EDITOR
@@ -109,95 +280,140 @@ void ASimulationState::ServerAddEntity(AActor* InEntity)
 #endif
 }
 
-// Work around to replicating Entities and EntitiesWithTag since TMaps cannot be replicated
 void ASimulationState::OnRep_EntityList()
 {
-    for (AActor* entity : EntityList)
+    for (const FRRReplicatedEntity& item : EntityList.Items)
+    {
+        AddReplicatedEntity(item.Entity);
+    }
+}
+
+// Work around to replicating Entities and EntitiesWithTag since TMaps cannot be replicated
+void ASimulationState::AddReplicatedEntity(AActor* InEntity)
+{
+    if (false == IsValid(InEntity))
     {
-        if (false == IsValid(entity))
+        return;
+    }
+
+    UROS2Spawnable* EntitySpawnParam = InEntity->FindComponentByClass<UROS2Spawnable>();
+    if (!Entities.Contains(InEntity->GetName()))
+    {
+        Entities.Emplace(EntitySpawnParam ? EntitySpawnParam->GetName() : InEntity->GetName(), InEntity);
+    }
+
+    for (const auto& tag : InEntity->Tags)
+    {
+        AddTaggedEntity(InEntity, tag);
+    }
+
+    if (EntitySpawnParam)
+    {
+        for (const auto& tag : EntitySpawnParam->ActorTags)
         {
-            continue;
+            AddTaggedEntity(InEntity, FName(tag));
         }
+        // Re-indexes it with its tags as well
+        URREntityIndexSubsystem::RenameEntity(InEntity, EntitySpawnParam->GetName());
+    }
+}
 
-        if (!Entities.Contains(entity->GetName()))
+void ASimulationState::RemoveReplicatedEntity(AActor* InEntity)
+{
+    // Entity reference has been cleared if its actor channel has been closed before its item is removed
+    if (InEntity == nullptr)
+    {
+        RemoveInvalidEntities();
+        return;
+    }
+
+    auto removeTaggedEntity = [this, InEntity](const FName& InTag)
+    {
+        if (FRREntities* entitiesWithTag = EntitiesWithTag.Find(InTag))
         {
-            UROS2Spawnable* rosSpawnParameters = entity->FindComponentByClass<UROS2Spawnable>();
-            if (rosSpawnParameters)
-            {
-                Entities.Emplace(rosSpawnParameters->GetName(), entity);
-            }
-            else
-            {
-                Entities.Emplace(entity->GetName(), entity);
-            }
+            entitiesWithTag->Remove(InEntity);
         }
+    };
+    for (const auto& tag : InEntity->Tags)
+    {
+        removeTaggedEntity(tag);
+    }
 
-        for (const auto& tag : entity->Tags)
+    UROS2Spawnable* EntitySpawnParam = InEntity->FindComponentByClass<UROS2Spawnable>();
+    if (EntitySpawnParam)
+    {
+        for (const auto& tag : EntitySpawnParam->ActorTags)
         {
-            AddTaggedEntity(entity, tag);
+            removeTaggedEntity(FName(tag));
         }
-
-        UROS2Spawnable* EntitySpawnParam = entity->FindComponentByClass<UROS2Spawnable>();
-        if (EntitySpawnParam)
+        if (Entities.FindRef(EntitySpawnParam->GetName()) == InEntity)
         {
-            entity->Rename(*EntitySpawnParam->GetName());
-            for (const auto& tag : EntitySpawnParam->ActorTags)
-            {
-                AddTaggedEntity(entity, FName(tag));
-            }
+            Entities.Remove(EntitySpawnParam->GetName());
         }
     }
-}
+    if (Entities.FindRef(InEntity->GetName()) == InEntity)
+    {
+        Entities.Remove(InEntity->GetName());
+    }
 
-void ASimulationState::OnRep_SpawnableEntityInfoList()
-{
-    for (const auto& entityInfo : SpawnableEntityInfoList)
+    if (URREntityIndexSubsystem* entityIndex = URREntityIndexSubsystem::Get(GetWorld()))
     {
-        SpawnableEntityTypes.Emplace(entityInfo.EntityTypeName, entityInfo.EntityClass);
+        entityIndex->RemoveEntity(InEntity);
     }
 }
 
-void ASimulationState::AddTaggedEntity(AActor* Entity, const FName& InTag)
+void ASimulationState::RemoveInvalidEntities()
 {
-    if (EntitiesWithTag.Contains(InTag))
+    for (auto it = Entities.CreateIterator(); it; ++it)
     {
-        // Check if Actor in EntitiesWithTag
-
-        bool ToEmplace = true;
-        for (AActor* TaggedActor : EntitiesWithTag[InTag].Actors)
+        if (!IsValid(it.Value()))
         {
-            if (TaggedActor->GetName() == Entity->GetName())
-            {
-                ToEmplace = false;
-            }
+            it.RemoveCurrent();
         }
-        if (ToEmplace)
+    }
+#if WITH_EDITOR
+    for (auto it = EntitiesWithDisplayName.CreateIterator(); it; ++it)
+    {
+        if (!IsValid(it.Value()))
         {
-            EntitiesWithTag[InTag].Actors.Emplace(Entity);
+            it.RemoveCurrent();
         }
     }
-    else
+#endif
+    for (auto& entitiesWithTag : EntitiesWithTag)
     {
-        FRREntities actors;
-        actors.Actors.Emplace(Entity);
-        EntitiesWithTag.Emplace(InTag, actors);
+        entitiesWithTag.Value.RemoveInvalid();
     }
 }
 
+void ASimulationState::AddTaggedEntity(AActor* Entity, const FName& InTag)
+{
+    EntitiesWithTag.FindOrAdd(InTag).Add(Entity);
+}
+
 void ASimulationState::AddSpawnableEntityTypes(TMap<FString, TSubclassOf<AActor>> InSpawnableEntityTypes)
 {
     for (auto& elem : InSpawnableEntityTypes)
     {
-        SpawnableEntityInfoList.Emplace(FRREntityInfo(elem));
+        SpawnableEntityInfoList.AddOrUpdate(elem.Key, elem.Value);
         SpawnableEntityTypes.Emplace(MoveTemp(elem.Key), MoveTemp(elem.Value));
     }
 }
 
+void ASimulationState::RemoveSpawnableEntityTypes(const TArray<FString>& InEntityTypeNames)
+{
+    for (const auto& entityTypeName : InEntityTypeNames)
+    {
+        SpawnableEntityInfoList.Remove(entityTypeName);
+        SpawnableEntityTypes.Remove(entityTypeName);
+    }
+}
+
 void ASimulationState::GetSpawnableEntityInfoList()
 {
-    for (auto& elem : SpawnableEntityTypes)
+    for (const auto& elem : SpawnableEntityTypes)
     {
-        SpawnableEntityInfoList.Emplace(FRREntityInfo(elem));
+        SpawnableEntityInfoList.AddOrUpdate(elem.Key, elem.Value);
     }
     if (SpawnableEntityInfoList.Num() > 0)
     {
@@ -365,6 +581,31 @@ AActor* ASimulationState::ServerSpawnEntity(const FROSSpawnEntityReq& InROSSpawn
         return nullptr;
     }
 
+    AActor* newEntity = ServerAcquirePooledEntity(InROSSpawnRequest, InEntityClass, InEntityTransform, InNetworkPlayerId);
+    if (newEntity == nullptr)
+    {
+        newEntity = ServerBeginSpawnEntity(InROSSpawnRequest, InEntityClass, InEntityTransform, InNetworkPlayerId);
+        if (newEntity == nullptr)
+        {
+            return nullptr;
+        }
+
+        // Finish spawning Entity
+        // Destroy seems not make newEntity=nullptr evevn if it failed.
+        newEntity = UGameplayStatics::FinishSpawningActor(newEntity, InEntityTransform);
+    }
+
+    // Add to [Entities]
+    ServerAddEntity(newEntity);
+
+    return newEntity;
+}
+
+AActor* ASimulationState::ServerBeginSpawnEntity(const FROSSpawnEntityReq& InROSSpawnRequest,
+                                                 const TSubclassOf<AActor>& InEntityClass,
+                                                 const FTransform& InEntityTransform,
+                                                 const int32& InNetworkPlayerId)
+{
     // SpawnActorDeferred to set parameters beforehand
     // Using AdjustIfPossibleButAlwaysSpawn, the actual entity's transform could be different from one specified in SpawnEntity,
     // thus we may need to inform ros side to get synchronized with it
@@ -382,10 +623,7 @@ AActor* ASimulationState::ServerSpawnEntity(const FROSSpawnEntityReq& InROSSpawn
     spawnableComponent->InitializeParameters(InROSSpawnRequest);
 
     newEntity->AddInstanceComponent(spawnableComponent);
-    newEntity->Rename(*InROSSpawnRequest.State.Name);
-#if WITH_EDITOR
-    newEntity->SetActorLabel(*InROSSpawnRequest.State.Name);
-#endif
+    URREntityIndexSubsystem::RenameEntity(newEntity, InROSSpawnRequest.State.Name);
 
     // Set/Configure [robot]'s [ROSSpawnParameters] as [spawnableComponent]
 
@@ -420,14 +658,220 @@ AActor* ASimulationState::ServerSpawnEntity(const FROSSpawnEntityReq& InROSSpawn
         spawnableComponent->AddTag(tag);
     }
 
-    // Finish spawning Entity
-    // Destroy seems not make newEntity=nullptr evevn if it failed.
-    newEntity = UGameplayStatics::FinishSpawningActor(newEntity, InEntityTransform);
+    return newEntity;
+}
 
-    // Add to [Entities]
-    ServerAddEntity(newEntity);
+bool ASimulationState::GetSpawnWorldTransform(const FROSEntityState& InState,
+                                              FTransform& OutWorldTransform,
+                                              const TMap<FString, FTransform>* InBatchTransforms)
+{
+    const FTransform relativeTransf =
+        URRConversionUtils::TransformROSToUE(FTransform(InState.Pose.Orientation, InState.Pose.Position));
+    const FString& referenceFrame = InState.ReferenceFrame;
+    AActor* RefActor = Entities.FindRef(referenceFrame);
+#if WITH_EDITOR
+    if (RefActor == nullptr)
+    {
+        RefActor = EntitiesWithDisplayName.FindRef(referenceFrame);
+    }
+#endif
+    if ((RefActor == nullptr) && !referenceFrame.IsEmpty())
+    {
+        const FTransform* batchTransf = InBatchTransforms ? InBatchTransforms->Find(referenceFrame) : nullptr;
+        if (batchTransf == nullptr)
+        {
+            return false;
+        }
+        OutWorldTransform = URRGeneralUtils::GetWorldTransform(*batchTransf, relativeTransf);
+        return true;
+    }
+    URRGeneralUtils::GetWorldTransform(RefActor, relativeTransf, OutWorldTransform);
+    return true;
+}
 
-    return newEntity;
+int32 ASimulationState::ServerSpawnEntities(const FROSSpawnEntitiesReq& InRequest,
+                                            const int32 InNetworkPlayerId,
+                                            TArray<FString>& OutStatusMessages)
+{
+    if (false == VerifyIsServerCall(TEXT("ServerSpawnEntities")))
+    {
+        return 0;
+    }
+
+    const int32 nRequestedEntities = InRequest.State.Num();
+    OutStatusMessages.Reset();
+    OutStatusMessages.SetNum(nRequestedEntities);
+    const bool bSpawnBudget = HasSpawnBudget();
+    int32 nQueuedEntities = 0;
+
+    // 1- Spawn all entities deferred, or reuse pooled ones
+    struct FDeferredEntity
+    {
+        AActor* Entity;
+        FTransform WorldTransform;
+        bool bPooled;
+    };
+    TArray<FDeferredEntity> deferredEntities;
+    deferredEntities.Reserve(nRequestedEntities);
+    // World transforms of entities deferred so far, as reference frames of next ones
+    TMap<FString, FTransform> batchTransforms;
+    TSet<FString> requestedNames;
+    requestedNames.Reserve(nRequestedEntities);
+    FROSSpawnEntityReq entityRequest;
+    entityRequest.RobotNamespace = EMPTY_STR;
+    entityRequest.Tags = InRequest.Tags;
+    for (int32 i = 0; i < nRequestedEntities; ++i)
+    {
+        entityRequest.Xml = InRequest.Type.IsValidIndex(i) ? InRequest.Type[i] : EMPTY_STR;
+        entityRequest.State = InRequest.State[i];
+        const FString& entityName = entityRequest.State.Name;
+        bool bNameRequested = false;
+        if (!entityName.IsEmpty())
+        {
+            requestedNames.Emplace(entityName, &bNameRequested);
+        }
+
+        const TSubclassOf<AActor>* entityClass = SpawnableEntityTypes.Find(entityRequest.Xml);
+        FTransform worldTransf;
+        if (entityClass == nullptr)
+        {
+            OutStatusMessages[i] = FString::Printf(TEXT("Model [%s] is not spawnable"), *entityRequest.Xml);
+        }
+        else if (entityName.IsEmpty())
+        {
+            OutStatusMessages[i] = TEXT("Entity name is empty");
+        }
+        else if (bNameRequested || PendingSpawnNames.Contains(entityName) ||
+                 (nullptr != URRGeneralUtils::FindActorByName<AActor>(GetWorld(), entityName)))
+        {
+            OutStatusMessages[i] = TEXT("Given name actor already exists");
+        }
+        else if (!GetSpawnWorldTransform(entityRequest.State, worldTransf, &batchTransforms) &&
+                 !(bSpawnBudget && PendingSpawnNames.Contains(entityRequest.State.ReferenceFrame)))
+        {
+            OutStatusMessages[i] =
+                FString::Printf(TEXT("Reference frame [%s] is not an entity"), *entityRequest.State.ReferenceFrame);
+        }
+        else if (bSpawnBudget)
+        {
+            // World transform is computed again when spawned, as its reference frame may move meanwhile or be queued
+            // ahead of it
+            PendingSpawnNames.Emplace(entityName);
+            PendingSpawns.Enqueue({entityRequest, InNetworkPlayerId});
+            ++NumPendingSpawns;
+            ++nQueuedEntities;
+        }
+        else if (AActor* pooledEntity = ServerAcquirePooledEntity(entityRequest, *entityClass, worldTransf, InNetworkPlayerId))
+        {
+            deferredEntities.Add({pooledEntity, worldTransf, true});
+            batchTransforms.Emplace(entityName, worldTransf);
+        }
+        else if (AActor* newEntity = ServerBeginSpawnEntity(entityRequest, *entityClass, worldTransf, InNetworkPlayerId))
+        {
+            deferredEntities.Add({newEntity, worldTransf, false});
+            batchTransforms.Emplace(entityName, worldTransf);
+        }
+        else
+        {
+            OutStatusMessages[i] = TEXT("Failed to spawn, probably out of collision");
+        }
+
+        if (!OutStatusMessages[i].IsEmpty())
+        {
+            UE_LOG_WITH_INFO(LogRapyutaCore,
+                             Error,
+                             TEXT("Failed to spawn entity [%s] of model [%s]: %s"),
+                             *entityName,
+                             *entityRequest.Xml,
+                             *OutStatusMessages[i]);
+        }
+    }
+
+    // 2- Finish their construction together, then add them to [Entities]
+    for (FDeferredEntity& deferredEntity : deferredEntities)
+    {
+        if (!deferredEntity.bPooled)
+        {
+            deferredEntity.Entity = UGameplayStatics::FinishSpawningActor(deferredEntity.Entity, deferredEntity.WorldTransform);
+        }
+    }
+    for (const FDeferredEntity& deferredEntity : deferredEntities)
+    {
+        ServerAddEntity(deferredEntity.Entity);
+    }
+
+    if (bSpawnBudget)
+    {
+        UE_LOG_WITH_INFO(LogRapyutaCore,
+                         Log,
+                         TEXT("Queued %d / %d entities, %d pending in total"),
+                         nQueuedEntities,
+                         nRequestedEntities,
+                         NumPendingSpawns);
+        // Use what is left of this frame's budget right away, so that small requests are spawned without delay
+        ServerSpawnPendingEntities();
+        return nQueuedEntities;
+    }
+
+    UE_LOG_WITH_INFO(LogRapyutaCore, Log, TEXT("Spawned %d / %d entities"), deferredEntities.Num(), nRequestedEntities);
+    return deferredEntities.Num();
+}
+
+void ASimulationState::ServerSpawnPendingEntities()
+{
+    if (GFrameCounter != SpawnBudgetFrame)
+    {
+        SpawnBudgetFrame = GFrameCounter;
+        SpawnFrameTimeMs = 0.0;
+        SpawnFrameEntities = 0;
+    }
+
+    auto isBudgetUsedUp = [this]()
+    {
+        return ((SpawnBudgetEntities > 0) && (SpawnFrameEntities >= SpawnBudgetEntities)) ||
+               ((SpawnBudgetMs > 0.f) && (SpawnFrameTimeMs >= SpawnBudgetMs));
+    };
+
+    int32 nSpawnedEntities = 0;
+    FRRPendingEntitySpawn pendingSpawn;
+    while (!isBudgetUsedUp() && PendingSpawns.Dequeue(pendingSpawn))
+    {
+        const double startTime = FPlatformTime::Seconds();
+        --NumPendingSpawns;
+        const FROSSpawnEntityReq& request = pendingSpawn.Request;
+        const FString& entityName = request.State.Name;
+        PendingSpawnNames.Remove(entityName);
+
+        // Entity types, names and reference frames may have changed since it has been queued
+        const TSubclassOf<AActor>* entityClass = SpawnableEntityTypes.Find(request.Xml);
+        FTransform worldTransf;
+        AActor* newEntity = nullptr;
+        if ((entityClass != nullptr) && (nullptr == URRGeneralUtils::FindActorByName<AActor>(GetWorld(), entityName)) &&
+            GetSpawnWorldTransform(request.State, worldTransf))
+        {
+            newEntity = ServerSpawnEntity(request, *entityClass, worldTransf, pendingSpawn.NetworkPlayerId);
+        }
+        if (newEntity == nullptr)
+        {
+            UE_LOG_WITH_INFO(
+                LogRapyutaCore, Error, TEXT("Failed to spawn queued entity [%s] of model [%s]"), *entityName, *request.Xml);
+        }
+
+        SpawnFrameTimeMs += (FPlatformTime::Seconds() - startTime) * 1000.0;
+        ++SpawnFrameEntities;
+        ++nSpawnedEntities;
+    }
+
+    MaxSpawnFrameTimeMs = FMath::Max(MaxSpawnFrameTimeMs, static_cast<float>(SpawnFrameTimeMs));
+    MaxSpawnFrameEntities = FMath::Max(MaxSpawnFrameEntities, SpawnFrameEntities);
+    if ((NumPendingSpawns == 0) && (nSpawnedEntities > 0))
+    {
+        UE_LOG_WITH_INFO(LogRapyutaCore,
+                         Log,
+                         TEXT("All queued entities spawned, max %d entities / %.3fms per frame"),
+                         MaxSpawnFrameEntities,
+                         MaxSpawnFrameTimeMs);
+    }
 }
 
 AActor* ASimulationState::ServerSpawnEntity(const FROSSpawnEntityReq& InRequest, const int32 InNetworkPlayerId)
@@ -514,7 +958,226 @@ void ASimulationState::ServerDeleteEntity(const FROSDeleteEntityReq& InRequest)
     if (ServerCheckDeleteRequest(InRequest))
     {
         AActor* Removed = Entities.FindAndRemoveChecked(InRequest.Name);
-        Removed->Destroy();
+        // Deleted entity is either pooled or destroyed, and is removed from all entity maps in both cases
+        EntityList.Remove(Removed);
+#if WITH_EDITOR
+        EntitiesWithDisplayName.Remove(UKismetSystemLibrary::GetDisplayName(Removed));
+#endif
+        for (auto& entitiesWithTag : EntitiesWithTag)
+        {
+            entitiesWithTag.Value.Remove(Removed);
+        }
+        if (URREntityIndexSubsystem* entityIndex = URREntityIndexSubsystem::Get(GetWorld()))
+        {
+            entityIndex->RemoveEntity(Removed);
+        }
+        if (false == ServerReleaseEntity(Removed))
+        {
+            Removed->Destroy();
+        }
     }
     PrevDeleteEntityRequest = InRequest;
 }
+
+const FRREntityPoolSettings& ASimulationState::GetEntityPoolSettings(const FString& InEntityTypeName) const
+{
+    const FRREntityPoolSettings* poolSettings = EntityPoolSettings.Find(InEntityTypeName);
+    return poolSettings ? *poolSettings : DefaultEntityPoolSettings;
+}
+
+int32 ASimulationState::GetNumPooledEntities(const FString& InEntityTypeName) const
+{
+    const FRREntityPool* pool = EntityPools.Find(InEntityTypeName);
+    return pool ? pool->Actors.Num() : 0;
+}
+
+AActor* ASimulationState::ServerAcquirePooledEntity(const FROSSpawnEntityReq& InROSSpawnRequest,
+                                                    const TSubclassOf<AActor>& InEntityClass,
+                                                    const FTransform& InEntityTransform,
+                                                    const int32 InNetworkPlayerId)
+{
+    if (!bEnableEntityPooling)
+    {
+        return nullptr;
+    }
+
+    FRREntityPool* pool = EntityPools.Find(InROSSpawnRequest.Xml);
+    if (pool == nullptr)
+    {
+        return nullptr;
+    }
+
+    AActor* entity = nullptr;
+    while ((entity == nullptr) && (pool->Actors.Num() > 0))
+    {
+        entity = pool->Actors.Pop(false);
+        if (!IsValid(entity))
+        {
+            entity = nullptr;
+        }
+        else if (entity->GetClass() != InEntityClass)
+        {
+            // Entity type has been registered with another class since the entity was pooled
+            entity->Destroy();
+            entity = nullptr;
+        }
+    }
+    if (entity == nullptr)
+    {
+        return nullptr;
+    }
+
+    // Re-initialize it as ServerBeginSpawnEntity would, reusing its spawnable component
+    UROS2Spawnable* spawnableComponent = entity->FindComponentByClass<UROS2Spawnable>();
+    spawnableComponent->SetNetworkPlayerId(InNetworkPlayerId);
+    spawnableComponent->InitializeParameters(InROSSpawnRequest);
+    for (const auto& tag : InROSSpawnRequest.Tags)
+    {
+        entity->Tags.Emplace(tag);
+        spawnableComponent->AddTag(tag);
+    }
+    URREntityIndexSubsystem::RenameEntity(entity, InROSSpawnRequest.State.Name);
+
+    ActivateEntity(entity, InEntityTransform);
+    return entity;
+}
+
+bool ASimulationState::ServerReleaseEntity(AActor* InEntity)
+{
+    // Robots own ROS 2 nodes and robot-specific components, thus are never reused
+    if (!bEnableEntityPooling || !IsValid(InEntity) || InEntity->IsA<ARRBaseRobot>())
+    {
+        return false;
+    }
+
+    // Only spawned entities have a type to be reused for
+    UROS2Spawnable* spawnableComponent = InEntity->FindComponentByClass<UROS2Spawnable>();
+    if (spawnableComponent == nullptr)
+    {
+        return false;
+    }
+    const FString& entityTypeName = spawnableComponent->ActorModelName;
+    const TSubclassOf<AActor>* entityClass = SpawnableEntityTypes.Find(entityTypeName);
+    if ((entityClass == nullptr) || (*entityClass != InEntity->GetClass()))
+    {
+        return false;
+    }
+    FRREntityPool& pool = EntityPools.FindOrAdd(entityTypeName);
+    if (pool.Actors.Num() >= GetEntityPoolSettings(entityTypeName).MaxPoolSize)
+    {
+        return false;
+    }
+
+    DeactivateEntity(InEntity);
+
+    // Free its name and tags for next spawns
+    const FString pooledName =
+        MakeUniqueObjectName(InEntity->GetOuter(), InEntity->GetClass(), *FString::Printf(TEXT("Pooled_%s"), *entityTypeName))
+            .ToString();
+    InEntity->Tags = InEntity->GetClass()->GetDefaultObject<AActor>()->Tags;
+    spawnableComponent->ActorTags.Reset();
+    URREntityIndexSubsystem::RenameEntity(InEntity, pooledName);
+
+    pool.Actors.Emplace(InEntity);
+    return true;
+}
+
+void ASimulationState::DeactivateEntity(AActor* InEntity)
+{
+    InEntity->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+    InEntity->SetActorHiddenInGame(true);
+    InEntity->SetActorEnableCollision(false);
+    InEntity->SetActorTickEnabled(false);
+
+    TInlineComponentArray<UActorComponent*> components(InEntity);
+    for (UActorComponent* component : components)
+    {
+        component->SetComponentTickEnabled(false);
+    }
+
+    TInlineComponentArray<UPrimitiveComponent*> primComponents(InEntity);
+    for (UPrimitiveComponent* primComponent : primComponents)
+    {
+        if (primComponent->IsSimulatingPhysics())
+        {
+            primComponent->SetPhysicsLinearVelocity(FVector::ZeroVector);
+            primComponent->SetPhysicsAngularVelocityInDegrees(FVector::ZeroVector);
+            primComponent->PutRigidBodyToSleep();
+        }
+    }
+}
+
+void ASimulationState::ActivateEntity(AActor* InEntity, const FTransform& InEntityTransform)
+{
+    // (NOTE) Unlike a spawned entity, it is not moved out of collision, as with SetEntityState
+    InEntity->SetActorTransform(InEntityTransform, false, nullptr, ETeleportType::ResetPhysics);
+
+    const AActor* defaultEntity = InEntity->GetClass()->GetDefaultObject<AActor>();
+    InEntity->SetActorHiddenInGame(defaultEntity->IsHidden());
+    InEntity->SetActorEnableCollision(defaultEntity->GetActorEnableCollision());
+    InEntity->SetActorTickEnabled(defaultEntity->PrimaryActorTick.bStartWithTickEnabled);
+
+    // Components of a Blueprint class have their template as archetype, whose tick setting may differ from its class default
+    TInlineComponentArray<UActorComponent*> components(InEntity);
+    for (UActorComponent* component : components)
+    {
+        const UActorComponent* componentArchetype = Cast<UActorComponent>(component->GetArchetype());
+        component->SetComponentTickEnabled(componentArchetype ? componentArchetype->PrimaryComponentTick.bStartWithTickEnabled
+                                                              : component->PrimaryComponentTick.bStartWithTickEnabled);
+    }
+
+    TInlineComponentArray<UPrimitiveComponent*> primComponents(InEntity);
+    for (UPrimitiveComponent* primComponent : primComponents)
+    {
+        if (primComponent->IsSimulatingPhysics())
+        {
+            primComponent->WakeAllRigidBodies();
+        }
+    }
+}
+
+void ASimulationState::ServerWarmupEntityPools()
+{
+    if (false == VerifyIsServerCall(TEXT("ServerWarmupEntityPools")) || !bEnableEntityPooling)
+    {
+        return;
+    }
+
+    URREntityIndexSubsystem* entityIndex = URREntityIndexSubsystem::Get(GetWorld());
+    FROSSpawnEntityReq warmupRequest;
+    for (const auto& entityType : SpawnableEntityTypes)
+    {
+        const TSubclassOf<AActor>& entityClass = entityType.Value;
+        if ((entityClass == nullptr) || entityClass->IsChildOf<ARRBaseRobot>())
+        {
+            continue;
+        }
+
+        const FRREntityPoolSettings& poolSettings = GetEntityPoolSettings(entityType.Key);
+        const int32 nWarmupEntities =
+            FMath::Min(poolSettings.WarmupSize, poolSettings.MaxPoolSize) - GetNumPooledEntities(entityType.Key);
+        const FName pooledBaseName = *FString::Printf(TEXT("Pooled_%s"), *entityType.Key);
+        warmupRequest.Xml = entityType.Key;
+        for (int32 i = 0; i < nWarmupEntities; ++i)
+        {
+            warmupRequest.State.Name = MakeUniqueObjectName(GetWorld()->PersistentLevel, entityClass, pooledBaseName).ToString();
+            AActor* entity = ServerBeginSpawnEntity(warmupRequest, entityClass, FTransform::Identity, 0);
+            if (entity)
+            {
+                entity = UGameplayStatics::FinishSpawningActor(entity, FTransform::Identity);
+            }
+            if (entity == nullptr)
+            {
+                UE_LOG_WITH_INFO(LogRapyutaCore, Error, TEXT("Failed to spawn pooled entity of model [%s]"), *entityType.Key);
+                break;
+            }
+
+            // Indexed as it has been spawned
+            if (entityIndex)
+            {
+                entityIndex->RemoveEntity(entity);
+            }
+            verify(ServerReleaseEntity(entity));
+        }
+    }
+}
@@ -669,6 +669,47 @@ public:
     static TMap<ERRFileType, TSharedPtr<IImageWrapper>> SImageWrappers;
     static void LoadImageWrapperModule();
 
+    //! Image wrappers which are not in use, by file type. Guarded by #SImageWrapperPoolMutex.
+    static TMap<ERRFileType, TArray<TSharedPtr<IImageWrapper>>> SImageWrapperPool;
+    static FCriticalSection SImageWrapperPoolMutex;
+
+    /**
+     * @brief Take an image wrapper of given file type from #SImageWrapperPool, or create one if none is free.
+     * Image wrappers keep state between SetRaw and GetCompressed, thus each thread needs its own one, unlike #SImageWrappers.
+     * Thread-safe once #LoadImageWrapperModule has been called on game thread.
+     * @param InImageFileType
+     * @return TSharedPtr<IImageWrapper> To be given back with #ReleaseImageWrapper
+     */
+    static TSharedPtr<IImageWrapper> AcquireImageWrapper(const ERRFileType InImageFileType);
+
+    /**
+     * @brief Give back an image wrapper taken with #AcquireImageWrapper. Thread-safe.
+     * @param InImageFileType
+     * @param InImageWrapper
+     */
+    static void ReleaseImageWrapper(const ERRFileType InImageFileType, TSharedPtr<IImageWrapper> InImageWrapper);
+
+    /**
+     * @brief Compress raw image data with a pooled image wrapper. Thread-safe once #LoadImageWrapperModule has been called.
+     * @param InImageFileType
+     * @param InRawData
+     * @param InRawSize [bytes]
+     * @param InImageSize
+     * @param InRGBFormat
+     * @param InBitDepth
+     * @param InQuality JPG quality in [1, 100], or EImageCompressionQuality::Default for the image wrapper default.
+     * Other formats use their default compression, PNG is always lossless.
+     * @param OutCompressedData
+     */
+    static void CompressImageData(const ERRFileType InImageFileType,
+                                  const void* InRawData,
+                                  const int64 InRawSize,
+                                  const FIntPoint& InImageSize,
+                                  const ERGBFormat InRGBFormat,
+                                  const int8 InBitDepth,
+                                  const int32 InQuality,
+                                  TArray64<uint8>& OutCompressedData);
+
     /**
      * @brief Load image to texture
      * @param InFullFilePath
@@ -705,40 +746,47 @@ public:
                                                    const FIntPoint& ImageSize,
                                                    const int8 BitDepth,    // normally 8
                                                    const ERGBFormat RGBFormat,
-                                                   TArray64<uint8>& OutCompressedData)
+                                                   TArray64<uint8>& OutCompressedData,
+                                                   const int32 InQuality = static_cast<int32>(EImageCompressionQuality::Default))
     {
-        TSharedPtr<IImageWrapper> imageWrapper = URRCoreUtils::SImageWrappers[InImageFileType];
-        verify(imageWrapper.IsValid());
         const auto& bitmap = InImageData.GetImageData<InBitDepth>();
 
+        // Get compressed data because uncompressed is the same fidelity, but much larger
+        // Unless given, JPG quality is 100 since EImageCompressionQuality::Default will make it 85, which is not optimal.
+        // Other file types, including grayscale JPG, use the image wrapper default.
+        // Please refer to FJpegImageWrapper, FPngImageWrapper for details
+        const bool bDefaultQuality = (static_cast<int32>(EImageCompressionQuality::Default) == InQuality);
+        const int32 quality = (bDefaultQuality && (ERRFileType::IMAGE_JPG == InImageFileType)) ? 100 : InQuality;
         if (ERGBFormat::Gray == RGBFormat)
         {
             // Ref :FLandscapeWeightmapFileFormat_Png::Export
             verify(URRActorCommon::IMAGE_BIT_DEPTH_INT8 == InBitDepth);
             TArray<uint8> grayBitmap;
+            grayBitmap.Reserve(bitmap.Num());
             for (const auto& color : bitmap)
             {
                 grayBitmap.Add(color.R);
             }
-            imageWrapper->SetRaw(grayBitmap.GetData(),
-                                 grayBitmap.Num(),
-                                 ImageSize.X,
-                                 ImageSize.Y,
-                                 ERGBFormat::Gray,
-                                 URRActorCommon::IMAGE_BIT_DEPTH_INT8);
+            CompressImageData(InImageFileType,
+                              grayBitmap.GetData(),
+                              grayBitmap.Num(),
+                              ImageSize,
+                              ERGBFormat::Gray,
+                              URRActorCommon::IMAGE_BIT_DEPTH_INT8,
+                              quality,
+                              OutCompressedData);
         }
         else
         {
-            imageWrapper->SetRaw(
-                bitmap.GetData(), bitmap.Num() * bitmap.GetTypeSize(), ImageSize.X, ImageSize.Y, RGBFormat, BitDepth);
+            CompressImageData(InImageFileType,
+                              bitmap.GetData(),
+                              bitmap.Num() * bitmap.GetTypeSize(),
+                              ImageSize,
+                              RGBFormat,
+                              BitDepth,
+                              quality,
+                              OutCompressedData);
         }
-
-        // Get compressed data because uncompressed is the same fidelity, but much larger
-        // EImageCompressionQuality::Default will make the Quality as 85, which is not optimal
-        // Besides, this Quality value only matters to JPG, PNG compression is always lossless
-        // Please refer to FJpegImageWrapper, FPngImageWrapper for details
-        OutCompressedData = imageWrapper->GetCompressed(
-            (ERRFileType::IMAGE_JPG == InImageFileType) ? 100 : static_cast<int32>(EImageCompressionQuality::Default));
     }
 
     // -------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,121 @@
+/**
+ * @file RREntityIndexSubsystem.h
+ * @brief World subsystem indexing actors by name and tag.
+ * @copyright Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+ */
+
+#pragma once
+
+// UE
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "RREntityIndexSubsystem.generated.h"
+
+/**
+ * @brief Index of actors of a game world by name, display name in editor, and tag.
+ * The index is built from all actors of the world on first lookup, then kept up to date with spawned actors, actors of
+ * added levels, destroyed actors, actors renamed with #RenameEntity and, in editor, relabeled actors. Actors renamed
+ * otherwise and removed tags are pruned lazily on lookup, thus lookups cost O(1) whatever the number of actors in the world.
+ * An actor renamed without #RenameEntity or tagged after being spawned is found by its new name or tag only after
+ * #IndexEntity, e.g. as done by #ASimulationState::ServerAddEntity.
+ * Only created for game worlds. @sa URRGeneralUtils::FindActorByName
+ */
+UCLASS()
+class RAPYUTASIMULATIONPLUGINS_API URREntityIndexSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    /**
+     * @brief Get entity index of given world.
+     * @param InWorld
+     * @return URREntityIndexSubsystem* nullptr if InWorld is null or is not a game world.
+     */
+    static URREntityIndexSubsystem* Get(const UWorld* InWorld);
+
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+    virtual void Deinitialize() override;
+
+    /**
+     * @brief Add or re-add entity with its current name, display name and tags, e.g. after it has been renamed or tagged.
+     * @param InEntity
+     */
+    UFUNCTION(BlueprintCallable)
+    void IndexEntity(AActor* InEntity);
+
+    /**
+     * @brief Remove entity from the index, e.g. before destroying it.
+     * @param InEntity
+     */
+    UFUNCTION(BlueprintCallable)
+    void RemoveEntity(AActor* InEntity);
+
+    /**
+     * @brief Rename entity, and its label in editor, then re-index it under its new name in the index of its world if any.
+     * @param InEntity
+     * @param InNewName
+     */
+    static void RenameEntity(AActor* InEntity, const FString& InNewName);
+
+    /**
+     * @brief Find entity by name, then by display name in editor.
+     * @param InName
+     * @param InCaseType
+     * @return AActor* nullptr if not found.
+     */
+    UFUNCTION(BlueprintCallable)
+    AActor* FindEntityByName(const FString& InName, const ESearchCase::Type InCaseType = ESearchCase::IgnoreCase);
+
+    /**
+     * @brief Get entities with given tag.
+     * @param InTag
+     * @param OutEntities
+     */
+    UFUNCTION(BlueprintCallable)
+    void GetEntitiesWithTag(const FName& InTag, TArray<AActor*>& OutEntities);
+
+    //! Number of indexed names, including stale ones which have not been pruned yet
+    int32 GetNumIndexedNames() const
+    {
+        return EntitiesByName.Num();
+    }
+
+protected:
+    virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+    /**
+     * @brief Index all actors of the world, once.
+     */
+    void BuildIndex();
+
+    void OnActorSpawned(AActor* InActor);
+
+    void OnLevelAddedToWorld(ULevel* InLevel, UWorld* InWorld);
+
+    //! Bound to OnDestroyed of each indexed entity
+    UFUNCTION()
+    void OnEntityDestroyed(AActor* InEntity);
+
+#if WITH_EDITOR
+    void OnActorLabelChanged(AActor* InActor);
+
+    FDelegateHandle ActorLabelChangedHandle;
+#endif
+
+    TMap<FString, TWeakObjectPtr<AActor>> EntitiesByName;
+
+#if WITH_EDITOR
+    TMap<FString, TWeakObjectPtr<AActor>> EntitiesByDisplayName;
+#endif
+
+    TMap<FName, TSet<TWeakObjectPtr<AActor>>> EntitiesByTag;
+
+    bool bIndexBuilt = false;
+
+    FDelegateHandle ActorSpawnedHandle;
+
+    FDelegateHandle LevelAddedHandle;
+};
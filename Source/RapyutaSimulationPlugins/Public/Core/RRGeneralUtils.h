@@ -14,6 +14,8 @@
 #include "PhysicsEngine/PhysicsConstraintComponent.h"
 #include "TimerManager.h"
 
+// RapyutaSimulationPlugins
+#include "Core/RREntityIndexSubsystem.h"
 // #include "Core/RRUObjectUtils.h"
 
 #include "RRGeneralUtils.generated.h"
@@ -32,6 +34,7 @@ class RAPYUTASIMULATIONPLUGINS_API URRGeneralUtils : public UBlueprintFunctionLi
 public:
     /**
      * @brief Find actor by name. GetAllActors() is expensive.
+     * In game worlds, actor is looked up in #URREntityIndexSubsystem, otherwise all actors are searched.
      *
      * @tparam T
      * @param InWorld
@@ -43,6 +46,16 @@ public:
     template<typename T>
     static T* FindActorByName(UWorld* InWorld, const FString& InName, const ESearchCase::Type InCaseType = ESearchCase::IgnoreCase)
     {
+        if (URREntityIndexSubsystem* entityIndex = URREntityIndexSubsystem::Get(InWorld))
+        {
+            T* actor = Cast<T>(entityIndex->FindEntityByName(InName, InCaseType));
+            if (actor == nullptr)
+            {
+                UE_LOG(LogTemp, Log, TEXT("Actor named [%s] is unavailable."), *InName);
+            }
+            return actor;
+        }
+
         for (TActorIterator<T> actorItr(InWorld); actorItr; ++actorItr)
         {
             if (actorItr->GetName().Equals(InName, InCaseType))
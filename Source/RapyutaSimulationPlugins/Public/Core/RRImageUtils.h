@@ -0,0 +1,128 @@
+/**
+ * @file RRImageUtils.h
+ * @brief Image utils, e.g. conversion of render target pixels and scene depth into ROS 2 image encodings.
+ * @copyright Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+ */
+
+#pragma once
+
+// UE
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+
+#include "RRImageUtils.generated.h"
+
+/**
+ * @brief ROS 2 image encodings which B8G8R8A8 pixels or scene depth can be converted into.
+ * @sa https://github.com/ros2/common_interfaces/blob/master/sensor_msgs/include/sensor_msgs/image_encodings.hpp
+ */
+UENUM(BlueprintType)
+enum class ERRImageEncoding : uint8
+{
+    RGB8 UMETA(DisplayName = "rgb8"),
+    BGR8 UMETA(DisplayName = "bgr8"),
+    BGRA8 UMETA(DisplayName = "bgra8"),
+    MONO8 UMETA(DisplayName = "mono8"),
+    //! Depth [m], as float
+    DEPTH_32FC1 UMETA(DisplayName = "32FC1"),
+    //! Depth [mm], as uint16
+    DEPTH_16UC1 UMETA(DisplayName = "16UC1")
+};
+
+/**
+ * @brief Image utils.
+ * BGRA conversions use SSSE3 or AVX2 when the target CPU always has them, with a scalar fallback which is also the
+ * reference implementation. Mono is computed as (38 * R + 75 * G + 15 * B + 64) >> 7, an integer approximation of ITU-R
+ * BT.601 luma, identically by all implementations.
+ * Depth conversions use SSE2 on x86, following REP 118: depth out of range is NaN in 32FC1 and 0 in 16UC1.
+ */
+UCLASS()
+class RAPYUTASIMULATIONPLUGINS_API URRImageUtils : public UBlueprintFunctionLibrary
+{
+    GENERATED_BODY()
+
+public:
+    /**
+     * @brief Get image encoding from its ROS 2 name.
+     * @param InEncoding e.g. "rgb8"
+     * @param OutEncoding
+     * @return false if InEncoding is not supported.
+     */
+    static bool GetImageEncoding(const FString& InEncoding, ERRImageEncoding& OutEncoding);
+
+    /**
+     * @brief Get ROS 2 name of image encoding.
+     * @param InEncoding
+     * @return FString
+     */
+    static FString GetImageEncodingName(const ERRImageEncoding InEncoding);
+
+    /**
+     * @brief Get number of bytes per pixel of image encoding, e.g. to compute image Step as Width * bytes per pixel.
+     * @param InEncoding
+     * @return int32
+     */
+    static int32 GetBytesPerPixel(const ERRImageEncoding InEncoding);
+
+    /**
+     * @brief Whether encoding is a depth encoding, which is converted from scene depth with #ConvertDepth.
+     * @param InEncoding
+     * @return true if InEncoding is 32FC1 or 16UC1.
+     */
+    static bool IsDepthEncoding(const ERRImageEncoding InEncoding);
+
+    /**
+     * @brief Convert B8G8R8A8 pixels into given encoding, with SIMD if available.
+     * @param InPixels
+     * @param InNumPixels
+     * @param InEncoding
+     * @param OutData Should have room for InNumPixels * #GetBytesPerPixel(InEncoding) bytes
+     */
+    static void ConvertBGRA(const FColor* InPixels, const int32 InNumPixels, const ERRImageEncoding InEncoding, uint8* OutData);
+
+    /**
+     * @brief Scalar reference of #ConvertBGRA.
+     * @param InPixels
+     * @param InNumPixels
+     * @param InEncoding
+     * @param OutData
+     */
+    static void ConvertBGRAScalar(const FColor* InPixels,
+                                  const int32 InNumPixels,
+                                  const ERRImageEncoding InEncoding,
+                                  uint8* OutData);
+
+    /**
+     * @brief Convert scene depth into given depth encoding, with SIMD if available.
+     * Depth out of [InMinDepth, InMaxDepth] is NaN in 32FC1 and 0 in 16UC1. 16UC1 depth is rounded to nearest mm, and is 0
+     * above 65535 mm as well.
+     * @param InPixels Scene depth [cm] in R channel, as read back from a R32F render target
+     * @param InNumPixels
+     * @param InEncoding 32FC1 or 16UC1
+     * @param InMinDepth [m]
+     * @param InMaxDepth [m]
+     * @param OutData Should have room for InNumPixels * #GetBytesPerPixel(InEncoding) bytes
+     */
+    static void ConvertDepth(const FLinearColor* InPixels,
+                             const int32 InNumPixels,
+                             const ERRImageEncoding InEncoding,
+                             const float InMinDepth,
+                             const float InMaxDepth,
+                             uint8* OutData);
+
+    /**
+     * @brief Scalar reference of #ConvertDepth.
+     * @param InPixels
+     * @param InNumPixels
+     * @param InEncoding
+     * @param InMinDepth
+     * @param InMaxDepth
+     * @param OutData
+     */
+    static void ConvertDepthScalar(const FLinearColor* InPixels,
+                                   const int32 InNumPixels,
+                                   const ERRImageEncoding InEncoding,
+                                   const float InMinDepth,
+                                   const float InMaxDepth,
+                                   uint8* OutData);
+};
@@ -94,6 +94,11 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated)
     bool bPublishOdomTf = false;
 
+    //! Publish odom tf through the world's shared /tf publisher, together with odom tfs of other robots.
+    //! @sa URRROS2OdomPublisher::bAggregateOdomTf
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated)
+    bool bAggregateOdomTf = false;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated)
     float OdomPublicationFrequencyHz = 30;
 
@@ -150,6 +155,11 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated)
     float JointTfPublicationFrequencyHz = 1.f;
 
+    //! Publish tfs of joints without DOF once on /tf_static, and other joint tfs only when they move.
+    //! @sa URRROS2TFsPublisher::bSplitStaticTFs
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated)
+    bool bSplitStaticJointTf = false;
+
     //! Odom publisher
     UPROPERTY(Transient, BlueprintReadWrite, Replicated)
     TObjectPtr<URRROS2OdomPublisher> OdomPublisher = nullptr;
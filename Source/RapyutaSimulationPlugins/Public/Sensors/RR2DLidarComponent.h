@@ -44,16 +44,6 @@ public:
     */
     URR2DLidarComponent();
 
-    /**
-     * @brief
-     * async: Update #RecordedHits from #TraceHandles which is update in #SensorUpdate.
-     *
-     * @param DeltaTime
-     * @param TickType
-     * @param ThisTickFunction
-     */
-    virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
-
     /**
      * @brief
      * sync:  Initialize #FHitResult
@@ -62,9 +52,9 @@ public:
     void Run() override;
 
     /**
-     * @brief Get Lidar data, add noise, draw lidar rays.
+     * @brief Issue traces of new scan if pipeline is free.
      * sync  : Uses LineTraceSingleByChannel to get lidar data.
-     * async : Uses AsyncLineTraceByChannel to get lidar data.
+     * async : Uses AsyncLineTraceByChannel to get lidar data, which are collected in #TickComponent.
      *
      * @sa [LineTraceSingleByChannel](https://docs.unrealengine.com/5.1/en-US/API/Runtime/Engine/Engine/UWorld/LineTraceSingleByChannel/)
      * @sa [AsyncLineTraceByChannel](https://docs.unrealengine.com/5.1/en-US/API/Runtime/Engine/Engine/UWorld/AsyncLineTraceSingleByChannel/)
@@ -81,12 +71,12 @@ public:
 
     UFUNCTION(BlueprintCallable)
     /**
-     * @brief Create ROS 2 Msg structure from #RecordedHits
+     * @brief Get ROS 2 Msg structure created from #RecordedHits in #ProcessScan
      * This should probably be removed so that the sensor can be decoupled from the message types
      *
-     * @return FROSLaserScan
+     * @return const FROSLaserScan& Reference to the msg, thus its storage is not copied.
      */
-    FROSLaserScan GetROS2Data();
+    const FROSLaserScan& GetROS2Data() const;
 
     /**
      * @brief Set result of #GetROS2Data to
@@ -100,4 +90,26 @@ public:
 
     UFUNCTION(BlueprintCallable)
     float GetMaxAngleRadians() const;
+
+    //! Number of scans which had to grow #ProcessingLaserScanMsg storage. Stays constant once scan size is stable.
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Stats")
+    int32 NumScanReallocations = 0;
+
+protected:
+    /**
+     * @brief Add noise and create #ProcessingLaserScanMsg from scan. May be called on worker thread.
+     * @param InOutScan
+     */
+    virtual void ProcessScan(FRRLidarScan& InOutScan) override;
+
+    /**
+     * @brief Swap #ProcessingLaserScanMsg into #LaserScanMsg and update its header.
+     */
+    virtual void OnScanProcessed() override;
+
+    //! Msg of #RecordedHits, which is published.
+    FROSLaserScan LaserScanMsg;
+
+    //! Msg being created in #ProcessScan, swapped with #LaserScanMsg once ready.
+    FROSLaserScan ProcessingLaserScanMsg;
 };
@@ -12,12 +12,54 @@
 
 // rclUE
 #include "Msgs/ROS2PointCloud2.h"
+#include "Msgs/ROS2PointField.h"
 
 // RapyutaSimulationPlugins
 #include "Sensors/RRBaseLidarComponent.h"
 
 #include "RR3DLidarComponent.generated.h"
 
+/**
+ * @brief Point fields layout of PointCloud2 created by #URR3DLidarComponent
+ */
+UENUM(BlueprintType)
+enum class ERRLidarPointCloudLayout : uint8
+{
+    XYZ UMETA(DisplayName = "xyz", ToolTip = "x, y, z as float32. 12 bytes per point."),
+    XYZI UMETA(DisplayName = "xyz + intensity", ToolTip = "x, y, z, intensity as float32. 16 bytes per point."),
+    FULL UMETA(DisplayName = "Full", ToolTip = "x, y, z, intensity as float32, ring as uint16, time as float32. 22 bytes.")
+};
+
+/**
+ * @brief Parameters of #URR3DLidarComponent::SerializePointCloud.
+ * Kept independent from the component so that serialization can be run on synthetic hits without a world.
+ */
+struct RAPYUTASIMULATIONPLUGINS_API FRRPointCloudSerializeParams
+{
+    //! Sensor transform in world frame. Hits are converted into this frame.
+    FTransform SensorTransform = FTransform::Identity;
+
+    //! Per column sensor transforms in world frame. If its size is #NSamplesPerScan, hits are converted into the frame of
+    //! their column instead of #SensorTransform.
+    TArrayView<const FTransform> ColumnTransforms;
+
+    //! [s] Column i is stamped with i / #NSamplesPerScan * ScanPeriod in the time field.
+    float ScanPeriod = 0.f;
+
+    int32 NSamplesPerScan = 0;
+
+    int32 NChannelsPerScan = 0;
+
+    //! true: height=#NChannelsPerScan, width=#NSamplesPerScan, false: height=1, width=number of valid hits
+    bool bOrganizedCloud = false;
+
+    ERRLidarPointCloudLayout Layout = ERRLidarPointCloudLayout::FULL;
+
+    float IntensityNonReflective = 1000.f;
+
+    float IntensityReflective = 6000.f;
+};
+
 /**
  * @brief ROS 2 3D lidar components.
  * This class has 2 types of implementation, async and sync which can be switched by define TRACE_ASYNC.
@@ -38,16 +80,6 @@ public:
     */
     URR3DLidarComponent();
 
-    /**
-     * @brief
-     * async: Update #RecordedHits from #TraceHandles which is update in #SensorUpdate.
-     *
-     * @param DeltaTime
-     * @param TickType
-     * @param ThisTickFunction
-     */
-    virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
-
     /**
      * @brief
      * sync:  Initialize #FHitResult
@@ -56,9 +88,9 @@ public:
     virtual void Run() override;
 
     /**
-     * @brief Get Lidar data, add noise, draw lidar rays.
+     * @brief Issue traces of new scan if pipeline is free.
      * sync  : Uses LineTraceSingleByChannel to get lidar data.
-     * async : Uses AsyncLineTraceByChannel to get lidar data.
+     * async : Uses AsyncLineTraceByChannel to get lidar data, which are collected in #TickComponent.
      *
      * @sa [LineTraceSingleByChannel](https://docs.unrealengine.com/5.1/en-US/API/Runtime/Engine/Engine/UWorld/LineTraceSingleByChannel/)
      * @sa [AsyncLineTraceByChannel](https://docs.unrealengine.com/5.1/en-US/API/Runtime/Engine/Engine/UWorld/AsyncLineTraceSingleByChannel/)
@@ -67,6 +99,7 @@ public:
 
     /**
      * @brief Return true if laser hits the target actor.
+     * Answered from #RecordedHits if they are not older than #VisibleStalenessTolerance, otherwise by #VisibleInCone.
      * @param TargetActor
      * @return true
      * @return false
@@ -74,7 +107,30 @@ public:
     virtual bool Visible(AActor* TargetActor) override;
 
     /**
-     * @brief Create ROS 2 Msg structure from #RecordedHits
+     * @brief Return true if laser hits the target actor, by tracing only rays of the scan pattern which are inside the cone
+     * from the sensor to the target's bounding sphere. Stops as soon as the target is hit.
+     * @param TargetActor
+     * @return true
+     * @return false
+     */
+    UFUNCTION(BlueprintCallable)
+    bool VisibleInCone(AActor* TargetActor);
+
+    /**
+     * @brief Return true if laser hits the target actor, by tracing the whole scan pattern.
+     * @param TargetActor
+     * @return true
+     * @return false
+     */
+    UFUNCTION(BlueprintCallable)
+    bool VisibleFullScan(AActor* TargetActor);
+
+    //! [s] #Visible answers from #RecordedHits if they are not older than this. Negative: always trace.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float VisibleStalenessTolerance = 0.2f;
+
+    /**
+     * @brief Get ROS 2 Msg structure created from #RecordedHits in #ProcessScan
      * This should probably be removed so that the sensor can be decoupled from the message types
      * @return FROSPointCloud2
      */
@@ -82,12 +138,47 @@ public:
     virtual FROSPointCloud2 GetROS2Data();
 
     /**
-     * @brief Set result of #GetROS2Data to InMessage.
+     * @brief Set result of #GetROS2Data to InMessage. Msg has already been created on worker thread.
      *
      * @param InMessage
      */
     virtual void SetROS2Msg(UROS2GenericMsg* InMessage) override;
 
+    /**
+     * @brief Serialize hits into PointCloud2 fields and data in parallel.
+     * Output data buffer is resized once and each worker writes its own range of points directly into it.
+     * Hits without physical material are skipped for unorganized cloud and written as NaN for organized cloud.
+     * Points are written in reverse order of InHits since ROS is right handed while UE is left handed.
+     *
+     * @param InParams
+     * @param InHits Hits ordered by `sample index + channel index * NSamplesPerScan`
+     * @param InIntensityNoises Per hit relative intensity noise, intensity is scaled by (1 + noise).
+     * Ignored if its size is different from InHits.
+     * @param OutMsg Fields, PointStep, Data, Width, Height, RowStep and bIsDense are updated. Header is not touched.
+     */
+    static void SerializePointCloud(const FRRPointCloudSerializeParams& InParams,
+                                    const TArray<FHitResult>& InHits,
+                                    const TArray<float>& InIntensityNoises,
+                                    FROSPointCloud2& OutMsg);
+
+    /**
+     * @brief Get size of single point in bytes for given layout
+     * @param InLayout
+     * @return uint32
+     */
+    static uint32 GetPointStep(const ERRLidarPointCloudLayout InLayout);
+
+    /**
+     * @brief Set PointCloud2 fields for given layout
+     * @param InLayout
+     * @param OutFields
+     */
+    static void SetPointFields(const ERRLidarPointCloudLayout InLayout, TArray<FROSPointField>& OutFields);
+
+    //! Point fields of published PointCloud2.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    ERRLidarPointCloudLayout PointCloudLayout = ERRLidarPointCloudLayout::FULL;
+
     // vertical samples
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     int32 NChannelsPerScan = 32;
@@ -119,4 +210,36 @@ public:
     //! [degrees]
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
     float DVAngle = 0.f;
+
+protected:
+    /**
+     * @brief Get trace params used by #VisibleInCone and #VisibleFullScan
+     * @return FCollisionQueryParams
+     */
+    FCollisionQueryParams GetVisibleTraceParams() const;
+
+    /**
+     * @brief Add noise and serialize scan into #ProcessingPointCloudMsg with #SerializePointCloud.
+     * May be called on worker thread.
+     * @param InOutScan
+     */
+    virtual void ProcessScan(FRRLidarScan& InOutScan) override;
+
+    /**
+     * @brief Swap #ProcessingPointCloudMsg into #PointCloudMsg and update its header.
+     */
+    virtual void OnScanProcessed() override;
+
+    //! Msg of #RecordedHits, which is published. Reused across scans to avoid reallocating data buffer.
+    UPROPERTY()
+    FROSPointCloud2 PointCloudMsg;
+
+    //! Msg being created in #ProcessScan, swapped with #PointCloudMsg once ready.
+    FROSPointCloud2 ProcessingPointCloudMsg;
+
+    /**
+     * @brief Get scan pattern including vertical channels.
+     * @return FRRLidarScanPattern
+     */
+    virtual FRRLidarScanPattern GetScanPattern() const override;
 };
@@ -12,34 +12,131 @@
 #include <random>
 
 // UE
+#include "Async/Future.h"
 #include "Components/StaticMeshComponent.h"
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
 
 // RapyutaSimulationPlugins
 #include "RRROS2BaseSensorComponent.h"
+#include "Sensors/RRLidarDebugPointsComponent.h"
 
 #include "RRBaseLidarComponent.generated.h"
 
 #define TRACE_ASYNC 1
 
+DECLARE_STATS_GROUP(TEXT("RRLidar"), STATGROUP_RRLidar, STATCAT_Advanced);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lidar SensorUpdate"), STAT_RRLidarSensorUpdate, STATGROUP_RRLidar, RAPYUTASIMULATIONPLUGINS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lidar collect traces"),
+                          STAT_RRLidarCollectTraces,
+                          STATGROUP_RRLidar,
+                          RAPYUTASIMULATIONPLUGINS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lidar process scan"), STAT_RRLidarProcessScan, STATGROUP_RRLidar, RAPYUTASIMULATIONPLUGINS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lidar set ROS2 msg"), STAT_RRLidarSetROS2Msg, STATGROUP_RRLidar, RAPYUTASIMULATIONPLUGINS_API);
+
 class URRROS2LidarPublisher;
+class URRLidarStaticGeometryCache;
+class URRLidarTraceScheduler;
+
+/**
+ * @brief Scan pattern parameters which lidar ray direction table is built from.
+ * Used to detect changes of lidar properties and rebuild the table only when needed.
+ */
+struct FRRLidarScanPattern
+{
+    int32 NSamplesPerScan = 0;
+    int32 NChannelsPerScan = 0;
+    float StartAngle = 0.f;
+    float FOVHorizontal = 0.f;
+    float StartVerticalAngle = 0.f;
+    float FOVVertical = 0.f;
+
+    bool operator==(const FRRLidarScanPattern& InOther) const
+    {
+        return (NSamplesPerScan == InOther.NSamplesPerScan) && (NChannelsPerScan == InOther.NChannelsPerScan) &&
+               (StartAngle == InOther.StartAngle) && (FOVHorizontal == InOther.FOVHorizontal) &&
+               (StartVerticalAngle == InOther.StartVerticalAngle) && (FOVVertical == InOther.FOVVertical);
+    }
+
+    bool operator!=(const FRRLidarScanPattern& InOther) const
+    {
+        return !(*this == InOther);
+    }
+};
+
+/**
+ * @brief Single lidar scan, which moves through the scan pipeline of #URRBaseLidarComponent:
+ * traced -> processed (noise, message creation) -> recorded & published.
+ */
+struct RAPYUTASIMULATIONPLUGINS_API FRRLidarScan
+{
+    TArray<FHitResult> Hits;
+
+    //! Sensor transform in world frame when traces were issued
+    FTransform SensorTransform = FTransform::Identity;
+
+    //! Per column sensor transforms in world frame. Empty if motion distortion is not simulated.
+    TArray<FTransform> ColumnTransforms;
+
+    //! Scan pattern which #Hits are ordered by.
+    FRRLidarScanPattern Pattern;
+
+    //! [s] Simulation time when traces were issued
+    float Time = 0.f;
+
+    //! [s] Scan period, i.e. time spanned by #ColumnTransforms
+    float Period = 0.f;
+
+    //! [s] Platform time when traces were issued, used for latency stats
+    double IssueTime = 0.0;
+};
 
 /**
  * @brief Base ROS 2 LIDAR Component class. Other lidar class should inherit from this class.
- *
+ * Scans go through a triple buffered pipeline: while scan N+1 is being traced, scan N is noised and converted to ROS 2 msg on a
+ * worker thread (if #bProcessScanAsync), and scan N-1 is kept in #RecordedHits and published.
  */
 UCLASS(ClassGroup = (Custom), Blueprintable, meta = (BlueprintSpawnableComponent))
 class RAPYUTASIMULATIONPLUGINS_API URRBaseLidarComponent : public URRROS2BaseSensorComponent
 {
     GENERATED_BODY()
 
+    friend class URRLidarTraceScheduler;
+
 public:
     URRBaseLidarComponent();
 
 protected:
     virtual void BeginPlay() override;
 
+    /**
+     * @brief Wait for the scan being processed on a worker thread.
+     * @param EndPlayReason
+     */
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
+    /**
+     * @brief
+     * async: Update #TracingScan from #TraceHandles which is update in #SensorUpdate.
+     * Then move scans forward through the pipeline with #UpdateScanPipeline.
+     *
+     * @param DeltaTime
+     * @param TickType
+     * @param ThisTickFunction
+     */
+    virtual void TickComponent(float DeltaTime, enum ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+    /**
+     * @brief Register to world's #URRLidarTraceScheduler if #bUseTraceScheduler, otherwise start own timer.
+     */
+    virtual void Run() override;
+
+    /**
+     * @brief Unregister from #URRLidarTraceScheduler and stop own timer.
+     */
+    virtual void Stop() override;
+
     /**
      * @brief Return true if laser hits the target actor. This method should be overwritten by child class.
      * @param TargetActor
@@ -129,24 +226,57 @@ public:
     UPROPERTY(EditAnywhere, Category = "Noise")
     uint8 BWithNoise : 1;
 
+    //! Hits of the last processed scan. Noise has been already applied.
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
     TArray<FHitResult> RecordedHits;
 
+    //! Add noise and create ROS 2 msg of a traced scan on a worker thread, while next scan is being traced.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool bProcessScanAsync = true;
+
+    //! Let world's #URRLidarTraceScheduler update this lidar and trace its scans together with other lidars, instead of
+    //! running own timer. Applied in #Run.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool bUseTraceScheduler = false;
+
+    //! Trace static geometry in world's #URRLidarStaticGeometryCache, so that physics scene only traces dynamic objects.
+    //! Applied in BeginPlay.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool bUseStaticGeometryCache = false;
+
+    //! [s] Platform time from issuing traces of the last published scan to handing it to publisher
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Stats")
+    float ScanLatency = 0.f;
+
+    //! [ms] Game thread time spent by this lidar in the previous frame
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Stats")
+    float GameThreadTime = 0.f;
+
 #if TRACE_ASYNC
     TArray<FTraceHandle> TraceHandles;
 #endif
 
+    //! Draw hits of #RecordedHits with #DebugPointsComponent, colored by intensity
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     bool bShowLidarRays = true;
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     bool ShowLidarRayMisses = false;
 
-    //! DepthIntesity of DrawPoint
+    //! Depth priority group of drawn points, applied when #DebugPointsComponent is created
     //! @sa https://docs.unrealengine.com/4.27/en-US/API/Runtime/Engine/Components/ULineBatchComponent/DrawPoint/
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     uint8 DrawPointDepthIntensity = 0;
 
+    //! Draw every Nth ray only
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1"))
+    int32 DebugDrawDecimation = 1;
+
+    //! Max number of drawn points per scan. Decimation is increased further if needed, thus render cost is bounded whatever
+    //! the scan size.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (ClampMin = "1"))
+    int32 MaxDebugPoints = 20000;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Intensity")
     float IntensityNonReflective = 1000.f;
 
@@ -161,10 +291,271 @@ public:
 
     FLinearColor InterpColorFromIntensity(const float InIntensity);
 
+    /**
+     * @brief Update #LocalRayDirections if scan pattern has been changed, then rotate them by the component rotation into
+     * #WorldRayDirections.
+     * @param bInWithColumnTransforms Rotate each column by #TracingScan's ColumnTransforms instead, if they are available.
+     */
+    void UpdateRayDirections(const bool bInWithColumnTransforms = false);
+
+    /**
+     * @brief Same as #UpdateRayDirections but into OutWorldRayDirections, e.g. for one-off traces which must not touch
+     * #WorldRayDirections while a scan using them may still be traced.
+     * @param OutWorldRayDirections
+     * @param bInWithColumnTransforms
+     */
+    void UpdateRayDirections(TArray<FVector>& OutWorldRayDirections, const bool bInWithColumnTransforms = false);
+
+    //! Spread a scan over the sensor motion since the previous scan instead of tracing it from a single pose.
+    //! Each column is traced from the pose interpolated between previous and current component transforms.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool bSimulateMotionDistortion = false;
+
+    /**
+     * @brief Get time of the first column of the last scan.
+     * @return float #TimeOfLastScan, or #TimeOfLastScan - scan period if #bSimulateMotionDistortion.
+     */
+    UFUNCTION(BlueprintCallable)
+    float GetScanStartTime() const;
+
 protected:
     UPROPERTY()
     float Dt = 0.f;
 
+    /**
+     * @brief Prepare #TracingScan for tracing: update column transforms, ray directions and buffer sizes.
+     * Should be called by child class before issuing traces.
+     * @return false if previous scan is still being traced or waiting for processing, thus new scan can not be started.
+     */
+    bool BeginScan();
+
+    /**
+     * @brief Trace #TracingScan, either by queuing it to #TraceScheduler or directly.
+     * Should be called by child class after #BeginScan succeeded.
+     * @param InTraceParams
+     */
+    void TraceScan(const FCollisionQueryParams& InTraceParams);
+
+#if TRACE_ASYNC
+    /**
+     * @brief Issue async traces of all rays of #TracingScan into #TraceHandles. Results are collected in #CollectTraces.
+     * @param InTraceParams
+     */
+    void IssueAsyncTraces(const FCollisionQueryParams& InTraceParams);
+#else
+    /**
+     * @brief Trace a ray of #TracingScan. Thread-safe, thus can be called from ParallelFor.
+     * @param InRayIndex
+     * @param InTraceParams
+     */
+    void TraceRay(const int32 InRayIndex, const FCollisionQueryParams& InTraceParams);
+#endif
+
+    /**
+     * @brief Mark #TracingScan as traced and pass it to #UpdateScanPipeline.
+     */
+    void OnScanTraced();
+
+    /**
+     * @brief Discard #TracingScan which has been begun but not traced yet.
+     */
+    void CancelScan();
+
+    //! Scheduler this lidar is registered to, if any
+    UPROPERTY()
+    TObjectPtr<URRLidarTraceScheduler> TraceScheduler = nullptr;
+
+    //! Static geometry cache, if #bUseStaticGeometryCache
+    UPROPERTY()
+    TObjectPtr<URRLidarStaticGeometryCache> StaticGeometryCache = nullptr;
+
+    //! #TracingScan is traced against #StaticGeometryCache first, then physics scene up to the static hits
+    bool bTraceStaticGeometryCache = false;
+
+    /**
+     * @brief Replace a static hit from #StaticGeometryCache by a closer dynamic hit from physics scene.
+     * @param InOutHit
+     * @param InDynamicHit
+     */
+    static void SetDynamicHit(FHitResult& InOutHit, const FHitResult& InDynamicHit);
+
+    /**
+     * @brief Commit the processed scan if its processing is done, and start processing the traced scan if any.
+     */
+    void UpdateScanPipeline();
+
+    /**
+     * @brief Move #ProcessingScan into #RecordedHits and call #OnScanProcessed.
+     */
+    void CommitProcessedScan();
+
+    /**
+     * @brief Process a traced scan. Runs on a worker thread if #bProcessScanAsync, thus must not touch game thread state.
+     * Child class should call Super then create its ROS 2 msg from InOutScan.
+     * @param InOutScan
+     */
+    virtual void ProcessScan(FRRLidarScan& InOutScan);
+
+    /**
+     * @brief Called on game thread after #ProcessingScan has been moved into #RecordedHits.
+     * Child class should make the msg created in #ProcessScan available to #SetROS2Msg.
+     */
+    virtual void OnScanProcessed()
+    {
+    }
+
+    /**
+     * @brief Update #ScanLatency. Should be called by child class when msg is handed to publisher.
+     */
+    void OnScanPublished();
+
+#if TRACE_ASYNC
+    /**
+     * @brief Collect results of #TraceHandles into #TracingScan, then call #OnScanTraced once all of them are available.
+     */
+    void CollectTraces();
+#endif
+
+    //! Scan being traced
+    FRRLidarScan TracingScan;
+
+    //! Scan being processed
+    FRRLidarScan ProcessingScan;
+
+    //! [s] Platform time when traces of #RecordedHits were issued
+    double RecordedScanIssueTime = 0.0;
+
+    //! Traces of #TracingScan are in flight
+    bool bTracing = false;
+
+    //! #TracingScan has been traced and is waiting for #ProcessingScan to be free
+    bool bScanTraced = false;
+
+    TFuture<void> ScanProcessingFuture;
+
+    //! [s] Game thread time accumulated in current frame
+    double GameThreadTimeAccum = 0.0;
+
+    /**
+     * @brief Accumulate game thread time spent in its scope into #GameThreadTimeAccum
+     */
+    struct FScopedGameThreadTime
+    {
+        FScopedGameThreadTime(double& InOutAccum) : Accum(InOutAccum), StartTime(FPlatformTime::Seconds())
+        {
+        }
+
+        ~FScopedGameThreadTime()
+        {
+            Accum += FPlatformTime::Seconds() - StartTime;
+        }
+
+        double& Accum;
+        double StartTime;
+    };
+
+    /**
+     * @brief Get current scan pattern. 2D lidar has a single channel, which should be overridden by child class with vertical
+     * channels.
+     * @return FRRLidarScanPattern
+     */
+    virtual FRRLidarScanPattern GetScanPattern() const;
+
+    /**
+     * @brief Rebuild #LocalRayDirections from given scan pattern. Ray index is `IdxX + IdxY * NSamplesPerScan`.
+     * @param InScanPattern
+     */
+    void BuildLocalRayDirections(const FRRLidarScanPattern& InScanPattern);
+
+    //! Unit ray directions in component frame, cached until scan pattern is changed.
+    TArray<FVector> LocalRayDirections;
+
+    //! Unit ray directions in world frame, updated in #UpdateRayDirections for each scan.
+    TArray<FVector> WorldRayDirections;
+
+    //! Scan pattern which #LocalRayDirections is built from.
+    FRRLidarScanPattern CachedScanPattern;
+
+    /**
+     * @brief Add #PositionNoise to ImpactPoint and TraceEnd of given hits.
+     * Samples are filled in one batch beforehand, thus noise can be applied in parallel.
+     * @param InOutHits
+     */
+    void AddPositionNoise(TArray<FHitResult>& InOutHits);
+
+    //! Position noise samples, 6 per hit, reused across scans.
+    TArray<float> PositionNoiseSamples;
+
+    //! Per hit intensity noise, reused across scans.
+    TArray<float> IntensityNoises;
+
+    //! Draws #RecordedHits as a single point set. Created on first drawn scan.
+    UPROPERTY()
+    TObjectPtr<URRLidarDebugPointsComponent> DebugPointsComponent = nullptr;
+
+    //! Debug points of #ProcessingScan, built in #ProcessScan and handed to #DebugPointsComponent in #UpdateDebugPoints.
+    TArray<FRRLidarDebugPoint> ProcessingDebugPoints;
+
+    //! Bounds of #ProcessingDebugPoints
+    FBox ProcessingDebugBounds = FBox(ForceInit);
+
+    /**
+     * @brief Build #ProcessingDebugPoints from decimated hits if #bShowLidarRays. Called from #ProcessScan.
+     * @param InHits
+     */
+    void BuildDebugPoints(const TArray<FHitResult>& InHits);
+
+    /**
+     * @brief Hand #ProcessingDebugPoints over to #DebugPointsComponent, creating it if needed. Called on game thread when
+     * processed scan is committed, with constant cost whatever the number of points.
+     */
+    void UpdateDebugPoints();
+
+    /**
+     * @brief Get debug color of a blocking hit from its surface type intensity, attenuated by distance.
+     * @param InHit
+     * @return FLinearColor
+     */
+    FLinearColor GetDebugColorFromHit(const FHitResult& InHit);
+
+    /**
+     * @brief Update #TracingScan's ColumnTransforms by interpolating between #PreviousScanTransform and current component
+     * transform if #bSimulateMotionDistortion, otherwise clear them. Should be called once per scan.
+     */
+    void UpdateColumnTransforms();
+
+    /**
+     * @brief Get origin of given ray, either from #TracingScan's ColumnTransforms or InLidarPos if they are not used.
+     * @param InRayIndex
+     * @param InLidarPos
+     * @return FVector
+     */
+    FORCEINLINE FVector GetRayOrigin(const int32 InRayIndex, const FVector& InLidarPos) const
+    {
+        const TArray<FTransform>& columnTransforms = TracingScan.ColumnTransforms;
+        return (columnTransforms.Num() > 0) ? columnTransforms[InRayIndex % columnTransforms.Num()].GetLocation() : InLidarPos;
+    }
+
+    //! Component transform at the previous scan.
+    FTransform PreviousScanTransform = FTransform::Identity;
+
+    bool bPreviousScanTransformValid = false;
+
+    //! Number of rays rotated per ParallelFor task in #UpdateRayDirections
+    static constexpr int32 RAY_BATCH_SIZE = 1024;
+
     FLinearColor InterpolateColor(float InX);
     static float GetIntensityFromDist(float InBaseIntensity, float InDistance);
+
+    /**
+     * @brief Get intensity of a hit from its physical material surface type, without noise.
+     * SurfaceType1: retroreflective, SurfaceType_Default: non-reflective, SurfaceType2: reflective depending on incident angle.
+     * Thread-safe, thus can be called from ParallelFor.
+     *
+     * @param InHit
+     * @param InIntensityNonReflective
+     * @param InIntensityReflective
+     * @return float 0 if hit has no physical material or unknown surface type.
+     */
+    static float GetIntensityFromHit(const FHitResult& InHit, float InIntensityNonReflective, float InIntensityReflective);
 };
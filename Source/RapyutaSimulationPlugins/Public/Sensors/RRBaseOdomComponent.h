@@ -51,6 +51,13 @@ public:
 
     virtual void PreInitializePublisher(UROS2NodeComponent* InROS2Node, const FString& InTopicName) override;
 
+    /**
+     * @brief Unregister odom tf of the publisher from #URRROS2FleetTFSubsystem, with URRROS2OdomPublisher::DeInitializeTF.
+     *
+     * @param EndPlayReason
+     */
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
     UPROPERTY(BlueprintReadWrite)
     TWeakObjectPtr<ARRBaseRobot> RobotVehicle = nullptr;
 
@@ -99,6 +106,11 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     bool bPublishOdomTf = false;
 
+    //! Publish tf through the world's shared /tf publisher.
+    //! @sa URRROS2OdomPublisher::bAggregateOdomTf
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool bAggregateOdomTf = false;
+
     UPROPERTY(VisibleAnywhere)
     bool bIsOdomInitialized = false;
 
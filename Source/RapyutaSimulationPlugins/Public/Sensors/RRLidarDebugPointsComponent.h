@@ -0,0 +1,69 @@
+/**
+ * @file RRLidarDebugPointsComponent.h
+ * @brief Primitive component drawing a lidar scan as a single point set.
+ * @copyright Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+ */
+
+#pragma once
+
+// UE
+#include "Components/PrimitiveComponent.h"
+#include "CoreMinimal.h"
+
+#include "RRLidarDebugPointsComponent.generated.h"
+
+/**
+ * @brief Debug point of a lidar scan, in world frame.
+ */
+struct FRRLidarDebugPoint
+{
+    FVector3f Position = FVector3f::ZeroVector;
+
+    //! [cm] Drawn as an octahedron of this diagonal
+    float Size = 0.f;
+
+    FLinearColor Color = FLinearColor::White;
+};
+
+//! Points of a scan, immutable once given to #URRLidarDebugPointsComponent, thus shared with render thread
+using FRRLidarDebugPointsPtr = TSharedPtr<const TArray<FRRLidarDebugPoint>, ESPMode::ThreadSafe>;
+
+/**
+ * @brief Draw lidar scan points as a single mesh batch, instead of pushing them one by one to the world line batcher.
+ * Points are given in world frame for a whole scan with #SetPoints, which shares the buffer with the scene proxy without
+ * copying it, thus game thread cost does not depend on the number of points. The proxy builds vertex and index buffers
+ * of the scan once on render thread, then draws them with a single mesh batch per view, thus per frame cost does not
+ * depend on the number of points either. Points are drawn until next #SetPoints call.
+ */
+UCLASS(ClassGroup = (Custom))
+class RAPYUTASIMULATIONPLUGINS_API URRLidarDebugPointsComponent : public UPrimitiveComponent
+{
+    GENERATED_BODY()
+
+public:
+    URRLidarDebugPointsComponent();
+
+    /**
+     * @brief Replace drawn points. InPoints is moved into #Points, which is shared with render thread.
+     * @param InPoints Points in world frame
+     * @param InBounds Bounds of InPoints
+     */
+    void SetPoints(TArray<FRRLidarDebugPoint>&& InPoints, const FBox& InBounds);
+
+    virtual FPrimitiveSceneProxy* CreateSceneProxy() override;
+    virtual FBoxSphereBounds CalcBounds(const FTransform& LocalToWorld) const override;
+    virtual void GetUsedMaterials(TArray<UMaterialInterface*>& OutMaterials, bool bGetDebugMaterials = false) const override;
+
+    //! Depth priority group of drawn points, e.g. SDPG_World or SDPG_Foreground
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    uint8 DepthPriority = 0;
+
+protected:
+    friend class FRRLidarDebugPointsSceneProxy;
+
+    //! Last points given to #SetPoints. Kept so that a recreated scene proxy, e.g. after visibility change, draws them.
+    FRRLidarDebugPointsPtr Points;
+
+    //! Bounds of the last points given to #SetPoints, in world frame
+    FBox PointsBounds = FBox(ForceInit);
+};
@@ -0,0 +1,167 @@
+/**
+ * @file RRLidarStaticGeometryCache.h
+ * @brief CPU ray acceleration structure over static geometry, used by lidars instead of physics scene queries.
+ * @copyright Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+ */
+
+#pragma once
+
+// UE
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "RRLidarStaticGeometryCache.generated.h"
+
+class UPhysicalMaterial;
+class UStaticMeshComponent;
+
+/**
+ * @brief BVH node. Inner node if Count == 0, with children at FirstOrLeft and FirstOrLeft + 1.
+ * Leaf node otherwise, with primitives [FirstOrLeft, FirstOrLeft + Count).
+ */
+struct FRRBVHNode
+{
+    FVector3f Min = FVector3f::ZeroVector;
+    int32 FirstOrLeft = 0;
+    FVector3f Max = FVector3f::ZeroVector;
+    int32 Count = 0;
+};
+
+/**
+ * @brief Bottom level BVH over world space triangles of a static primitive component.
+ */
+struct FRRStaticMeshBVH
+{
+    TWeakObjectPtr<UPrimitiveComponent> Component;
+
+    //! Owner of #Component. Only dereferenced on game thread, while #Component is valid.
+    AActor* Actor = nullptr;
+
+    uint32 ComponentId = 0;
+    uint32 ActorId = 0;
+
+    //! 3 vertices per triangle in world frame, ordered by #Nodes leaves
+    TArray<FVector3f> Vertices;
+
+    //! Face index in the source mesh LOD per triangle
+    TArray<int32> FaceIndices;
+
+    //! Index into #PhysMaterials per triangle
+    TArray<uint16> MaterialIndices;
+
+    TArray<TWeakObjectPtr<UPhysicalMaterial>> PhysMaterials;
+
+    TArray<FRRBVHNode> Nodes;
+
+    FBox3f Bounds = FBox3f(ForceInit);
+
+    int32 GetNumTriangles() const
+    {
+        return FaceIndices.Num();
+    }
+};
+
+/**
+ * @brief Static geometry blocking a collision channel: a bottom level BVH per component and a top level BVH over them.
+ */
+struct FRRLidarStaticScene
+{
+    TArray<FRRStaticMeshBVH> Meshes;
+
+    //! Top level BVH over #Meshes bounds, leaves refer to #MeshOrder
+    TArray<FRRBVHNode> Nodes;
+
+    TArray<int32> MeshOrder;
+
+    //! #Nodes need to be rebuilt since #Meshes has been changed
+    bool bDirty = false;
+
+    //! All static geometry blocking the channel is in #Meshes. Some primitives, e.g. landscapes, can not be cached.
+    bool bComplete = true;
+};
+
+/**
+ * @brief World subsystem holding a CPU ray acceleration structure over static geometry for each lidar trace channel.
+ * Static mesh components with static or stationary mobility which block the channel are gathered once when a channel is
+ * registered, with triangles as complex traces see them: from the LOD used for collision with physical materials per
+ * section, or from simple collision boxes and convexes if the mesh uses simple collision as complex.
+ * The structure is updated incrementally when actors are spawned or destroyed: only their bottom level BVHs are built or
+ * removed, and the top level BVH over components is rebuilt in #UpdateScenes.
+ *
+ * Lidars trace the cache first, then only need to trace dynamic objects in physics scene, up to the static hit.
+ */
+UCLASS()
+class RAPYUTASIMULATIONPLUGINS_API URRLidarStaticGeometryCache : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+    virtual void Deinitialize() override;
+
+    /**
+     * @brief Build scene of given channel from the static geometry of the world, if not built yet.
+     * @param InChannel
+     */
+    void RegisterChannel(const ECollisionChannel InChannel);
+
+    /**
+     * @brief Rebuild top level BVHs changed by spawned or destroyed actors. Should be called on game thread before tracing.
+     */
+    void UpdateScenes();
+
+    /**
+     * @brief Whether all static geometry blocking given channel is cached, thus physics queries can skip static objects.
+     * @param InChannel
+     * @return false if channel is not registered, or some static primitives could not be cached.
+     */
+    bool IsSceneComplete(const ECollisionChannel InChannel) const;
+
+    /**
+     * @brief Trace a ray against the cached static geometry of given channel. Thread-safe while #UpdateScenes is not running.
+     * Ignored actors and components of InParams are respected.
+     *
+     * @param InChannel
+     * @param InStart
+     * @param InEnd
+     * @param InParams
+     * @param OutHit Filled like a blocking hit of LineTraceSingleByChannel, or a miss from InStart to InEnd.
+     * @return true if hit
+     */
+    bool Raycast(const ECollisionChannel InChannel,
+                 const FVector& InStart,
+                 const FVector& InEnd,
+                 const FCollisionQueryParams& InParams,
+                 FHitResult& OutHit) const;
+
+    //! Number of cached triangles over all channels
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    int32 NumTriangles = 0;
+
+protected:
+    /**
+     * @brief Add bottom level BVHs of static components of given actor, which block channel of given scene.
+     * @param InActor
+     * @param InChannel
+     * @param InOutScene
+     */
+    void AddActor(AActor* InActor, const ECollisionChannel InChannel, FRRLidarStaticScene& InOutScene);
+
+    /**
+     * @brief Build bottom level BVH from a static mesh component's collision LOD, or its simple collision if used as
+     * complex, for all of its instances if instanced.
+     * @param InComponent
+     * @param OutMesh
+     * @return false if mesh data is not accessible from CPU, or simple collision has spheres or capsules.
+     */
+    static bool BuildMeshBVH(UStaticMeshComponent* InComponent, FRRStaticMeshBVH& OutMesh);
+
+    void OnActorSpawned(AActor* InActor);
+    void OnActorDestroyed(AActor* InActor);
+
+    TMap<ECollisionChannel, FRRLidarStaticScene> Scenes;
+
+    FDelegateHandle ActorSpawnedHandle;
+    FDelegateHandle ActorDestroyedHandle;
+};
@@ -0,0 +1,110 @@
+/**
+ * @file RRLidarTraceScheduler.h
+ * @brief World subsystem which schedules scans of all lidars in the world and traces them together.
+ * @copyright Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+ */
+
+#pragma once
+
+// UE
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+// RapyutaSimulationPlugins
+#include "Sensors/RRBaseLidarComponent.h"
+
+#include "RRLidarTraceScheduler.generated.h"
+
+/**
+ * @brief Schedule state of a lidar registered to #URRLidarTraceScheduler
+ */
+struct FRRScheduledLidar
+{
+    TWeakObjectPtr<URRBaseLidarComponent> Lidar;
+
+    //! [s] World time of next #URRBaseLidarComponent::SensorUpdate
+    double NextUpdateTime = 0.0;
+};
+
+/**
+ * @brief Scan queued by a lidar during #URRLidarTraceScheduler::Tick, traced together with the other queued ones.
+ */
+struct FRRQueuedLidarScan
+{
+    URRBaseLidarComponent* Lidar = nullptr;
+    FCollisionQueryParams TraceParams;
+};
+
+/**
+ * @brief Shared trace scheduler for all lidars in a world.
+ * Instead of running their own timers, registered lidars are updated from a single tick at their PublicationFrequencyHz,
+ * and their traces are issued together once per frame:
+ * async: all rays are queued into the same async trace batch of the frame.
+ * sync: all rays are traced by a single ParallelFor.
+ * Lidars are phase shifted from each other within their scan period so that scans of lidars with the same frequency are
+ * spread across frames instead of bursting in the same frame. Scan period, thus publication rate, is unchanged.
+ */
+UCLASS()
+class RAPYUTASIMULATIONPLUGINS_API URRLidarTraceScheduler : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    /**
+     * @brief Start scheduling given lidar's #URRBaseLidarComponent::SensorUpdate, replacing its timer.
+     * @param InLidar
+     */
+    void RegisterLidar(URRBaseLidarComponent* InLidar);
+
+    /**
+     * @brief Stop scheduling given lidar. Its queued scan, if any, is cancelled.
+     * @param InLidar
+     */
+    void UnregisterLidar(URRBaseLidarComponent* InLidar);
+
+    /**
+     * @brief Queue #URRBaseLidarComponent::TracingScan of given lidar, to be traced by #FlushQueuedScans.
+     * Called by lidar after #URRBaseLidarComponent::BeginScan succeeded.
+     * @param InLidar
+     * @param InTraceParams
+     */
+    void QueueScan(URRBaseLidarComponent* InLidar, const FCollisionQueryParams& InTraceParams);
+
+    /**
+     * @brief Update due lidars, then trace all queued scans.
+     * @param DeltaTime
+     */
+    virtual void Tick(float DeltaTime) override;
+
+    virtual TStatId GetStatId() const override;
+
+    //! Rays traced per second by all lidars in the world, averaged over #RAYS_PER_SECOND_WINDOW
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    float RaysPerSecond = 0.f;
+
+    //! Number of lidars currently registered
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    int32 NumRegisteredLidars = 0;
+
+protected:
+    /**
+     * @brief Trace all #QueuedScans together and hand their results to lidars.
+     */
+    void FlushQueuedScans();
+
+    TArray<FRRScheduledLidar> ScheduledLidars;
+
+    TArray<FRRQueuedLidarScan> QueuedScans;
+
+    //! Number of registrations so far, used to compute phase of next registered lidar
+    uint32 NumRegistrations = 0;
+
+    //! Rays traced since #RaysPerSecondWindowStart
+    int64 NumWindowRays = 0;
+
+    //! [s] Platform time when #RaysPerSecond window started
+    double RaysPerSecondWindowStart = 0.0;
+
+    //! [s]
+    static constexpr double RAYS_PER_SECOND_WINDOW = 1.0;
+};
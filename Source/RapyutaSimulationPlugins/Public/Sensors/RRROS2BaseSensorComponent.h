@@ -6,6 +6,9 @@
 
 #pragma once
 
+// std
+#include <atomic>
+
 // UE
 #include "CoreMinimal.h"
 #include "GenericPlatform/GenericPlatformMath.h"
@@ -22,6 +25,27 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogROS2Sensor, Log, All);
 
+/**
+ * @brief Stream of gaussian noise split from #URRGaussianNoise. Owned by a single worker, thus not shared between threads.
+ * Samples are fully determined by the parent noise seed, stream id and the number of samples drawn so far.
+ */
+struct RAPYUTASIMULATIONPLUGINS_API FRRGaussianNoiseStream
+{
+    uint64 Key = 0;
+    uint64 Counter = 0;
+    float Mean = 0.f;
+    float StdDev = 0.f;
+
+    float Get();
+};
+
+/**
+ * @brief Gaussian noise with counter-based generator.
+ * Each sample is computed from (key, counter) only, so that samples can be drawn from multiple threads, split into
+ * per-worker streams with #MakeStream or filled in a batch with #Fill.
+ * Uniform numbers are generated with SplitMix64 and converted to normal distribution with Box-Muller transform.
+ * @sa https://prng.di.unimi.it/splitmix64.c
+ */
 UCLASS(ClassGroup = (Custom), Blueprintable, meta = (BlueprintSpawnableComponent))
 class RAPYUTASIMULATIONPLUGINS_API URRGaussianNoise : public UObject
 {
@@ -38,11 +62,11 @@ public:
         Init(InMean, InCov);
     }
 
+    /**
+     * @brief Reset generator with #Mean, #Cov and #Seed.
+     */
     UFUNCTION(BlueprintCallable)
-    virtual void Init()
-    {
-        GaussianRNG = std::normal_distribution<>(Mean, std::sqrt(Cov));
-    }
+    virtual void Init();
 
     virtual void Init(const float InMean, const float InCov)
     {
@@ -51,24 +75,68 @@ public:
         Init();
     }
 
+    /**
+     * @brief Get single sample. Thread-safe.
+     * @return float
+     */
     UFUNCTION(BlueprintCallable)
     virtual float Get()
     {
-        return GaussianRNG(Gen);
+        return GetAt(Counter.fetch_add(1, std::memory_order_relaxed));
     }
 
+    /**
+     * @brief Fill OutSamples with InNum samples, generated in parallel batches. Thread-safe.
+     * Result only depends on #Seed and the number of samples drawn before, not on the number of workers.
+     * @param OutSamples
+     * @param InNum
+     */
+    void Fill(TArray<float>& OutSamples, const int32 InNum);
+
+    /**
+     * @brief Split an independent stream, which can be used by a single worker without synchronization.
+     * @param InStreamId
+     * @return FRRGaussianNoiseStream
+     */
+    FRRGaussianNoiseStream MakeStream(const uint64 InStreamId) const;
+
+    /**
+     * @brief Get sample at given counter without changing generator state.
+     * @param InCounter
+     * @return float
+     */
+    float GetAt(const uint64 InCounter) const
+    {
+        return Mean + StdDev * GetStandardNormal(Key, InCounter);
+    }
+
+    /**
+     * @brief Get sample of standard normal distribution for given key and counter.
+     * @param InKey
+     * @param InCounter
+     * @return float
+     */
+    static float GetStandardNormal(const uint64 InKey, const uint64 InCounter);
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise")
     float Mean = 0.f;
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise")
     float Cov = 0.01f;
 
+    //! Seed for reproducible noise. Negative value uses random seed.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Noise")
+    int32 Seed = -1;
+
 protected:
-    std::random_device Rng;
+    float StdDev = 0.f;
+
+    uint64 Key = 0;
 
-    std::mt19937 Gen = std::mt19937(Rng());
+    std::atomic<uint64> Counter{0};
 
-    std::normal_distribution<> GaussianRNG;
+    //! Number of samples generated per ParallelFor task in #Fill
+    static constexpr int32 FILL_BATCH_SIZE = 4096;
 };
 
 /**
@@ -7,32 +7,66 @@
 
 #pragma once
 
+#include "Async/Future.h"
 #include "Camera/CameraComponent.h"
 #include "Components/SceneCaptureComponent2D.h"
 #include "CoreMinimal.h"
 #include "Engine/TextureRenderTarget2D.h"
 
 // rclUE
+#include <Msgs/ROS2CompressedImage.h>
 #include <Msgs/ROS2Img.h>
 
 // RapyutaSimulationPlugins
 #include "Core/RRConversionUtils.h"
+#include "Core/RRImageUtils.h"
 #include "RRROS2BaseSensorComponent.h"
+#include "Sensors/RRRenderRequestRing.h"
 
 #include "RRROS2CameraComponent.generated.h"
 
 /**
  * @brief
  * used in　#CaptureNonBlocking of #URRROS2CameraComponent
+ * Reused across captures by #URRROS2CameraComponent::RenderRequests, thus #Image is allocated once.
  */
 USTRUCT()
 struct FRenderRequest
 {
     GENERATED_BODY()
     TArray<FColor> Image;
+
+    //! Scene depth [cm] in R channel, read back instead of #Image with depth encodings
+    TArray<FLinearColor> DepthImage;
+
     FRenderCommandFence RenderFence;
 };
 
+/**
+ * @brief Compression of a completed render request on a worker thread, used by #URRROS2CameraComponent.
+ * Reused across images by #URRROS2CameraComponent::CompressionTasks, thus its buffers are allocated once.
+ * Each running task takes its own image wrapper from #URRCoreUtils pool.
+ */
+struct FRRImageCompressionTask
+{
+    //! Pixels being compressed, swapped with a completed request's image
+    TArray<FColor> Input;
+
+    //! Mono pixels being compressed if encoding is mono8
+    TArray<uint8> MonoPixels;
+
+    TArray64<uint8> Output;
+
+    TFuture<void> Future;
+
+    //! Stamp of the image being compressed
+    FROSTime Stamp;
+
+    //! [s] Platform time when compression was started and finished
+    double StartTime = 0.0;
+    double EndTime = 0.0;
+};
+
 UENUM(BlueprintType)
 enum class EROS2CameraType : uint8
 {
@@ -40,6 +74,13 @@ enum class EROS2CameraType : uint8
     DEPTH UMETA(DisplayName = "Depth")
 };
 
+UENUM(BlueprintType)
+enum class ERRCompressedImageFormat : uint8
+{
+    JPEG UMETA(DisplayName = "jpeg"),
+    PNG UMETA(DisplayName = "png")
+};
+
 /**
  * @brief ROS 2 Camera component. Uses USceneCaptureComponent2D.
  *
@@ -77,19 +118,50 @@ public:
 
 protected:
     /**
-     * @brief Capture data by notifing task in #RenderRequestQueue
+     * @brief Wait for readbacks in flight, since they write into #RenderRequests.
+     * @param EndPlayReason
+     */
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+    /**
+     * @brief Capture data by pushing a readback request to #RenderRequests
      * @sa reference https://github.com/TimmHess/UnrealImageCapture
      */
     UFUNCTION()
     void CaptureNonBlocking();
 
-    //!
-    TQueue<FRenderRequest*> RenderRequestQueue;
+    /**
+     * @brief Convert the oldest completed request of #RenderRequests into #Data and release it.
+     */
+    void UpdateImageData();
+
+    //! Readback requests in flight, with #QueueSize depth
+    TRRRenderRequestRing<FRenderRequest> RenderRequests;
 
     //!
     FROSImg Data;
 
-    int32 QueueCount = 0;
+    //! Parsed from #Encoding in #PreInitializePublisher
+    ERRImageEncoding ImageEncoding = ERRImageEncoding::RGB8;
+
+    /**
+     * @brief Update #CompressedData from finished compressions in capture order, then start compressing completed requests
+     * of #RenderRequests while #CompressionTasks has free tasks.
+     */
+    void UpdateCompressedImageData();
+
+    /**
+     * @brief Compress Input of given task into its Output. Runs on a worker thread.
+     * @param InOutTask
+     */
+    void CompressImage(FRRImageCompressionTask& InOutTask);
+
+    //! Msg published if #bPublishCompressed
+    FROSCompressedImage CompressedData;
+
+    //! Compressions running or finished but not taken into #CompressedData yet, with #NumCompressionTasks depth.
+    //! Never full when pushed to, thus no task is dropped.
+    TRRRenderRequestRing<FRRImageCompressionTask> CompressionTasks;
 
 public:
     //! Camera. Not necessary to capture but useful to see image in UE4 windows.
@@ -108,18 +180,62 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     int32 Height = 480;
 
+    //! Depth of #RenderRequests. When it is full, the oldest request is dropped.
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     int32 QueueSize = 2;
 
+    //! Number of readback requests which are not published yet
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Stats")
+    int32 NumRequestsInFlight = 0;
+
+    //! Number of readback requests dropped because #RenderRequests was full
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Stats")
+    int32 NumDroppedRequests = 0;
+
+    //! With 8 bit encodings, depth is rendered by SceneDepth post process. With 32FC1 and 16UC1 #Encoding, depth is read
+    //! back from a float render target.
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     EROS2CameraType CameraType = EROS2CameraType::RGB;
 
+    //! [m] Depth below it is invalid, i.e. NaN in 32FC1 and 0 in 16UC1
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Depth", meta = (ClampMin = "0"))
+    float MinDepth = 0.f;
+
+    //! [m] Depth above it is invalid, i.e. NaN in 32FC1 and 0 in 16UC1. 16UC1 can not encode depth above 65.535 m anyway.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Depth", meta = (ClampMin = "0"))
+    float MaxDepth = 100.f;
+
+    //! Publish sensor_msgs/CompressedImage to #TopicName/compressed instead of raw image. Applied in #PreInitializePublisher.
+    //! Images are compressed on worker threads, up to #NumCompressionTasks at a time. Completed readbacks wait in
+    //! #RenderRequests meanwhile.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Compression")
+    bool bPublishCompressed = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Compression")
+    ERRCompressedImageFormat CompressedFormat = ERRCompressedImageFormat::JPEG;
+
+    //! Max number of images compressed concurrently. Applied in #PreInitializePublisher.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Compression", meta = (ClampMin = "1"))
+    int32 NumCompressionTasks = 2;
+
+    //! JPEG quality in [1, 100]. PNG is lossless.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Compression", meta = (ClampMin = "1", ClampMax = "100"))
+    int32 CompressionQuality = 90;
+
+    //! [ms] Time from starting compression of an image to its compressed data being available
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Stats")
+    float CompressionLatency = 0.f;
+
+    //! Raw image size over compressed image size, of the last compressed image
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Stats")
+    float CompressionRatio = 0.f;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     bool Render = true;
    
     // ROS
     /**
-     * @brief Update ROS 2 Msg structure from #RenderRequestQueue
+     * @brief Update ROS 2 Msg structure from #RenderRequests
      *
      * @return FROSImg
      */
@@ -127,12 +243,13 @@ public:
     virtual FROSImg GetROS2Data();
 
     /**
-     * @brief Set result of #GetROS2Data to InMessage.
+     * @brief Set result of #GetROS2Data to InMessage, or #CompressedData if #bPublishCompressed.
      *
      * @param InMessage
      */
     virtual void SetROS2Msg(UROS2GenericMsg* InMessage) override;
 
+    //! ROS 2 image encoding: rgb8, bgr8, bgra8 or mono8, or 32FC1 [m] or 16UC1 [mm] if #CameraType is depth
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     FString Encoding = TEXT("rgb8");
 };
@@ -0,0 +1,107 @@
+/**
+ * @file RRRenderRequestRing.h
+ * @brief Fixed size ring of reusable render requests.
+ * @copyright Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+ */
+
+#pragma once
+
+// UE
+#include "CoreMinimal.h"
+
+/**
+ * @brief Fixed size FIFO ring of reusable requests, e.g. GPU readbacks of a camera.
+ * Requests are allocated once in #Init and recycled afterwards. When the ring is full, #Push drops the oldest request and
+ * reuses it for the new one.
+ * The ring only orders requests and does not know about their completion, thus it can be used with any request type, e.g.
+ * fake readback data.
+ *
+ * @tparam TRequest Default constructible request type
+ */
+template<typename TRequest>
+class TRRRenderRequestRing
+{
+public:
+    /**
+     * @brief Allocate InDepth requests, then call InInitRequest on each of them, e.g. to preallocate their storage.
+     * Requests in flight and counters are reset.
+     * @param InDepth Number of requests, at least 1
+     * @param InInitRequest
+     */
+    void Init(const int32 InDepth, TFunctionRef<void(TRequest&)> InInitRequest)
+    {
+        Requests.Reset();
+        Requests.SetNum(FMath::Max(InDepth, 1));
+        for (TRequest& request : Requests)
+        {
+            InInitRequest(request);
+        }
+        Head = 0;
+        NumInFlight = 0;
+        NumDropped = 0;
+    }
+
+    /**
+     * @brief Get a request to be filled as the newest one. If ring is full, the oldest request is dropped and returned.
+     * Dropped request may still be filled by a previously issued command, thus the new command must be ordered after it.
+     * @return TRequest&
+     */
+    TRequest& Push()
+    {
+        check(Requests.Num() > 0);
+        if (NumInFlight == Requests.Num())
+        {
+            Head = (Head + 1) % Requests.Num();
+            --NumInFlight;
+            ++NumDropped;
+        }
+        TRequest& request = Requests[(Head + NumInFlight) % Requests.Num()];
+        ++NumInFlight;
+        return request;
+    }
+
+    /**
+     * @brief Get the oldest request in flight.
+     * @return TRequest* nullptr if there is no request in flight.
+     */
+    TRequest* PeekOldest()
+    {
+        return (NumInFlight > 0) ? &Requests[Head] : nullptr;
+    }
+
+    /**
+     * @brief Release the oldest request in flight, which has been consumed.
+     */
+    void PopOldest()
+    {
+        check(NumInFlight > 0);
+        Head = (Head + 1) % Requests.Num();
+        --NumInFlight;
+    }
+
+    int32 GetDepth() const
+    {
+        return Requests.Num();
+    }
+
+    int32 GetNumInFlight() const
+    {
+        return NumInFlight;
+    }
+
+    //! Number of requests dropped by #Push since #Init
+    int32 GetNumDropped() const
+    {
+        return NumDropped;
+    }
+
+private:
+    TArray<TRequest> Requests;
+
+    //! Index of the oldest request in flight
+    int32 Head = 0;
+
+    int32 NumInFlight = 0;
+
+    int32 NumDropped = 0;
+};
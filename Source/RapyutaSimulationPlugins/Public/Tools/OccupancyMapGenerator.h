@@ -6,16 +6,31 @@
 
 #pragma once
 
+#include <atomic>
+
+#include "Async/Future.h"
 #include "CoreMinimal.h"
 #include "Engine/StaticMeshActor.h"
 #include "GameFramework/Actor.h"
 
 #include "OccupancyMapGenerator.generated.h"
 
+/**
+ * @brief Image file format of occupancy maps
+ */
+UENUM(BlueprintType)
+enum class ERROccupancyMapFormat : uint8
+{
+    PGM UMETA(DisplayName = "PGM"),
+    PNG UMETA(DisplayName = "PNG, lossless compressed"),
+};
+
 /**
  * @brief Actor to Generate 2D occupancy map for navigation/localization with LineTraceSingleByChannel.
  * Generate 2D occupancy map with given parameter and save to file with beginplay.
  * How to use: Place this actor to the level, set parameters(select #Map and max vertical height), and play simulation, then map file will be saved.
+ * The grid is divided into tiles of #TileSize cells, which are traced in parallel into their final place in the grid, thus
+ * the result is identical to a serial trace of all cells.
  * @sa [LineTraceSingleByChannel](https://docs.unrealengine.com/5.1/en-US/API/Runtime/Engine/Engine/UWorld/LineTraceSingleByChannel/)
  */
 UCLASS()
@@ -37,6 +52,18 @@ protected:
 	 */
     virtual void BeginPlay() override;
 
+    /**
+     * @brief Cancel generation in progress and wait for it.
+     * @param EndPlayReason
+     */
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+    /**
+     * @brief Save files once asynchronous generation is done.
+     * @param DeltaSeconds
+     */
+    virtual void Tick(float DeltaSeconds) override;
+
 public:
     //! Generate map to cover bounding box of this actor. Please select actor such as ground plane.
     UPROPERTY(EditAnywhere)
@@ -53,12 +80,71 @@ public:
     UPROPERTY(EditAnywhere)
     FString Filename = "ue4_map";
 
+    //! Image format of the map. PNG is much smaller for large maps, and supported by nav2 map_server as well.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    ERROccupancyMapFormat MapFormat = ERROccupancyMapFormat::PGM;
+
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
     TArray<uint8> OccupancyGrid;
 
+    //! Number of cells per side of tiles traced in parallel
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    int32 TileSize = 64;
+
+    //! Trace tiles in parallel, otherwise one after another in the calling thread
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool bParallelTrace = true;
+
+    //! Generate in a background task from BeginPlay, without blocking the game thread, then save files.
+    //! Actors moving meanwhile, e.g. spawned robots, may be in the map.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool bGenerateAsync = false;
+
+    /**
+     * @brief Fill #OccupancyGrid by tracing all cells of #Map's bounding box, blocking until done.
+     * @return false if #Map is null, generation is already in progress or it has been cancelled.
+     */
+    UFUNCTION(BlueprintCallable)
+    bool GenerateOccupancyGrid();
+
+    /**
+     * @brief Trace the grid in a background task, then set #OccupancyGrid and save files on game thread.
+     * #OccupancyGrid is kept as is until then, and if generation is cancelled. @sa #bGenerateAsync
+     * @return false if #Map is null or generation is already in progress.
+     */
+    UFUNCTION(BlueprintCallable)
+    bool GenerateOccupancyGridAsync();
+
+    /**
+     * @brief Request generation in progress to stop, after tiles being traced.
+     */
+    UFUNCTION(BlueprintCallable)
+    void CancelGeneration();
+
+    /**
+     * @brief Block until asynchronous generation is done, then set #OccupancyGrid unless it has been cancelled.
+     * Unlike generation finished on Tick, files are not saved.
+     * @return false if no asynchronous generation was in progress or it has been cancelled.
+     */
+    UFUNCTION(BlueprintCallable)
+    bool WaitForGeneration();
+
+    UFUNCTION(BlueprintCallable)
+    bool IsGenerating() const
+    {
+        return bGenerating;
+    }
+
+    /**
+     * @brief Get ratio of traced cells of generation in progress or last one.
+     * @return float [0,1]
+     */
+    UFUNCTION(BlueprintCallable)
+    float GetGenerationProgress() const;
+
     UFUNCTION()
     /**
-	 * @brief Save .pgm and .yaml files.
+	 * @brief Save .pgm or .png and .yaml files of #OccupancyGrid to content directory.
 	 *
 	 * @param width
 	 * @param height
@@ -68,4 +154,71 @@ public:
 	 * @return false
 	 */
     bool WriteToFile(int width, int height, float originx, float originy);
+
+    /**
+     * @brief Write image file and .yaml file of a map next to each other.
+     * The image is written in one go: PGM header and cells through a single file writer, or PNG as one compressed buffer.
+     * @param InGrid Row-major cells
+     * @param InWidth
+     * @param InHeight
+     * @param InOriginX [m]
+     * @param InOriginY [m]
+     * @param InDirectory
+     * @param InFilename Without extension
+     * @param InFormat
+     * @return true if both files have been written. The .yaml file is written only once the image has been.
+     */
+    bool WriteMapFiles(const TArray<uint8>& InGrid,
+                       const int32 InWidth,
+                       const int32 InHeight,
+                       const float InOriginX,
+                       const float InOriginY,
+                       const FString& InDirectory,
+                       const FString& InFilename,
+                       const ERROccupancyMapFormat InFormat) const;
+
+protected:
+    /**
+     * @brief Compute grid geometry from #Map's bounding box.
+     * @return false if #Map is null.
+     */
+    bool InitGrid();
+
+    /**
+     * @brief Trace all cells of the grid into OutGrid, which is resized beforehand.
+     * @param bInParallel Trace tiles in parallel
+     * @param OutGrid Row-major cells, 0 if occupied, 255 if free
+     * @return false if cancelled
+     */
+    bool TraceGrid(const bool bInParallel, TArray<uint8>& OutGrid);
+
+    //! Write files of #OccupancyGrid
+    void SaveOccupancyGrid();
+
+    /**
+     * @brief Get result of the background task, waiting for it, and swap #AsyncGrid into #OccupancyGrid if it has succeeded.
+     * @return false if cancelled.
+     */
+    bool FinishGeneration();
+
+    FVector GridCenter = FVector::ZeroVector;
+
+    FVector GridExtent = FVector::ZeroVector;
+
+    FVector GridOrigin = FVector::ZeroVector;
+
+    int32 NCellsX = 0;
+
+    int32 NCellsY = 0;
+
+    bool bGenerating = false;
+
+    TFuture<bool> GenerationFuture;
+
+    //! Grid traced by the background task, which is not accessed by game thread until the task is done
+    TArray<uint8> AsyncGrid;
+
+    std::atomic<int64> NumTracedCells{0};
+
+    std::atomic<bool> bCancelRequested{false};
 };
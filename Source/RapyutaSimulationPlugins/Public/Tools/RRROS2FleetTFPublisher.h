@@ -0,0 +1,145 @@
+/**
+ * @file RRROS2FleetTFPublisher.h
+ * @brief World-wide /tf publisher aggregating odom tfs of all robots into one message.
+ * @copyright Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+ */
+
+#pragma once
+
+// UE
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+// RapyutaSimulationPlugins
+#include "Tools/RRROS2TFPublisher.h"
+
+#include "RRROS2FleetTFPublisher.generated.h"
+
+class UROS2NodeComponent;
+class URRROS2OdomPublisher;
+
+/**
+ * @brief Schedule state of an odom publisher registered to #URRROS2FleetTFPublisher
+ */
+struct FRRFleetOdomTF
+{
+    TWeakObjectPtr<URRROS2OdomPublisher> OdomPublisher;
+
+    //! [s] World time when odom tf is due next
+    double NextTime = 0.0;
+};
+
+/**
+ * @brief /tf publisher of odom tfs of all registered odom publishers.
+ * Each message holds the odom tfs which are due at their odom publisher's PublicationFrequencyHz, thus the rate of each
+ * robot's odom tf and its frame ids are the same as with its own #URRROS2TFPublisher.
+ * Updated and published by #URRROS2FleetTFSubsystem, not by a timer.
+ */
+UCLASS(ClassGroup = (Custom), Blueprintable, meta = (BlueprintSpawnableComponent))
+class RAPYUTASIMULATIONPLUGINS_API URRROS2FleetTFPublisher : public URRROS2TFPublisherBase
+{
+    GENERATED_BODY()
+
+public:
+    /**
+     * @brief Construct a new URRROS2FleetTFPublisher object, without publish timer.
+     *
+     */
+    URRROS2FleetTFPublisher();
+
+    /**
+     * @brief Start aggregating odom tf of given odom publisher.
+     * Its due times are aligned on its period grid from world time 0, so that odom tfs with the same frequency go into the
+     * same message.
+     * @param InOdomPublisher
+     */
+    void RegisterOdomPublisher(URRROS2OdomPublisher* InOdomPublisher);
+
+    /**
+     * @brief Stop aggregating odom tf of given odom publisher. Destroyed odom publishers are removed as well.
+     * @param InOdomPublisher
+     */
+    void UnregisterOdomPublisher(URRROS2OdomPublisher* InOdomPublisher);
+
+    //! Number of transforms of last #UpdateMessage, 0 if no odom tf was due.
+    int32 GetNumTransforms() const
+    {
+        return NumTransforms;
+    }
+
+    int32 GetNumOdomTFs() const
+    {
+        return OdomTFs.Num();
+    }
+
+protected:
+    /**
+     * @brief Add odom tfs which are due to OutROSTf, and schedule their next time.
+     * @param OutROSTf
+     */
+    virtual void GetROS2Msg(FROSTFMsg& OutROSTf) override;
+
+    TArray<FRRFleetOdomTF> OdomTFs;
+};
+
+/**
+ * @brief Shared /tf publisher for odom tfs of all robots in a world.
+ * Odom publishers with #URRROS2OdomPublisher::bAggregateOdomTf register to it instead of creating their own
+ * #URRROS2TFPublisher, thus the world has one /tf publisher and one /tf message per frame for odom tfs, instead of one of
+ * each per robot. The publisher is created lazily with its own node on first registration.
+ */
+UCLASS()
+class RAPYUTASIMULATIONPLUGINS_API URRROS2FleetTFSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    /**
+     * @brief Publish odom tf of given odom publisher through #FleetTFPublisher.
+     * @param InOdomPublisher
+     */
+    void RegisterOdomPublisher(URRROS2OdomPublisher* InOdomPublisher);
+
+    /**
+     * @brief Stop publishing odom tf of given odom publisher.
+     * @param InOdomPublisher
+     */
+    void UnregisterOdomPublisher(URRROS2OdomPublisher* InOdomPublisher);
+
+    /**
+     * @brief Publish a /tf message with the odom tfs which are due, if any.
+     * @param DeltaTime
+     */
+    virtual void Tick(float DeltaTime) override;
+
+    virtual TStatId GetStatId() const override;
+
+    //! Name of the node owning #FleetTFPublisher
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    FString FleetTFNodeName = TEXT("UEFleetTFNode");
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    TObjectPtr<UROS2NodeComponent> FleetTFNode = nullptr;
+
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    TObjectPtr<URRROS2FleetTFPublisher> FleetTFPublisher = nullptr;
+
+    //! Number of odom publishers currently registered
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    int32 NumRegisteredOdomPublishers = 0;
+
+    //! Number of /tf messages published so far
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    int32 NumPublishedMsgs = 0;
+
+    //! Number of transforms published so far, in all messages
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    int32 NumPublishedTFs = 0;
+
+protected:
+    /**
+     * @brief Create #FleetTFNode and #FleetTFPublisher if not yet.
+     * @return true if #FleetTFPublisher is ready.
+     */
+    bool InitFleetTFPublisher();
+};
@@ -21,6 +21,7 @@
 
 class UROS2GenericMsg;
 class ARRBaseRobot;
+class URRROS2FleetTFSubsystem;
 
 /**
  * @brief Odometry Topic and TF publisher of #ARRBaseRobot
@@ -43,8 +44,21 @@ public:
     UPROPERTY(BlueprintReadWrite)
     URRROS2TFPublisher* TFPublisher = nullptr;
 
+    /**
+     * @brief Create #TFPublisher, or register to #URRROS2FleetTFSubsystem if #bAggregateOdomTf.
+     *
+     * @param InROS2Node
+     */
     void InitializeTFWithROS2(UROS2NodeComponent* InROS2Node);
 
+    /**
+     * @brief Unregister from #URRROS2FleetTFSubsystem if #InitializeTFWithROS2 registered to it, so that odom tf of a torn
+     * down robot is no longer aggregated. Called by URRBaseOdomComponent::EndPlay and #BeginDestroy.
+     */
+    void DeInitializeTF();
+
+    virtual void BeginDestroy() override;
+
     void UpdateMessage(UROS2GenericMsg* InMessage) override;
 
     /**
@@ -56,11 +70,32 @@ public:
      */
     bool GetOdomData(FROSOdom& OutOdomData) const;
 
+    /**
+     * @brief Get odom tf and its frame ids, with ChildFrameId prefixed as in #GetOdomData.
+     * Used by #URRROS2FleetTFPublisher when #bAggregateOdomTf.
+     *
+     * @param OutTF
+     * @return const FRRROS2TFFrameIds* nullptr if there is no odom source.
+     */
+    const FRRROS2TFFrameIds* GetOdomTF(FTransform& OutTF);
+
     //! Publish tf or not
     UPROPERTY(BlueprintReadWrite)
     bool bPublishOdomTf = false;
 
+    //! Publish tf through the world's shared /tf publisher of #URRROS2FleetTFSubsystem instead of #TFPublisher.
+    //! Rate and frame ids of the tf are unchanged, but it is sent in one message with odom tfs of other robots.
+    UPROPERTY(BlueprintReadWrite)
+    bool bAggregateOdomTf = false;
+
     //! add robot name to the frame_id and ChildFrameId or not.
     UPROPERTY(BlueprintReadWrite)
     bool bAppendNodeNamespace = true;
+
+protected:
+    //! Frame ids of odom tf published by #URRROS2FleetTFPublisher
+    FRRROS2TFFrameIds OdomTFFrameIds;
+
+    //! Subsystem which this is registered to by #InitializeTFWithROS2
+    TWeakObjectPtr<URRROS2FleetTFSubsystem> FleetTFSubsystem;
 };
@@ -122,12 +122,29 @@ public:
 
     /**
      * @brief Callback function of SpawnEntities ROS 2 service.
+     * Entities are checked on client, then all valid ones are spawned by #ServerSpawnEntities RPCs of
+     * #SpawnEntitiesRPCBatchSize entities. An entity can refer to an entity prior to it in the same request.
+     * On server, the response has the spawn result of each entity, otherwise the check result of each entity.
+     * With a spawn budget of #ASimulationState, entities may be spawned over next frames after the response, since a
+     * service response can not be deferred.
      * @param Service
      * @sa [ue_mgs/SpawnEntities.srv](https://github.com/rapyuta-robotics/UE_msgs/blob/devel/srv/SpawnEntities.srv)
      */
     UFUNCTION(BlueprintCallable)
     virtual void SpawnEntitiesSrv(UROS2GenericSrv* InService);
 
+    /**
+     * @brief RPC call to Server's SpawnEntities
+     * @param InRequest
+     */
+    UFUNCTION(BlueprintCallable, Server, Reliable)
+    void ServerSpawnEntities(const FROSSpawnEntitiesReq& InRequest);
+
+    //! Max number of entities per #ServerSpawnEntities RPC, since a reliable RPC larger than max partial bunch (64KB)
+    //! closes the connection.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    int32 SpawnEntitiesRPCBatchSize = 200;
+
     /**
      * @brief RPC call to Server's SpawnEntity
      * @param InRequest
@@ -191,5 +208,13 @@ protected:
     bool CheckEntityWithDisplayName(const FString& InEntityName, const bool bAllowEmpty = false);
 #endif
     bool CheckSpawnableEntity(const FString& InEntityName, const bool bAllowEmpty = false);
+
+    /**
+     * @brief Check that entity of spawn request can be spawned, i.e. its model is spawnable, its reference frame is an
+     * entity and its name is neither empty nor used by an actor.
+     * @param InRequest
+     * @return FROSSpawnEntityRes bSuccess true if entity can be spawned
+     */
+    FROSSpawnEntityRes CheckSpawnEntity(const FROSSpawnEntityReq& InRequest);
     virtual FROSSpawnEntityRes SpawnEntityImpl(FROSSpawnEntityReq& InRequest);
 };
@@ -21,6 +21,40 @@
 
 #include "RRROS2TFPublisher.generated.h"
 
+/**
+ * @brief Frame ids of a tf with a prefix, e.g. node namespace.
+ * Full frame ids are composed only when the prefix or a frame id changes, thus steady state publishing does not allocate.
+ */
+struct RAPYUTASIMULATIONPLUGINS_API FRRROS2TFFrameIds
+{
+    /**
+     * @brief Compose #FullFrameId and #FullChildFrameId if any input differs from the previous call.
+     *
+     * @param InPrefix Empty for no prefix
+     * @param InFrameId
+     * @param InChildFrameId
+     * @param bInPrefixFrameId Prefix InFrameId as well as InChildFrameId, e.g. false for odom tf in a shared odom frame
+     * @return true if full frame ids have been composed.
+     */
+    bool Update(const FString& InPrefix,
+                const FString& InFrameId,
+                const FString& InChildFrameId,
+                const bool bInPrefixFrameId = true);
+
+    FString FullFrameId;
+
+    FString FullChildFrameId;
+
+private:
+    //! Inputs of the last #Update
+    FString Prefix;
+    FString FrameId;
+    FString ChildFrameId;
+    bool bPrefixFrameId = true;
+
+    bool bComposed = false;
+};
+
 /**
  * @brief TF Publisher base class.
  * @sa [UROS2Publisher](https://rclue.readthedocs.io/en/devel/doxygen_generated/html/d6/dd4/class_u_r_o_s2_publisher.html)
@@ -42,6 +76,10 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     bool IsStatic = false;
 
+    //! Prefix frame ids with owner node namespace, e.g. robot1/base_link
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool bAppendNodeNamespace = false;
+
     /**
      * @brief Initialize publisher with QoS
      *
@@ -50,15 +88,34 @@ public:
     bool InitializeWithROS2(UROS2NodeComponent* InROS2Node) override;
 
     /**
-     * @brief Update message frorm #TF.
+     * @brief Update message from tfs added by #GetROS2Msg.
+     * Time is taken once per message, and #TFMsg is reused across messages.
      *
      * @param InMessage
      */
     virtual void UpdateMessage(UROS2GenericMsg* InMessage) override;
 
+    /**
+     * @brief Get prefix of frame ids, i.e. owner node namespace if #bAppendNodeNamespace.
+     *
+     * @return const FString&
+     */
+    const FString& GetFramePrefix() const;
+
 protected:
+    //! Message reused by #UpdateMessage, so that its transforms and their frame ids keep their allocation.
+    FROSTFMsg TFMsg;
+
+    //! Number of transforms added to #TFMsg in current #UpdateMessage
+    int32 NumTransforms = 0;
+
+    //! Stamp of all transforms of current #UpdateMessage
+    FROSTime Stamp;
+
     /**
-     * @brief Add tf data to OutROSTf from InFrameId, InChildFrameId, and InTf
+     * @brief Add tf data to OutROSTf from InFrameId, InChildFrameId, and InTf.
+     * Transforms of OutROSTf are overwritten in order, thus OutROSTf should be the message given to #GetROS2Msg.
+     * Frame ids are assigned only if they differ from overwritten ones.
      *
      * @param OutROSTf
      * @param InFrameId
@@ -68,7 +125,7 @@ protected:
     virtual void AddTFtoMsg(FROSTFMsg& OutROSTf, const FString& InFrameId, const FString& InChildFrameId, const FTransform& InTf);
 
     /**
-     * @brief Add tf data to OutROSTf from URRROS2TFComponent
+     * @brief Add tf data to OutROSTf from URRROS2TFComponent, with its cached full frame ids.
      *
      * @param OutROSTf
      * @param InTfc
@@ -103,6 +160,9 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     FTransform TF = FTransform::Identity;
 
+    //! #FrameId and #ChildFrameId with prefix
+    FRRROS2TFFrameIds FullFrameIds;
+
     /**
      * @brief Set value to #TF.
      *
@@ -152,6 +212,17 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     FString ChildFrameId;
 
+    //! #FrameId and #ChildFrameId with prefix of the publisher, updated on registration and when they change
+    FRRROS2TFFrameIds FullFrameIds;
+
+    //! TF never changes. Used by #IsStaticTF.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool bStatic = false;
+
+    //! Last transform published on /tf and its world time [s], used by #URRROS2TFsPublisher::bSplitStaticTFs
+    FTransform LastPublishedTF = FTransform::Identity;
+    double LastPublishedTime = -1.0;
+
     /**
      * @brief return target FTransform.
      * This should be overrided in child class. Example is #URRROS2JointTFComponent
@@ -163,6 +234,18 @@ public:
     {
         return TF;
     };
+
+    /**
+     * @brief Whether TF never changes, thus is published once on /tf_static with #URRROS2TFsPublisher::bSplitStaticTFs.
+     * Child classes can detect it, e.g. #URRROS2JointTFComponent of joint without DOF.
+     *
+     * @return true if #bStatic.
+     */
+    UFUNCTION(BlueprintCallable)
+    virtual bool IsStaticTF()
+    {
+        return bStatic;
+    }
 };
 
 /**
@@ -180,12 +263,100 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     TArray<URRROS2TFComponent*> TFComponents;
 
+    /**
+     * @brief Add InTfc to #TFComponents, compose its full frame ids and reserve a transform for it in #TFMsg.
+     *
+     * @param InTfc
+     */
+    UFUNCTION(BlueprintCallable)
+    void AddTFComponent(URRROS2TFComponent* InTfc);
+
+    //! Publish static tfs, i.e. #URRROS2TFComponent::IsStaticTF, once on /tf_static by #StaticTFPublisher, and dynamic tfs on
+    //! /tf only when they change or at #KeepAliveInterval. Applied on first #UpdateMessage.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool bSplitStaticTFs = false;
+
+    //! [cm] Dynamic tf whose translation changes more than it is published
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float TranslationEpsilon = 0.01f;
+
+    //! [rad] Dynamic tf whose rotation changes more than it is published
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float RotationEpsilon = 0.0001f;
+
+    //! [s] Unchanged dynamic tf is republished at this interval, so that tf listeners do not fail to extrapolate it.
+    //! Non positive value disables it.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float KeepAliveInterval = 1.f;
+
+    //! Latches static tfs on /tf_static with transient local QoS, created if #bSplitStaticTFs
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    URRROS2TFsPublisher* StaticTFPublisher = nullptr;
+
+    //! Number of messages published on /tf
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Stats")
+    int32 NumPublishedMsgs = 0;
+
+    //! Number of transforms published on /tf
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Stats")
+    int32 NumPublishedTFs = 0;
+
+    /**
+     * @brief Update message from #TFComponents. Start publishing static and dynamic tfs separately if #bSplitStaticTFs.
+     *
+     * @param InMessage
+     */
+    virtual void UpdateMessage(UROS2GenericMsg* InMessage) override;
+
     /**
      * @brief Add all #TFComponents to OutROSTf
      *
      * @param OutROSTf
      */
     virtual void GetROS2Msg(FROSTFMsg& OutROSTf) override;
+
+    /**
+     * @brief Stop publish timer, including #PublishTimerHandle which replaces it after #StartSplitStaticTFs.
+     */
+    virtual void StopPublishTimer() override;
+
+protected:
+    /**
+     * @brief Create #StaticTFPublisher and replace publish timer with #PublishDynamicTFs.
+     */
+    void StartSplitStaticTFs();
+
+    /**
+     * @brief Sort #TFComponents added since last call into #StaticTFPublisher and #DynamicTFComponents.
+     * All of them are sorted again if #TFComponents has shrunk.
+     */
+    void SortTFComponents();
+
+    /**
+     * @brief Publish static tfs if they have been added, then changed dynamic tfs if any. Called by #PublishTimerHandle.
+     */
+    void PublishDynamicTFs();
+
+    /**
+     * @brief Whether dynamic tf should be published, i.e. it changed more than epsilons or #KeepAliveInterval elapsed.
+     *
+     * @param InTfc
+     * @param InTF Current tf of InTfc
+     * @param InTime [s] Current world time
+     */
+    bool ShouldPublishTF(const URRROS2TFComponent* InTfc, const FTransform& InTF, const double InTime) const;
+
+    UPROPERTY()
+    TArray<URRROS2TFComponent*> DynamicTFComponents;
+
+    //! Number of #TFComponents sorted by #SortTFComponents
+    int32 NumSortedTFComponents = 0;
+
+    bool bSplitStarted = false;
+
+    bool bStaticTFsAdded = false;
+
+    FTimerHandle PublishTimerHandle;
 };
 
 /**
@@ -230,6 +401,15 @@ public:
      */
     virtual FTransform GetTF() override;
 
+    /**
+     * @brief Whether TF never changes, i.e. #bStatic, or by type of the joint between #ParentLink and #ChildLink, looked up
+     * in their owners: URRJointComponent without DOF or UPhysicsConstraintComponent with all motions locked.
+     * Without joint, only links with static mobility are static.
+     *
+     * @return bool
+     */
+    virtual bool IsStaticTF() override;
+
     /**
      * @brief Set Parent link and name
      *
@@ -310,8 +490,19 @@ public:
                                           UPhysicsConstraintComponent* InConstraint)
     {
         AddLinksFromConstraint(InConstraint, InFrameId, InChildFrameId);
+        Constraint = InConstraint;
     }
 
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    UPhysicsConstraintComponent* Constraint = nullptr;
+
+    /**
+     * @brief Whether TF never changes, i.e. #bStatic or all motions of #Constraint are locked.
+     *
+     * @return bool
+     */
+    virtual bool IsStaticTF() override;
+
     /**
      * @brief Add URRROS2PhysicsConstraintTFComponent to #OutTFsPublisher::TFComponents.
      *
@@ -358,6 +549,13 @@ public:
 
     virtual FTransform GetTF() override;
 
+    /**
+     * @brief Whether TF never changes, i.e. #bStatic or #Joint has no DOF.
+     *
+     * @return bool
+     */
+    virtual bool IsStaticTF() override;
+
     /**
      * @brief Add URRROS2JointTFComponent to #OutTFsPublisher::TFComponents.
      *
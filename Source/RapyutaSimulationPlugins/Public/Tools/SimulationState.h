@@ -8,8 +8,10 @@
 #pragma once
 
 // UE
+#include "Containers/Queue.h"
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Net/Serialization/FastArraySerializer.h"
 
 // rclUE
 #include "Srvs/ROS2Attach.h"
@@ -25,12 +27,16 @@
 
 #include "SimulationState.generated.h"
 
+class ASimulationState;
+struct FRRReplicatedEntityArray;
+struct FRRSpawnableEntityInfoArray;
+
 /**
  * @brief FRREntityInfo
  * This struct is used to create #SpawnableEntityInfoList
  */
 USTRUCT()
-struct RAPYUTASIMULATIONPLUGINS_API FRREntityInfo
+struct RAPYUTASIMULATIONPLUGINS_API FRREntityInfo : public FFastArraySerializerItem
 {
     GENERATED_BODY()
 
@@ -47,6 +53,169 @@ struct RAPYUTASIMULATIONPLUGINS_API FRREntityInfo
         : EntityTypeName(InEntityInfo.Key), EntityClass(InEntityInfo.Value)
     {
     }
+
+    //! Remove entity type from owner's #ASimulationState::SpawnableEntityTypes on client
+    void PreReplicatedRemove(const FRRSpawnableEntityInfoArray& InArraySerializer);
+
+    //! Add entity type to owner's #ASimulationState::SpawnableEntityTypes on client
+    void PostReplicatedAdd(const FRRSpawnableEntityInfoArray& InArraySerializer);
+
+    //! Update entity type in owner's #ASimulationState::SpawnableEntityTypes on client
+    void PostReplicatedChange(const FRRSpawnableEntityInfoArray& InArraySerializer);
+};
+
+/**
+ * @brief Spawnable entity infos keyed by EntityTypeName, replicated as deltas.
+ * Items are added, updated and removed one by one on server, thus only changed items are sent to clients, whose
+ * #ASimulationState::SpawnableEntityTypes is updated by item callbacks.
+ */
+USTRUCT()
+struct RAPYUTASIMULATIONPLUGINS_API FRRSpawnableEntityInfoArray : public FFastArraySerializer
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TArray<FRREntityInfo> Items;
+
+    //! Simulation state whose #ASimulationState::SpawnableEntityTypes mirrors #Items on client
+    UPROPERTY(NotReplicated)
+    ASimulationState* Owner = nullptr;
+
+    /**
+     * @brief Add entity info or update its class if its type name is already added.
+     * @param InEntityTypeName
+     * @param InEntityClass
+     * @return true if an item has been added or changed.
+     */
+    bool AddOrUpdate(const FString& InEntityTypeName, const TSubclassOf<AActor>& InEntityClass);
+
+    /**
+     * @brief Remove entity info of given type name.
+     * @param InEntityTypeName
+     * @return true if an item has been removed.
+     */
+    bool Remove(const FString& InEntityTypeName);
+
+    int32 Num() const
+    {
+        return Items.Num();
+    }
+
+    bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+    {
+        return FFastArraySerializer::FastArrayDeltaSerialize<FRREntityInfo, FRRSpawnableEntityInfoArray>(
+            Items, DeltaParms, *this);
+    }
+
+private:
+    //! Index of each EntityTypeName in #Items, on server
+    TMap<FString, int32> ItemIndices;
+};
+
+template<>
+struct TStructOpsTypeTraits<FRRSpawnableEntityInfoArray> : public TStructOpsTypeTraitsBase2<FRRSpawnableEntityInfoArray>
+{
+    enum
+    {
+        WithNetDeltaSerializer = true,
+    };
+};
+
+/**
+ * @brief Entity of #ASimulationState::EntityList.
+ * It is identified on network by the item's ReplicationID and the entity's network GUID, not by its name.
+ */
+USTRUCT(BlueprintType)
+struct RAPYUTASIMULATIONPLUGINS_API FRRReplicatedEntity : public FFastArraySerializerItem
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly)
+    AActor* Entity = nullptr;
+
+    FRRReplicatedEntity()
+    {
+    }
+    FRRReplicatedEntity(AActor* InEntity) : Entity(InEntity)
+    {
+    }
+
+    //! Remove entity from owner's #ASimulationState::Entities and #ASimulationState::EntitiesWithTag on client
+    void PreReplicatedRemove(const FRRReplicatedEntityArray& InArraySerializer);
+
+    //! Add entity to owner's #ASimulationState::Entities and #ASimulationState::EntitiesWithTag on client
+    void PostReplicatedAdd(const FRRReplicatedEntityArray& InArraySerializer);
+
+    //! Add entity once its reference is resolved, i.e. if it has been replicated after the item
+    void PostReplicatedChange(const FRRReplicatedEntityArray& InArraySerializer);
+};
+
+/**
+ * @brief Entities under control of #ASimulationState, replicated as deltas.
+ * Entities are added and removed one by one on server, thus only added and removed items are sent to clients, whose
+ * #ASimulationState::Entities and #ASimulationState::EntitiesWithTag are updated by item callbacks.
+ */
+USTRUCT(BlueprintType)
+struct RAPYUTASIMULATIONPLUGINS_API FRRReplicatedEntityArray : public FFastArraySerializer
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly)
+    TArray<FRRReplicatedEntity> Items;
+
+    //! Simulation state whose #ASimulationState::Entities and #ASimulationState::EntitiesWithTag mirror #Items on client
+    UPROPERTY(NotReplicated)
+    ASimulationState* Owner = nullptr;
+
+    /**
+     * @brief Add entity if not yet, in O(1).
+     * @param InEntity
+     * @return true if an item has been added.
+     */
+    bool Add(AActor* InEntity);
+
+    /**
+     * @brief Remove entity, in O(1).
+     * @param InEntity
+     * @return true if an item has been removed.
+     */
+    bool Remove(AActor* InEntity);
+
+    bool Contains(const AActor* InEntity) const
+    {
+        return ItemIndices.Contains(TWeakObjectPtr<const AActor>(InEntity));
+    }
+
+    int32 Num() const
+    {
+        return Items.Num();
+    }
+
+    /**
+     * @brief Get entities of #Items, in the same order.
+     * @return TArray<AActor*>
+     */
+    TArray<AActor*> GetEntities() const;
+
+    bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+    {
+        return FFastArraySerializer::FastArrayDeltaSerialize<FRRReplicatedEntity, FRRReplicatedEntityArray>(
+            Items, DeltaParms, *this);
+    }
+
+private:
+    //! Index of each entity in #Items, on server. Keyed weakly, so that an actor spawned at the address of a destroyed one
+    //! which is still in #Items is not taken for it.
+    TMap<TWeakObjectPtr<const AActor>, int32> ItemIndices;
+};
+
+template<>
+struct TStructOpsTypeTraits<FRRReplicatedEntityArray> : public TStructOpsTypeTraitsBase2<FRRReplicatedEntityArray>
+{
+    enum
+    {
+        WithNetDeltaSerializer = true,
+    };
 };
 
 /**
@@ -61,6 +230,70 @@ struct RAPYUTASIMULATIONPLUGINS_API FRREntities
 
     UPROPERTY(BlueprintReadOnly)
     TArray<AActor*> Actors;
+
+    /**
+     * @brief Add actor to #Actors if not yet, in O(1).
+     * @param InActor
+     * @return true if InActor has been added.
+     */
+    bool Add(AActor* InActor);
+
+    /**
+     * @brief Remove actor from #Actors, in O(1) if it is not there.
+     * @param InActor
+     * @return true if InActor has been removed.
+     */
+    bool Remove(AActor* InActor);
+
+    /**
+     * @brief Remove actors which are not valid anymore, e.g. destroyed or garbage collected without being removed.
+     * @return int32 Number of removed actors.
+     */
+    int32 RemoveInvalid();
+
+private:
+    //! Set of #Actors, only used to check membership. Weak, thus the entry of an actor which has been destroyed without being
+    //! removed never matches another actor allocated at the same address.
+    TSet<TWeakObjectPtr<const AActor>> ActorSet;
+};
+
+/**
+ * @brief Pool settings of a spawnable entity type.
+ */
+USTRUCT(BlueprintType)
+struct RAPYUTASIMULATIONPLUGINS_API FRREntityPoolSettings
+{
+    GENERATED_BODY()
+
+    //! Max number of removed entities kept for reuse. 0 disables pooling of the type.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    int32 MaxPoolSize = 64;
+
+    //! Number of entities spawned into the pool by #ASimulationState::ServerWarmupEntityPools, up to #MaxPoolSize
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    int32 WarmupSize = 0;
+};
+
+/**
+ * @brief Deactivated entities of a spawnable entity type, waiting to be reused.
+ */
+USTRUCT()
+struct RAPYUTASIMULATIONPLUGINS_API FRREntityPool
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TArray<AActor*> Actors;
+};
+
+/**
+ * @brief Entity of a SpawnEntities request waiting for its frame's spawn budget, @sa ASimulationState::SpawnBudgetMs
+ */
+struct FRRPendingEntitySpawn
+{
+    FROSSpawnEntityReq Request;
+
+    int32 NetworkPlayerId = 0;
 };
 
 // (NOTE) To be renamed ARRROS2SimulationState, due to its inherent attachment to ROS 2 Node
@@ -88,6 +321,12 @@ public:
      */
     ASimulationState();
 
+    /**
+     * @brief Spawn entities queued by #ServerSpawnEntities within this frame's spawn budget.
+     * @param DeltaSeconds
+     */
+    virtual void Tick(float DeltaSeconds) override;
+
 public:
     /**
      * @brief Register entity types from Blueprint class names, that are configured in #ARRROS2GameMode
@@ -165,6 +404,45 @@ public:
     UPROPERTY(BlueprintReadOnly)
     FROSSpawnEntityReq PrevSpawnEntityRequest;
 
+    /**
+     * @brief Spawn all entities of a SpawnEntities request on Server.
+     * All entities are spawned deferred first, then their construction is finished together and they are added with
+     * #ServerAddEntity. Entities whose type is not spawnable, whose name is empty or already used, including by a previous
+     * entity of the same request or by a queued entity, or whose reference frame is unknown are skipped. A reference frame
+     * may be an existing entity, an entity spawned earlier in the same request or a queued entity.
+     * With a spawn budget, valid entities are queued instead and spawned one by one within the budget of this frame and
+     * next ones, @sa #SpawnBudgetMs, #SpawnBudgetEntities.
+     * @param InRequest
+     * @param InNetworkPlayerId
+     * @param OutStatusMessages One per entity of InRequest, empty if entity has been spawned or queued
+     * @return int32 Number of spawned or queued entities
+     */
+    UFUNCTION(BlueprintCallable)
+    int32 ServerSpawnEntities(const FROSSpawnEntitiesReq& InRequest,
+                              const int32 InNetworkPlayerId,
+                              TArray<FString>& OutStatusMessages);
+
+    //! [ms] Max time spent spawning entities of SpawnEntities requests per frame, not limited if not positive.
+    //! At least one queued entity is spawned per frame, thus a frame may exceed it by the spawn time of one entity.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    float SpawnBudgetMs = 0.f;
+
+    //! Max number of entities of SpawnEntities requests spawned per frame, not limited if not positive.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    int32 SpawnBudgetEntities = 0;
+
+    //! Number of entities queued by #ServerSpawnEntities, which have not been spawned yet
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    int32 NumPendingSpawns = 0;
+
+    //! [ms] Max time spent spawning queued entities in one frame so far
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    float MaxSpawnFrameTimeMs = 0.f;
+
+    //! Max number of queued entities spawned in one frame so far
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    int32 MaxSpawnFrameEntities = 0;
+
     /**
      * @brief Check delete-entity-request for duplication on Server
      * @todo is this necessary?
@@ -175,6 +453,7 @@ public:
 
     /**
      * @brief Delete entity on Server
+     * The entity is put into the pool of its type instead of being destroyed if #bEnableEntityPooling.
      * @todo is this necessary?
      * @param InRequest
      */
@@ -208,6 +487,13 @@ public:
     UFUNCTION(BlueprintCallable)
     void AddSpawnableEntityTypes(TMap<FString, TSubclassOf<AActor>> InSpawnableEntityTypes);
 
+    /**
+     * @brief Remove Entity Types from #SpawnableEntities and #SpawnableEntityInfoList.
+     * @param InEntityTypeNames
+     */
+    UFUNCTION(BlueprintCallable)
+    void RemoveSpawnableEntityTypes(const TArray<FString>& InEntityTypeNames);
+
     //! All existing entities which can be manipulated by this class via ROS 2 services.
     //! @todo Converting to TArrays to be able to be replicated
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
@@ -222,40 +508,92 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     TMap<FName, FRREntities> EntitiesWithTag;
 
-    //! Replicatable copy of #Entities
-    UPROPERTY(EditAnywhere, BlueprintReadWrite, ReplicatedUsing = OnRep_EntityList)
-    TArray<AActor*> EntityList;
+    //! Replicatable copy of #Entities, one item per entity, replicated as deltas
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Replicated)
+    FRRReplicatedEntityArray EntityList;
 
     /**
-     * @brief Callback when #EntityList is replicated
+     * @brief Get entities of #EntityList as an array, as #EntityList was before being replicated as deltas.
+     * @return TArray<AActor*>
+     */
+    UFUNCTION(BlueprintCallable, BlueprintPure)
+    TArray<AActor*> GetEntityList() const
+    {
+        return EntityList.GetEntities();
+    }
+
+    /**
+     * @brief Add all entities of #EntityList to #Entities and #EntitiesWithTag on client.
+     * Not needed after replication, which adds and removes entities one by one with #AddReplicatedEntity and
+     * #RemoveReplicatedEntity.
      */
     UFUNCTION(BlueprintCallable)
     void OnRep_EntityList();
 
+    /**
+     * @brief Add an entity replicated in #EntityList to #Entities and #EntitiesWithTag on client, with its spawned name
+     * and tags.
+     * @param InEntity
+     */
+    void AddReplicatedEntity(AActor* InEntity);
+
+    /**
+     * @brief Remove an entity removed from #EntityList from #Entities and #EntitiesWithTag on client.
+     * @param InEntity nullptr if its actor channel has been closed before, then all invalid entities are removed with
+     * #RemoveInvalidEntities.
+     */
+    void RemoveReplicatedEntity(AActor* InEntity);
+
+    /**
+     * @brief Remove entities which are not valid anymore from #Entities and #EntitiesWithTag.
+     */
+    void RemoveInvalidEntities();
+
     //! Spawnable entity types for SpawnEntity ROS 2 service.
     //! @todo Converting to TArrays to be able to be replicated
     UPROPERTY(EditAnywhere, BlueprintReadWrite)
     TMap<FString, TSubclassOf<AActor>> SpawnableEntityTypes;
 
-    //! Replicatable Copy of #SpawnableEntityTypes
-    UPROPERTY(EditAnywhere, ReplicatedUsing = OnRep_SpawnableEntityInfoList)
-    TArray<FRREntityInfo> SpawnableEntityInfoList;
+    //! Replicatable Copy of #SpawnableEntityTypes, one item per entity type, replicated as deltas
+    UPROPERTY(EditAnywhere, Replicated)
+    FRRSpawnableEntityInfoArray SpawnableEntityInfoList;
 
     /**
-     * @brief Fetch #SpawnableEntityInfoList
+     * @brief Sync #SpawnableEntityInfoList with #SpawnableEntityTypes, e.g. if the latter has been set directly.
+     * Only entity types which are missing or whose class differs are marked to be replicated.
      */
     UFUNCTION(BlueprintCallable)
     void GetSpawnableEntityInfoList();
 
+    //! Timer handle to fetch #SpawnableEntityInfoList
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+    FTimerHandle FetchEntityListTimerHandle;
+
+    //! Deactivate deleted entities and reuse them for next spawns of the same entity type, instead of destroying them.
+    //! Robots are never pooled.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    bool bEnableEntityPooling = false;
+
+    //! Pool settings per spawnable entity type. #DefaultEntityPoolSettings is used for types which are not in it.
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    TMap<FString, FRREntityPoolSettings> EntityPoolSettings;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite)
+    FRREntityPoolSettings DefaultEntityPoolSettings;
+
     /**
-     * @brief Callback when #SpawnableEntityInfoList is replicated
+     * @brief Spawn WarmupSize deactivated entities into the pool of each spawnable entity type, if #bEnableEntityPooling.
      */
     UFUNCTION(BlueprintCallable)
-    void OnRep_SpawnableEntityInfoList();
+    void ServerWarmupEntityPools();
 
-    //! Timer handle to fetch #SpawnableEntityInfoList
-    UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
-    FTimerHandle FetchEntityListTimerHandle;
+    /**
+     * @brief Get number of deactivated entities of given type waiting to be reused.
+     * @param InEntityTypeName
+     * @return int32
+     */
+    UFUNCTION(BlueprintCallable)
+    int32 GetNumPooledEntities(const FString& InEntityTypeName) const;
 
     /**
      * @brief Matches UE strings to original char buffers, for ros messages
@@ -281,4 +619,95 @@ private:
                               const TSubclassOf<AActor>& InEntityClass,
                               const FTransform& InEntityTransform,
                               const int32& InNetworkPlayerId);
+
+    /**
+     * @brief Spawn entity deferred with tag & nav surrogate, without finishing its construction.
+     * @param InROSSpawnRequest (FROSSpawnEntityReq)
+     * @param InEntityClass
+     * @param InEntityTransform
+     * @param InNetworkPlayerId
+     * @return AActor* Entity to be given to UGameplayStatics::FinishSpawningActor
+     */
+    AActor* ServerBeginSpawnEntity(const FROSSpawnEntityReq& InROSSpawnRequest,
+                                   const TSubclassOf<AActor>& InEntityClass,
+                                   const FTransform& InEntityTransform,
+                                   const int32& InNetworkPlayerId);
+
+    /**
+     * @brief Get world transform of a spawn request's pose from its reference frame.
+     * @param InState
+     * @param OutWorldTransform
+     * @param InBatchTransforms World transforms of entities spawned earlier in the same request, which are not in
+     * #Entities yet, by name
+     * @return false if reference frame is neither empty, an entity nor in InBatchTransforms.
+     */
+    bool GetSpawnWorldTransform(const FROSEntityState& InState,
+                                FTransform& OutWorldTransform,
+                                const TMap<FString, FTransform>* InBatchTransforms = nullptr);
+
+    bool HasSpawnBudget() const
+    {
+        return (SpawnBudgetMs > 0.f) || (SpawnBudgetEntities > 0);
+    }
+
+    /**
+     * @brief Spawn queued entities in order, until this frame's spawn budget is used up or the queue is empty.
+     */
+    void ServerSpawnPendingEntities();
+
+    //! Entities queued by #ServerSpawnEntities, in request order
+    TQueue<FRRPendingEntitySpawn> PendingSpawns;
+
+    //! Names of #PendingSpawns, which are not available to other entities
+    TSet<FString> PendingSpawnNames;
+
+    //! Frame whose spawn budget is being used
+    uint64 SpawnBudgetFrame = 0;
+
+    //! [ms] Time spent spawning queued entities in #SpawnBudgetFrame
+    double SpawnFrameTimeMs = 0.0;
+
+    //! Number of queued entities spawned in #SpawnBudgetFrame
+    int32 SpawnFrameEntities = 0;
+
+    //! Deactivated entities per spawnable entity type
+    UPROPERTY()
+    TMap<FString, FRREntityPool> EntityPools;
+
+    const FRREntityPoolSettings& GetEntityPoolSettings(const FString& InEntityTypeName) const;
+
+    /**
+     * @brief Reuse a pooled entity of the requested type, re-initialized with InROSSpawnRequest as a spawned one.
+     * Pooled entities whose class is not InEntityClass anymore are destroyed.
+     * @param InROSSpawnRequest
+     * @param InEntityClass
+     * @param InEntityTransform
+     * @param InNetworkPlayerId
+     * @return AActor* nullptr if pooling is disabled or the pool of the type is empty.
+     */
+    AActor* ServerAcquirePooledEntity(const FROSSpawnEntityReq& InROSSpawnRequest,
+                                      const TSubclassOf<AActor>& InEntityClass,
+                                      const FTransform& InEntityTransform,
+                                      const int32 InNetworkPlayerId);
+
+    /**
+     * @brief Deactivate entity and put it into the pool of its type, if it can be pooled.
+     * Entity should have been removed from entity maps beforehand.
+     * @param InEntity
+     * @return false if entity has not been pooled and should be destroyed.
+     */
+    bool ServerReleaseEntity(AActor* InEntity);
+
+    /**
+     * @brief Hide entity, disable its collision, its tick and its components' ones, and put its rigid bodies to sleep.
+     * @param InEntity
+     */
+    static void DeactivateEntity(AActor* InEntity);
+
+    /**
+     * @brief Teleport entity and restore its visibility, collision, tick and its components' ones from their defaults.
+     * @param InEntity
+     * @param InEntityTransform
+     */
+    static void ActivateEntity(AActor* InEntity, const FTransform& InEntityTransform);
 };
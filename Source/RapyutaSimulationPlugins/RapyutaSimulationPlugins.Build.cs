@@ -44,7 +44,7 @@ public class RapyutaSimulationPlugins : ModuleRules
         bEnableExceptions = true;
 
         // Runtime modules
-        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "RenderCore", "Renderer", "RHI", "PhysicsCore",
+        PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "NetCore", "RenderCore", "Renderer", "RHI", "PhysicsCore",
                                                             "ImageWrapper", "XmlParser", "Json", "PakFile", "IESFile",
                                                             "AIModule", "NavigationSystem", "TimeManagement", "UMG",
                                                             "ChaosVehicles",
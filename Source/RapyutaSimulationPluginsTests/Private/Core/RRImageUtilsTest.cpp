@@ -0,0 +1,193 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+// UE
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+
+// RapyutaSimulationPlugins
+#include "Core/RRImageUtils.h"
+
+#include "RRTestUtils.h"
+
+// std
+#include <limits>
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRRImageUtilsBGRATest, "RapyutaSimulationPlugins.Core.ImageUtilsBGRA", RR_TEST_FLAGS)
+
+bool FRRImageUtilsBGRATest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NUM_ITERATIONS = 30;
+    static constexpr ERRImageEncoding ENCODINGS[] = {ERRImageEncoding::RGB8,
+                                                     ERRImageEncoding::BGR8,
+                                                     ERRImageEncoding::BGRA8,
+                                                     ERRImageEncoding::MONO8};
+
+    // 1920x1080 is timed, other sizes check leftover pixels which are not a multiple of SIMD width
+    for (const int32 nPixels : {1920 * 1080, 1, 15, 33, 1027})
+    {
+        FRandomStream randomStream(nPixels);
+        TArray<FColor> pixels;
+        pixels.SetNumUninitialized(nPixels);
+        for (FColor& pixel : pixels)
+        {
+            pixel.DWColor() = static_cast<uint32>(randomStream.GetUnsignedInt());
+        }
+
+        const int32 nIterations = (nPixels == 1920 * 1080) ? NUM_ITERATIONS : 1;
+        for (const ERRImageEncoding encoding : ENCODINGS)
+        {
+            const int32 nBytes = nPixels * URRImageUtils::GetBytesPerPixel(encoding);
+            TArray<uint8> referenceData;
+            TArray<uint8> data;
+            referenceData.SetNumZeroed(nBytes);
+            data.SetNumZeroed(nBytes);
+
+            double startTime = FPlatformTime::Seconds();
+            for (int32 i = 0; i < nIterations; ++i)
+            {
+                URRImageUtils::ConvertBGRAScalar(pixels.GetData(), nPixels, encoding, referenceData.GetData());
+            }
+            const double scalarTime = (FPlatformTime::Seconds() - startTime) * 1000.0 / nIterations;
+
+            startTime = FPlatformTime::Seconds();
+            for (int32 i = 0; i < nIterations; ++i)
+            {
+                URRImageUtils::ConvertBGRA(pixels.GetData(), nPixels, encoding, data.GetData());
+            }
+            const double time = (FPlatformTime::Seconds() - startTime) * 1000.0 / nIterations;
+
+            const FString encodingName = URRImageUtils::GetImageEncodingName(encoding);
+            if (nIterations > 1)
+            {
+                AddInfo(FString::Printf(TEXT("%s 1920x1080: scalar %.3fms, converted %.3fms"), *encodingName, scalarTime, time));
+            }
+            TestTrue(FString::Printf(TEXT("%s of %d pixels matches scalar reference"), *encodingName, nPixels),
+                     FMemory::Memcmp(referenceData.GetData(), data.GetData(), nBytes) == 0);
+        }
+    }
+
+    // Known pixels
+    const FColor pixel(200, 100, 50, 255);
+    uint8 rgb[3] = {0};
+    uint8 bgr[3] = {0};
+    uint8 mono = 0;
+    URRImageUtils::ConvertBGRA(&pixel, 1, ERRImageEncoding::RGB8, rgb);
+    URRImageUtils::ConvertBGRA(&pixel, 1, ERRImageEncoding::BGR8, bgr);
+    URRImageUtils::ConvertBGRA(&pixel, 1, ERRImageEncoding::MONO8, &mono);
+    TestTrue(TEXT("rgb8"), rgb[0] == 200 && rgb[1] == 100 && rgb[2] == 50);
+    TestTrue(TEXT("bgr8"), bgr[0] == 50 && bgr[1] == 100 && bgr[2] == 200);
+    TestEqual(TEXT("mono8"), static_cast<int32>(mono), (38 * 200 + 75 * 100 + 15 * 50 + 64) >> 7);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRRImageUtilsDepthTest, "RapyutaSimulationPlugins.Core.ImageUtilsDepth", RR_TEST_FLAGS)
+
+bool FRRImageUtilsDepthTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NUM_ITERATIONS = 30;
+    static constexpr int32 WIDTH = 640;
+    static constexpr int32 HEIGHT = 480;
+    static constexpr float MIN_DEPTH = 0.1f;
+    static constexpr float MAX_DEPTH = 100.f;
+
+    // Known depths: {depth [cm], 32FC1 [m] or NaN if invalid, 16UC1 [mm]}
+    struct FDepthCase
+    {
+        float Depth;
+        float ExpectedDepth;
+        uint16 ExpectedDepthMM;
+    };
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const FDepthCase depthCases[] = {{5.f, nan, 0},
+                                     {20.f, 0.2f, 200},
+                                     {150.04f, 1.5004f, 1500},
+                                     {150.06f, 1.5006f, 1501},
+                                     {6553.5f, 65.535f, 65535},
+                                     {6553.6f, 65.536f, 0},
+                                     {10001.f, nan, 0},
+                                     {std::numeric_limits<float>::infinity(), nan, 0},
+                                     {nan, nan, 0}};
+    for (const FDepthCase& depthCase : depthCases)
+    {
+        const FLinearColor pixel(depthCase.Depth, 0.f, 0.f, 1.f);
+        float depth = 0.f;
+        uint16 depthMM = 0;
+        URRImageUtils::ConvertDepthScalar(
+            &pixel, 1, ERRImageEncoding::DEPTH_32FC1, MIN_DEPTH, MAX_DEPTH, reinterpret_cast<uint8*>(&depth));
+        URRImageUtils::ConvertDepthScalar(
+            &pixel, 1, ERRImageEncoding::DEPTH_16UC1, MIN_DEPTH, MAX_DEPTH, reinterpret_cast<uint8*>(&depthMM));
+        const bool bDepthMatch = FMath::IsNaN(depthCase.ExpectedDepth)
+                                     ? FMath::IsNaN(depth)
+                                     : FMath::IsNearlyEqual(depth, depthCase.ExpectedDepth, KINDA_SMALL_NUMBER);
+        TestTrue(FString::Printf(TEXT("32FC1 of %f cm"), depthCase.Depth), bDepthMatch);
+        TestEqual(FString::Printf(TEXT("16UC1 of %f cm"), depthCase.Depth),
+                  static_cast<int32>(depthMM),
+                  static_cast<int32>(depthCase.ExpectedDepthMM));
+    }
+
+    // Synthetic depth buffer, partly out of range and with no hit. Odd size checks leftover pixels of SIMD.
+    for (const int32 nPixels : {WIDTH * HEIGHT, 1, 7, 1027})
+    {
+        FRandomStream randomStream(nPixels);
+        TArray<FLinearColor> pixels;
+        pixels.SetNumUninitialized(nPixels);
+        for (FLinearColor& pixel : pixels)
+        {
+            const float depth = randomStream.FRandRange(0.f, MAX_DEPTH * 120.f);
+            pixel = FLinearColor((randomStream.FRand() < 0.05f) ? std::numeric_limits<float>::infinity() : depth, 0.f, 0.f, 1.f);
+        }
+
+        const int32 nIterations = (nPixels == WIDTH * HEIGHT) ? NUM_ITERATIONS : 1;
+        for (const ERRImageEncoding encoding : {ERRImageEncoding::DEPTH_32FC1, ERRImageEncoding::DEPTH_16UC1})
+        {
+            const int32 nBytes = nPixels * URRImageUtils::GetBytesPerPixel(encoding);
+            TArray<uint8> referenceData;
+            TArray<uint8> data;
+            referenceData.SetNumZeroed(nBytes);
+            data.SetNumZeroed(nBytes);
+
+            double startTime = FPlatformTime::Seconds();
+            for (int32 i = 0; i < nIterations; ++i)
+            {
+                URRImageUtils::ConvertDepthScalar(
+                    pixels.GetData(), nPixels, encoding, MIN_DEPTH, MAX_DEPTH, referenceData.GetData());
+            }
+            const double scalarTime = (FPlatformTime::Seconds() - startTime) * 1000.0 / nIterations;
+
+            startTime = FPlatformTime::Seconds();
+            for (int32 i = 0; i < nIterations; ++i)
+            {
+                URRImageUtils::ConvertDepth(pixels.GetData(), nPixels, encoding, MIN_DEPTH, MAX_DEPTH, data.GetData());
+            }
+            const double time = (FPlatformTime::Seconds() - startTime) * 1000.0 / nIterations;
+
+            const FString encodingName = URRImageUtils::GetImageEncodingName(encoding);
+            if (nIterations > 1)
+            {
+                AddInfo(FString::Printf(TEXT("%s %dx%d: scalar %.3fms, converted %.3fms, %d bytes per frame"),
+                                        *encodingName,
+                                        WIDTH,
+                                        HEIGHT,
+                                        scalarTime,
+                                        time,
+                                        nBytes));
+            }
+            // Both implementations produce the same NaN, thus outputs can be compared bitwise
+            TestTrue(FString::Printf(TEXT("%s of %d pixels matches scalar reference"), *encodingName, nPixels),
+                     FMemory::Memcmp(referenceData.GetData(), data.GetData(), nBytes) == 0);
+        }
+    }
+
+    // 8 bit scene depth post process path reads back B8G8R8A8 and publishes rgb8
+    AddInfo(FString::Printf(TEXT("Post process rgb8 %dx%d: %d bytes per frame"),
+                            WIDTH,
+                            HEIGHT,
+                            WIDTH * HEIGHT * URRImageUtils::GetBytesPerPixel(ERRImageEncoding::RGB8)));
+
+    return true;
+}
+
+#endif    // WITH_DEV_AUTOMATION_TESTS
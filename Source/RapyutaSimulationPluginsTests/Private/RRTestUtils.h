@@ -0,0 +1,127 @@
+/**
+ * @file RRTestUtils.h
+ * @brief Common utils of RapyutaSimulationPlugins automation tests.
+ * @copyright Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+ */
+
+#pragma once
+
+// UE
+#include "CoreMinimal.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/ConstructorHelpers.h"
+
+#include "RRTestUtils.generated.h"
+
+//! Flags of all RapyutaSimulationPlugins tests, which run in editor, including headless with -nullrhi
+#define RR_TEST_FLAGS (EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+/**
+ * @brief Cube of engine basic shapes blocking all channels, 1m large with scale 1.
+ * Mesh is set at construction, thus it is there when actor spawn is notified, as for Blueprint actors.
+ */
+UCLASS(NotBlueprintable, NotPlaceable)
+class ARRTestCube : public AStaticMeshActor
+{
+    GENERATED_BODY()
+
+public:
+    ARRTestCube()
+    {
+        static ConstructorHelpers::FObjectFinder<UStaticMesh> cubeMesh(TEXT("/Engine/BasicShapes/Cube.Cube"));
+        GetStaticMeshComponent()->SetStaticMesh(cubeMesh.Object);
+        GetStaticMeshComponent()->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+    }
+};
+
+/**
+ * @brief Game world with physics scene, created for a test and destroyed with this object.
+ * Actors are not begun play unless #BeginPlay is called, thus components can be tested without ROS 2 node.
+ * The world has no game mode nor game instance.
+ */
+class FRRTestWorld
+{
+public:
+    FRRTestWorld()
+    {
+        World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("RRTestWorld"));
+        FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+        worldContext.SetCurrentWorld(World);
+        World->InitializeActorsForPlay(FURL());
+    }
+
+    ~FRRTestWorld()
+    {
+        GEngine->DestroyWorldContext(World);
+        World->DestroyWorld(false);
+    }
+
+    UWorld* Get() const
+    {
+        return World;
+    }
+
+    /**
+     * @brief Begin play of world subsystems and actors. Actors spawned later are begun play on spawn.
+     */
+    void BeginPlay()
+    {
+        World->BeginPlay();
+        // Without game mode, actors are begun play directly as AGameStateBase::HandleBeginPlay does
+        World->GetWorldSettings()->NotifyBeginPlay();
+    }
+
+    /**
+     * @brief Tick world, e.g. for newly created physics bodies to be found by scene queries.
+     * @param InNumTicks
+     * @param InDeltaTime
+     */
+    void Tick(const int32 InNumTicks = 1, const float InDeltaTime = 1.f / 30.f)
+    {
+        for (int32 i = 0; i < InNumTicks; ++i)
+        {
+            World->Tick(LEVELTICK_All, InDeltaTime);
+        }
+    }
+
+    /**
+     * @brief Spawn a static #ARRTestCube.
+     * @param InLocation
+     * @param InScale
+     * @param InRotation
+     * @return ARRTestCube*
+     */
+    ARRTestCube* SpawnCube(const FVector& InLocation,
+                           const FVector& InScale = FVector::OneVector,
+                           const FRotator& InRotation = FRotator::ZeroRotator)
+    {
+        FActorSpawnParameters spawnParams;
+        spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+        return World->SpawnActor<ARRTestCube>(
+            ARRTestCube::StaticClass(), FTransform(InRotation, InLocation, InScale), spawnParams);
+    }
+
+    /**
+     * @brief Spawn an actor whose root is a new component of given class.
+     * @tparam TComponent
+     * @param InLocation
+     * @return TComponent*
+     */
+    template<typename TComponent>
+    TComponent* SpawnComponent(const FVector& InLocation = FVector::ZeroVector)
+    {
+        AActor* actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(InLocation));
+        TComponent* component = NewObject<TComponent>(actor);
+        actor->SetRootComponent(component);
+        component->RegisterComponent();
+        actor->SetActorLocation(InLocation);
+        return component;
+    }
+
+private:
+    UWorld* World = nullptr;
+};
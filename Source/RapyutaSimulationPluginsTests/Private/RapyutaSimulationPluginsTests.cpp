@@ -0,0 +1,6 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+// UE
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, RapyutaSimulationPluginsTests)
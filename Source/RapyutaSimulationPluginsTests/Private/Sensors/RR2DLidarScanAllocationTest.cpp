@@ -0,0 +1,75 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+// UE
+#include "Misc/AutomationTest.h"
+
+// RapyutaSimulationPlugins
+#include "Sensors/RR2DLidarComponent.h"
+
+#include "RRTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRR2DLidarScanAllocationTest,
+                                 "RapyutaSimulationPlugins.Sensors.Lidar2DScanAllocation",
+                                 RR_TEST_FLAGS)
+
+bool FRR2DLidarScanAllocationTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NUM_WARMUP_SCANS = 3;
+    static constexpr int32 NUM_SCANS = 20;
+
+    FRRTestWorld world;
+    world.SpawnCube(FVector(1000.f, 0.f, 100.f), FVector(0.5f, 20.f, 2.f));
+    world.SpawnCube(FVector(-1000.f, 0.f, 100.f), FVector(0.5f, 20.f, 2.f));
+    world.SpawnCube(FVector(0.f, 1000.f, 100.f), FVector(20.f, 0.5f, 2.f));
+    world.BeginPlay();
+
+    URR2DLidarComponent* lidar = world.SpawnComponent<URR2DLidarComponent>(FVector(0.f, 0.f, 100.f));
+    lidar->MaxRange = 2000.f;
+    lidar->BWithNoise = true;
+    lidar->bProcessScanAsync = false;
+    lidar->bShowLidarRays = false;
+    // Scans are told apart by their time, which starts at 0
+    world.Tick();
+
+    // Traces are collected and the scan is processed on the next tick
+    auto scan = [&world, lidar]()
+    {
+        const float lastScanTime = lidar->TimeOfLastScan;
+        lidar->SensorUpdate();
+        for (int32 i = 0; (i < 10) && (lidar->TimeOfLastScan == lastScanTime); ++i)
+        {
+            world.Tick();
+        }
+        return lidar->TimeOfLastScan != lastScanTime;
+    };
+
+    for (int32 i = 0; i < NUM_WARMUP_SCANS; ++i)
+    {
+        TestTrue(TEXT("Warmup scan is processed"), scan());
+    }
+    const int32 numWarmupReallocations = lidar->NumScanReallocations;
+    TestTrue(TEXT("Scan storage has been allocated"), numWarmupReallocations > 0);
+
+    // Msg storage is double buffered, thus alternates between 2 allocations
+    TSet<const float*> rangesData;
+    bool bProcessed = true;
+    for (int32 i = 0; i < NUM_SCANS; ++i)
+    {
+        bProcessed &= scan();
+        rangesData.Add(lidar->GetROS2Data().Ranges.GetData());
+    }
+    TestTrue(TEXT("Steady state scans are processed"), bProcessed);
+    TestEqual(TEXT("Reallocations in steady state"), lidar->NumScanReallocations - numWarmupReallocations, 0);
+    TestTrue(TEXT("Ranges storage is reused"), rangesData.Num() <= 2);
+
+    const FROSLaserScan& laserScan = lidar->GetROS2Data();
+    TestEqual(TEXT("Number of ranges"), laserScan.Ranges.Num(), lidar->NSamplesPerScan);
+    TestEqual(TEXT("Number of intensities"), laserScan.Intensities.Num(), lidar->NSamplesPerScan);
+    TestTrue(TEXT("Walls are hit"), laserScan.Ranges.ContainsByPredicate([](const float InRange) { return InRange > 0.f; }));
+
+    return true;
+}
+
+#endif    // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,265 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+// UE
+#include "Misc/AutomationTest.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "UObject/StrongObjectPtr.h"
+
+// RapyutaSimulationPlugins
+#include "Core/RRConversionUtils.h"
+#include "Core/RRGeneralUtils.h"
+#include "Sensors/RR3DLidarComponent.h"
+
+#include "RRTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+static constexpr uint32 REFERENCE_POINT_STEP = 22;
+static const TCHAR* const REFERENCE_FIELD_NAMES[] = {
+    TEXT("x"), TEXT("y"), TEXT("z"), TEXT("intensity"), TEXT("ring"), TEXT("time")};
+static constexpr int32 REFERENCE_FIELD_OFFSETS[] = {0, 4, 8, 12, 16, 18};
+
+/**
+ * @brief Serializer of URR3DLidarComponent::GetROS2Data before #URR3DLidarComponent::SerializePointCloud, without noise.
+ * It wrote all fields, with sample index as ring and 0 as time, and one extra point at the end of unorganized cloud.
+ */
+void SerializePointCloudReference(const FRRPointCloudSerializeParams& InParams,
+                                  const TArray<FHitResult>& InHits,
+                                  FROSPointCloud2& OutMsg)
+{
+    OutMsg.PointStep = REFERENCE_POINT_STEP;
+    OutMsg.Data.Init(0, InHits.Num() * REFERENCE_POINT_STEP);
+
+    int32 count = 0;
+    for (int32 i = 0; i < InParams.NChannelsPerScan; ++i)
+    {
+        for (int32 j = 0; j < InParams.NSamplesPerScan; ++j)
+        {
+            const FHitResult& hit = InHits.Last(j + i * InParams.NSamplesPerScan);
+            float intensity = 0.f;
+            if (hit.PhysMaterial != nullptr)
+            {
+                intensity = (hit.PhysMaterial->SurfaceType == EPhysicalSurface::SurfaceType1) ? InParams.IntensityReflective
+                                                                                              : InParams.IntensityNonReflective;
+            }
+            else if (!InParams.bOrganizedCloud)
+            {
+                continue;
+            }
+
+            const FTransform sensorTransform(
+                InParams.SensorTransform.GetRotation(), InParams.SensorTransform.GetLocation(), FVector::OneVector);
+            const FVector3f pos(URRConversionUtils::VectorUEToROS(
+                URRGeneralUtils::GetRelativeTransform(sensorTransform, FTransform(hit.ImpactPoint)).GetTranslation()));
+            const float time = 0.f;
+            uint8* dst = &OutMsg.Data[count * REFERENCE_POINT_STEP];
+            FMemory::Memcpy(dst, &pos.X, 4);
+            FMemory::Memcpy(dst + 4, &pos.Y, 4);
+            FMemory::Memcpy(dst + 8, &pos.Z, 4);
+            FMemory::Memcpy(dst + 12, &intensity, 4);
+            FMemory::Memcpy(dst + 16, &j, 2);
+            FMemory::Memcpy(dst + 18, &time, 4);
+            ++count;
+        }
+    }
+
+    if (InParams.bOrganizedCloud)
+    {
+        OutMsg.Width = InParams.NSamplesPerScan;
+        OutMsg.Height = InParams.NChannelsPerScan;
+    }
+    else
+    {
+        OutMsg.Data.SetNum((count + 1) * REFERENCE_POINT_STEP, true);
+        OutMsg.Height = 1;
+        OutMsg.Width = count;
+    }
+}
+
+template<typename T>
+T ReadField(const TArray<uint8>& InData, const int32 InPointIndex, const uint32 InPointStep, const uint32 InOffset)
+{
+    T value;
+    FMemory::Memcpy(&value, InData.GetData() + InPointIndex * InPointStep + InOffset, sizeof(T));
+    return value;
+}
+}    // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRR3DLidarPointCloudTest,
+                                 "RapyutaSimulationPlugins.Sensors.Lidar3DPointCloud",
+                                 RR_TEST_FLAGS)
+
+bool FRR3DLidarPointCloudTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NUM_SAMPLES = 1800;
+    static constexpr int32 NUM_CHANNELS = 32;
+    static constexpr int32 NUM_RUNS = 20;
+    // [m]
+    static constexpr float POSITION_TOLERANCE = 1.e-3f;
+
+    // Synthetic scan: every 5th ray misses, every 7th hits a retroreflective surface
+    TStrongObjectPtr<UPhysicalMaterial> defaultMaterial(NewObject<UPhysicalMaterial>());
+    TStrongObjectPtr<UPhysicalMaterial> reflectiveMaterial(NewObject<UPhysicalMaterial>());
+    reflectiveMaterial->SurfaceType = EPhysicalSurface::SurfaceType1;
+
+    FRRPointCloudSerializeParams params;
+    params.SensorTransform = FTransform(FRotator(5.f, 30.f, 0.f), FVector(100.f, -200.f, 50.f));
+    params.ScanPeriod = 0.1f;
+    params.NSamplesPerScan = NUM_SAMPLES;
+    params.NChannelsPerScan = NUM_CHANNELS;
+
+    const int32 nHits = NUM_SAMPLES * NUM_CHANNELS;
+    TArray<FHitResult> hits;
+    hits.Init(FHitResult(ForceInit), nHits);
+    int32 nValidHits = 0;
+    FRandomStream randomStream(0);
+    for (int32 i = 0; i < nHits; ++i)
+    {
+        FHitResult& hit = hits[i];
+        hit.TraceStart = params.SensorTransform.GetLocation();
+        hit.TraceEnd = hit.TraceStart + randomStream.GetUnitVector() * 5000.f;
+        if (i % 5 != 0)
+        {
+            hit.bBlockingHit = true;
+            hit.ImpactPoint = FMath::Lerp(hit.TraceStart, hit.TraceEnd, randomStream.FRandRange(0.01f, 1.f));
+            hit.PhysMaterial = (i % 7 == 0) ? reflectiveMaterial.Get() : defaultMaterial.Get();
+            ++nValidHits;
+        }
+    }
+    const TArray<float> noNoises;
+
+    for (const bool bOrganized : {false, true})
+    {
+        params.bOrganizedCloud = bOrganized;
+        const TCHAR* organization = bOrganized ? TEXT("organized") : TEXT("unorganized");
+
+        FROSPointCloud2 referenceMsg;
+        double startTime = FPlatformTime::Seconds();
+        for (int32 run = 0; run < NUM_RUNS; ++run)
+        {
+            SerializePointCloudReference(params, hits, referenceMsg);
+        }
+        const double referenceTime = (FPlatformTime::Seconds() - startTime) / NUM_RUNS;
+
+        for (const ERRLidarPointCloudLayout layout :
+             {ERRLidarPointCloudLayout::XYZ, ERRLidarPointCloudLayout::XYZI, ERRLidarPointCloudLayout::FULL})
+        {
+            params.Layout = layout;
+            const bool bWithIntensity = (layout != ERRLidarPointCloudLayout::XYZ);
+            const bool bWithRingAndTime = (layout == ERRLidarPointCloudLayout::FULL);
+            const FString what = FString::Printf(TEXT("%s %s cloud"), organization, *UEnum::GetValueAsString(layout));
+
+            FROSPointCloud2 msg;
+            startTime = FPlatformTime::Seconds();
+            for (int32 run = 0; run < NUM_RUNS; ++run)
+            {
+                URR3DLidarComponent::SerializePointCloud(params, hits, noNoises, msg);
+            }
+            const double serializeTime = (FPlatformTime::Seconds() - startTime) / NUM_RUNS;
+
+            // Layout
+            const uint32 pointStep = URR3DLidarComponent::GetPointStep(layout);
+            const int32 nFields = bWithRingAndTime ? 6 : (bWithIntensity ? 4 : 3);
+            TestEqual(FString::Printf(TEXT("Point step of %s"), *what),
+                      static_cast<int32>(msg.PointStep),
+                      static_cast<int32>(pointStep));
+            if (TestEqual(FString::Printf(TEXT("Fields of %s"), *what), msg.Fields.Num(), nFields))
+            {
+                int32 fieldsSize = 0;
+                for (const FROSPointField& field : msg.Fields)
+                {
+                    fieldsSize += (field.Datatype == FROSPointField::UINT16) ? 2 : 4;
+                }
+                TestEqual(FString::Printf(TEXT("Size of fields of %s"), *what), fieldsSize, static_cast<int32>(pointStep));
+                for (int32 i = 0; i < nFields; ++i)
+                {
+                    // Fields are the leading ones of previous layout, which had all of them
+                    const FString fieldWhat = FString::Printf(TEXT("Field %d of %s"), i, *what);
+                    TestEqual(fieldWhat + TEXT(" name"), msg.Fields[i].Name, FString(REFERENCE_FIELD_NAMES[i]));
+                    TestEqual(fieldWhat + TEXT(" offset"), static_cast<int32>(msg.Fields[i].Offset), REFERENCE_FIELD_OFFSETS[i]);
+                    TestEqual(fieldWhat + TEXT(" datatype"),
+                              static_cast<int32>(msg.Fields[i].Datatype),
+                              static_cast<int32>((i == 4) ? FROSPointField::UINT16 : FROSPointField::FLOAT32));
+                }
+            }
+
+            // Point count and byte size. Previous serializer had one extra point at the end of unorganized cloud.
+            const int32 nPoints = bOrganized ? nHits : nValidHits;
+            TestEqual(FString::Printf(TEXT("Points of %s"), *what), static_cast<int32>(msg.Width * msg.Height), nPoints);
+            TestEqual(FString::Printf(TEXT("Width of %s"), *what),
+                      static_cast<int32>(msg.Width),
+                      static_cast<int32>(referenceMsg.Width));
+            TestEqual(FString::Printf(TEXT("Height of %s"), *what),
+                      static_cast<int32>(msg.Height),
+                      static_cast<int32>(referenceMsg.Height));
+            TestEqual(FString::Printf(TEXT("Bytes of %s"), *what), msg.Data.Num(), nPoints * static_cast<int32>(pointStep));
+            TestEqual(FString::Printf(TEXT("Bytes of %s by previous serializer"), *what),
+                      referenceMsg.Data.Num(),
+                      (nPoints + (bOrganized ? 0 : 1)) * static_cast<int32>(REFERENCE_POINT_STEP));
+            TestEqual(FString::Printf(TEXT("Row step of %s"), *what), static_cast<int32>(msg.RowStep * msg.Height), msg.Data.Num());
+            TestEqual(FString::Printf(TEXT("Dense %s"), *what), msg.bIsDense, !bOrganized);
+            if (msg.Data.Num() != nPoints * static_cast<int32>(pointStep))
+            {
+                continue;
+            }
+
+            // Points, in the same order as previous serializer
+            int32 nWrongPositions = 0;
+            int32 nWrongIntensities = 0;
+            int32 nWrongRingsOrTimes = 0;
+            int32 nWrongNoHits = 0;
+            for (int32 i = 0; i < nPoints; ++i)
+            {
+                const FVector3f pos(ReadField<float>(msg.Data, i, pointStep, 0),
+                                    ReadField<float>(msg.Data, i, pointStep, 4),
+                                    ReadField<float>(msg.Data, i, pointStep, 8));
+                const float intensity = bWithIntensity ? ReadField<float>(msg.Data, i, pointStep, 12) : 0.f;
+                const bool bNoHit = bOrganized && (hits[nHits - 1 - i].PhysMaterial == nullptr);
+                if (bNoHit)
+                {
+                    // No hit is NaN in organized cloud, whereas previous serializer wrote the origin
+                    nWrongNoHits += !(FMath::IsNaN(pos.X) && FMath::IsNaN(pos.Y) && FMath::IsNaN(pos.Z) && (intensity == 0.f));
+                    continue;
+                }
+
+                const FVector3f referencePos(ReadField<float>(referenceMsg.Data, i, REFERENCE_POINT_STEP, 0),
+                                             ReadField<float>(referenceMsg.Data, i, REFERENCE_POINT_STEP, 4),
+                                             ReadField<float>(referenceMsg.Data, i, REFERENCE_POINT_STEP, 8));
+                nWrongPositions += !pos.Equals(referencePos, POSITION_TOLERANCE);
+                if (bWithIntensity)
+                {
+                    nWrongIntensities += (intensity != ReadField<float>(referenceMsg.Data, i, REFERENCE_POINT_STEP, 12));
+                }
+                if (bWithRingAndTime && bOrganized)
+                {
+                    // Point index maps to hit index only in organized cloud.
+                    // Ring is channel and time is column's offset within scan, instead of sample index and 0.
+                    const int32 hitIndex = nHits - 1 - i;
+                    const int32 column = hitIndex % NUM_SAMPLES;
+                    const uint16 ring = ReadField<uint16>(msg.Data, i, pointStep, 16);
+                    const float time = ReadField<float>(msg.Data, i, pointStep, 18);
+                    nWrongRingsOrTimes += (ring != hitIndex / NUM_SAMPLES) ||
+                                          !FMath::IsNearlyEqual(time, params.ScanPeriod / NUM_SAMPLES * column, 1.e-6f);
+                }
+            }
+            TestEqual(FString::Printf(TEXT("Wrong positions in %s"), *what), nWrongPositions, 0);
+            TestEqual(FString::Printf(TEXT("Wrong intensities in %s"), *what), nWrongIntensities, 0);
+            TestEqual(FString::Printf(TEXT("Wrong rings or times in %s"), *what), nWrongRingsOrTimes, 0);
+            TestEqual(FString::Printf(TEXT("Wrong no hits in %s"), *what), nWrongNoHits, 0);
+
+            AddInfo(FString::Printf(TEXT("Serialized %d hits into %s of %d bytes in %.3fms, previously %d bytes in %.3fms"),
+                                    nHits,
+                                    *what,
+                                    msg.Data.Num(),
+                                    serializeTime * 1000.0,
+                                    referenceMsg.Data.Num(),
+                                    referenceTime * 1000.0));
+        }
+    }
+
+    return true;
+}
+
+#endif    // WITH_DEV_AUTOMATION_TESTS
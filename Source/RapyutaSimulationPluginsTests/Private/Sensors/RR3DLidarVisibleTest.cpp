@@ -0,0 +1,109 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+// UE
+#include "Misc/AutomationTest.h"
+
+// RapyutaSimulationPlugins
+#include "Sensors/RR3DLidarComponent.h"
+
+#include "RRTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRR3DLidarVisibleTest, "RapyutaSimulationPlugins.Sensors.Lidar3DVisible", RR_TEST_FLAGS)
+
+bool FRR3DLidarVisibleTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NUM_ITERATIONS = 20;
+
+    FRRTestWorld world;
+    URR3DLidarComponent* lidar = world.SpawnComponent<URR3DLidarComponent>();
+    lidar->MaxRange = 3000.f;
+
+    // Dense clutter behind the sensor, a visible target, and a target hidden behind a wall
+    for (int32 i = 0; i < 30; ++i)
+    {
+        for (int32 j = 0; j < 30; ++j)
+        {
+            world.SpawnCube(FVector(-300.f - 80.f * i, -1200.f + 80.f * j, 0.f), FVector(0.3f));
+        }
+    }
+    AActor* visibleTarget = world.SpawnCube(FVector(0.f, 1000.f, 0.f));
+    world.SpawnCube(FVector(500.f, 0.f, 0.f), FVector(0.5f, 4.f, 4.f));
+    AActor* hiddenTarget = world.SpawnCube(FVector(1000.f, 0.f, 0.f));
+    world.Tick(2);
+
+    auto measure = [](const TFunctionRef<bool()>& InVisible, bool& OutVisible)
+    {
+        const double startTime = FPlatformTime::Seconds();
+        for (int32 i = 0; i < NUM_ITERATIONS; ++i)
+        {
+            OutVisible = InVisible();
+        }
+        return (FPlatformTime::Seconds() - startTime) * 1000.0 / NUM_ITERATIONS;
+    };
+
+    for (AActor* target : {visibleTarget, hiddenTarget})
+    {
+        const bool bExpectedVisible = (target == visibleTarget);
+        bool bVisible = false, bVisibleInCone = false, bVisibleFullScan = false;
+        const double visibleTime = measure([lidar, target]() { return lidar->Visible(target); }, bVisible);
+        const double coneTime = measure([lidar, target]() { return lidar->VisibleInCone(target); }, bVisibleInCone);
+        const double fullScanTime = measure([lidar, target]() { return lidar->VisibleFullScan(target); }, bVisibleFullScan);
+        AddInfo(FString::Printf(TEXT("%s target: Visible %.3fms, VisibleInCone %.3fms, VisibleFullScan %.3fms"),
+                                bExpectedVisible ? TEXT("Visible") : TEXT("Hidden"),
+                                visibleTime,
+                                coneTime,
+                                fullScanTime));
+
+        TestEqual(TEXT("VisibleFullScan"), bVisibleFullScan, bExpectedVisible);
+        TestEqual(TEXT("VisibleInCone agrees with VisibleFullScan"), bVisibleInCone, bVisibleFullScan);
+        TestEqual(TEXT("Visible without recent scan agrees with VisibleFullScan"), bVisible, bVisibleFullScan);
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRR3DLidarVisibleRecordedScanTest,
+                                 "RapyutaSimulationPlugins.Sensors.Lidar3DVisibleRecordedScan",
+                                 RR_TEST_FLAGS)
+
+bool FRR3DLidarVisibleRecordedScanTest::RunTest(const FString& Parameters)
+{
+    FRRTestWorld world;
+    AActor* target = world.SpawnCube(FVector(0.f, 1000.f, 0.f));
+    world.BeginPlay();
+
+    URR3DLidarComponent* lidar = world.SpawnComponent<URR3DLidarComponent>();
+    lidar->MaxRange = 3000.f;
+    lidar->BWithNoise = false;
+    lidar->bProcessScanAsync = false;
+    lidar->bShowLidarRays = false;
+    // Scan of time 0 is not used by Visible
+    world.Tick();
+
+    // Traces are collected and the scan is processed on the next tick
+    lidar->SensorUpdate();
+    for (int32 i = 0; (i < 10) && (lidar->TimeOfLastScan == 0.f); ++i)
+    {
+        world.Tick();
+    }
+    auto isTargetHit = [target](const FHitResult& InHit) { return InHit.GetActor() == target; };
+    if (!TestTrue(TEXT("Scan is processed"), lidar->TimeOfLastScan > 0.f) ||
+        !TestTrue(TEXT("Target is in scan"), lidar->RecordedHits.ContainsByPredicate(isTargetHit)))
+    {
+        return false;
+    }
+
+    // Target can no longer be traced, thus only an answer from the scan can see it
+    target->SetActorEnableCollision(false);
+    TestFalse(TEXT("Target is not traced"), lidar->VisibleInCone(target));
+    TestTrue(TEXT("Visible answers from fresh scan"), lidar->Visible(target));
+
+    world.Tick(1, lidar->VisibleStalenessTolerance + 0.1f);
+    TestFalse(TEXT("Visible traces once scan is stale"), lidar->Visible(target));
+
+    return true;
+}
+
+#endif    // WITH_DEV_AUTOMATION_TESTS
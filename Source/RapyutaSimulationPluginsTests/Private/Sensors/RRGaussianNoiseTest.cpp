@@ -0,0 +1,135 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+// std
+#include <random>
+
+// UE
+#include "Misc/AutomationTest.h"
+
+// RapyutaSimulationPlugins
+#include "Sensors/RRROS2BaseSensorComponent.h"
+
+#include "RRTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+void GetMeanVariance(const TArray<double>& InSamples, double& OutMean, double& OutVariance)
+{
+    OutMean = 0.0;
+    for (const double sample : InSamples)
+    {
+        OutMean += sample;
+    }
+    OutMean /= InSamples.Num();
+
+    OutVariance = 0.0;
+    for (const double sample : InSamples)
+    {
+        OutVariance += FMath::Square(sample - OutMean);
+    }
+    OutVariance /= (InSamples.Num() - 1);
+}
+
+//! Two-sample Kolmogorov-Smirnov statistic, ie max distance between empirical CDFs of sorted samples
+double GetKSStatistic(const TArray<double>& InSortedA, const TArray<double>& InSortedB)
+{
+    const double numA = InSortedA.Num();
+    const double numB = InSortedB.Num();
+    double distance = 0.0;
+    int32 i = 0;
+    int32 j = 0;
+    while ((i < InSortedA.Num()) && (j < InSortedB.Num()))
+    {
+        const double x = FMath::Min(InSortedA[i], InSortedB[j]);
+        while ((i < InSortedA.Num()) && (InSortedA[i] <= x))
+        {
+            ++i;
+        }
+        while ((j < InSortedB.Num()) && (InSortedB[j] <= x))
+        {
+            ++j;
+        }
+        distance = FMath::Max(distance, FMath::Abs(i / numA - j / numB));
+    }
+    return distance;
+}
+}    // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRRGaussianNoiseTest, "RapyutaSimulationPlugins.Sensors.GaussianNoise", RR_TEST_FLAGS)
+
+bool FRRGaussianNoiseTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NUM_SAMPLES = 200000;
+    static constexpr int32 SEED = 42;
+    static constexpr float MEAN = 0.5f;
+    static constexpr float COV = 0.04f;
+
+    URRGaussianNoise* noise = NewObject<URRGaussianNoise>();
+    noise->Seed = SEED;
+    noise->Init(MEAN, COV);
+    TArray<float> samples;
+    noise->Fill(samples, NUM_SAMPLES);
+
+    // Previous generator, as reference
+    std::mt19937 rng(SEED);
+    std::normal_distribution<> gaussianRNG(MEAN, std::sqrt(COV));
+    TArray<double> refSamples;
+    refSamples.SetNumUninitialized(NUM_SAMPLES);
+    for (double& refSample : refSamples)
+    {
+        refSample = gaussianRNG(rng);
+    }
+
+    TArray<double> newSamples(samples);
+    double mean = 0.0, variance = 0.0, refMean = 0.0, refVariance = 0.0;
+    GetMeanVariance(newSamples, mean, variance);
+    GetMeanVariance(refSamples, refMean, refVariance);
+
+    // 5 standard errors of mean and variance estimates
+    const double meanTolerance = 5.0 * std::sqrt(COV / NUM_SAMPLES);
+    const double varianceTolerance = 5.0 * COV * std::sqrt(2.0 / (NUM_SAMPLES - 1));
+    TestTrue(FString::Printf(TEXT("Mean %f is %f"), mean, MEAN), FMath::Abs(mean - MEAN) < meanTolerance);
+    TestTrue(FString::Printf(TEXT("Variance %f is %f"), variance, COV), FMath::Abs(variance - COV) < varianceTolerance);
+    TestTrue(FString::Printf(TEXT("Mean %f is previous mean %f"), mean, refMean), FMath::Abs(mean - refMean) < 2.0 * meanTolerance);
+    TestTrue(FString::Printf(TEXT("Variance %f is previous variance %f"), variance, refVariance),
+             FMath::Abs(variance - refVariance) < 2.0 * varianceTolerance);
+
+    // Same distribution as previous generator, with KS critical value at 0.001 significance
+    newSamples.Sort();
+    refSamples.Sort();
+    const double ksStatistic = GetKSStatistic(newSamples, refSamples);
+    const double ksCriticalValue = 1.95 * std::sqrt(2.0 / NUM_SAMPLES);
+    TestTrue(FString::Printf(TEXT("KS statistic %f < %f"), ksStatistic, ksCriticalValue), ksStatistic < ksCriticalValue);
+
+    // Reproducible with seed, whether drawn one by one or filled
+    URRGaussianNoise* seededNoise = NewObject<URRGaussianNoise>();
+    seededNoise->Seed = SEED;
+    seededNoise->Init(MEAN, COV);
+    bool bReproduced = true;
+    for (int32 i = 0; i < 1000; ++i)
+    {
+        bReproduced &= (seededNoise->Get() == samples[i]);
+    }
+    TestTrue(TEXT("Seeded noise is reproducible"), bReproduced);
+
+    // Streams are reproducible and independent from each other
+    FRRGaussianNoiseStream stream0 = noise->MakeStream(0);
+    FRRGaussianNoiseStream stream0Copy = noise->MakeStream(0);
+    FRRGaussianNoiseStream stream1 = noise->MakeStream(1);
+    int32 numSameSamples = 0;
+    bReproduced = true;
+    for (int32 i = 0; i < 1000; ++i)
+    {
+        const float sample = stream0.Get();
+        bReproduced &= (sample == stream0Copy.Get());
+        numSameSamples += (sample == stream1.Get()) ? 1 : 0;
+    }
+    TestTrue(TEXT("Noise stream is reproducible"), bReproduced);
+    TestEqual(TEXT("Samples shared by independent streams"), numSameSamples, 0);
+
+    return true;
+}
+
+#endif    // WITH_DEV_AUTOMATION_TESTS
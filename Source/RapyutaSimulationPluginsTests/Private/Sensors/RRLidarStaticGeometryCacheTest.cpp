@@ -0,0 +1,262 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+// UE
+#include "Misc/AutomationTest.h"
+#include "Misc/ScopeExit.h"
+#include "PhysicsEngine/BodySetup.h"
+
+// RapyutaSimulationPlugins
+#include "Sensors/RRLidarStaticGeometryCache.h"
+
+#include "RRTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+static constexpr ECollisionChannel CHANNEL = ECC_Visibility;
+static constexpr float RANGE = 3000.f;
+static constexpr float TOLERANCE = 1.f;
+
+//! Room of 20m x 20m with walls from z = 0 to 2m, and boxes above the walls
+TArray<ARRTestCube*> SpawnRoom(FRRTestWorld& InWorld, FRandomStream& InOutRandomStream)
+{
+    TArray<ARRTestCube*> cubes;
+    cubes.Add(InWorld.SpawnCube(FVector(1000.f, 0.f, 100.f), FVector(0.5f, 20.f, 2.f)));
+    cubes.Add(InWorld.SpawnCube(FVector(-1000.f, 0.f, 100.f), FVector(0.5f, 20.f, 2.f)));
+    cubes.Add(InWorld.SpawnCube(FVector(0.f, 1000.f, 100.f), FVector(20.f, 0.5f, 2.f)));
+    cubes.Add(InWorld.SpawnCube(FVector(0.f, -1000.f, 100.f), FVector(20.f, 0.5f, 2.f)));
+    for (int32 i = 0; i < 50; ++i)
+    {
+        cubes.Add(InWorld.SpawnCube(
+            FVector(InOutRandomStream.FRandRange(-800.f, 800.f), InOutRandomStream.FRandRange(-800.f, 800.f), 500.f),
+            FVector(InOutRandomStream.FRandRange(0.2f, 1.5f)),
+            FRotator(InOutRandomStream.FRandRange(-45.f, 45.f), InOutRandomStream.FRandRange(0.f, 360.f), 0.f)));
+    }
+    return cubes;
+}
+
+/**
+ * @brief Trace random rays from InOrigin against both the cache and physics scene.
+ * @return Number of rays whose hits differ in blocking, distance, actor or physical material.
+ */
+int32 CountMismatchingRays(UWorld* InWorld,
+                           const URRLidarStaticGeometryCache* InCache,
+                           const FVector& InOrigin,
+                           const int32 InNumRays,
+                           const FCollisionQueryParams& InParams,
+                           FRandomStream& InOutRandomStream,
+                           int32& OutNumHits)
+{
+    int32 nMismatches = 0;
+    OutNumHits = 0;
+    for (int32 i = 0; i < InNumRays; ++i)
+    {
+        const FVector end = InOrigin + RANGE * InOutRandomStream.VRand();
+        FHitResult physicsHit, cacheHit;
+        InWorld->LineTraceSingleByChannel(physicsHit, InOrigin, end, CHANNEL, InParams);
+        InCache->Raycast(CHANNEL, InOrigin, end, InParams, cacheHit);
+        OutNumHits += physicsHit.bBlockingHit;
+        if ((physicsHit.bBlockingHit != cacheHit.bBlockingHit) ||
+            (physicsHit.bBlockingHit && ((FMath::Abs(physicsHit.Distance - cacheHit.Distance) > TOLERANCE) ||
+                                         (physicsHit.GetActor() != cacheHit.GetActor()) ||
+                                         (physicsHit.PhysMaterial != cacheHit.PhysMaterial))))
+        {
+            ++nMismatches;
+        }
+    }
+    return nMismatches;
+}
+}    // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRRLidarStaticGeometryCacheTest,
+                                 "RapyutaSimulationPlugins.Sensors.LidarStaticGeometryCache",
+                                 RR_TEST_FLAGS)
+
+bool FRRLidarStaticGeometryCacheTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NUM_RAYS = 10000;
+
+    // Room with a movable box which is not cached
+    FRRTestWorld world;
+    FRandomStream randomStream(0);
+    SpawnRoom(world, randomStream);
+    world.SpawnCube(FVector(300.f, 300.f, 500.f))->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
+    world.BeginPlay();
+    world.Tick(2);
+
+    URRLidarStaticGeometryCache* cache = world.Get()->GetSubsystem<URRLidarStaticGeometryCache>();
+    if (!TestNotNull(TEXT("Static geometry cache"), cache))
+    {
+        return false;
+    }
+    cache->RegisterChannel(CHANNEL);
+    TestTrue(TEXT("All static geometry is cached"), cache->IsSceneComplete(CHANNEL));
+
+    FCollisionQueryParams traceParams(TEXT("StaticGeometryCacheTest"), true);
+    traceParams.bReturnPhysicalMaterial = true;
+    traceParams.MobilityType = EQueryMobilityType::Static;
+
+    // Axis-aligned rays of a 2D lidar whose origin lies on the bottom or top plane of the walls
+    for (const float z : {0.f, 200.f})
+    {
+        for (const FVector& dir : {FVector::ForwardVector, FVector::BackwardVector, FVector::RightVector, FVector::LeftVector})
+        {
+            const FVector origin(0.f, 0.f, z);
+            FHitResult hit;
+            const bool bHit = cache->Raycast(CHANNEL, origin, origin + RANGE * dir, traceParams, hit);
+            TestTrue(FString::Printf(TEXT("Ray from %s to %s hits"), *origin.ToString(), *dir.ToString()), bHit);
+            TestEqual(TEXT("Hit distance"), hit.Distance, 975.f, TOLERANCE);
+        }
+    }
+
+    // Random rays against static objects in physics scene
+    const FVector origin(0.f, 0.f, 100.f);
+    int32 nHits = 0;
+    const int32 nMismatches = CountMismatchingRays(world.Get(), cache, origin, NUM_RAYS, traceParams, randomStream, nHits);
+    AddInfo(FString::Printf(TEXT("%d / %d random rays, %d physics hits, mismatch"), nMismatches, NUM_RAYS, nHits));
+    TestTrue(TEXT("Random rays hit static geometry"), nHits > 0);
+    TestEqual(TEXT("Random rays mismatching physics"), nMismatches, 0);
+
+    // Incremental update with spawned and destroyed static actors
+    FHitResult hit;
+    ARRTestCube* spawnedCube = world.SpawnCube(FVector(500.f, 0.f, 100.f));
+    cache->UpdateScenes();
+    cache->Raycast(CHANNEL, origin, origin + RANGE * FVector::ForwardVector, traceParams, hit);
+    TestEqual(TEXT("Hit distance to spawned actor"), hit.Distance, 450.f, TOLERANCE);
+    TestTrue(TEXT("Hit spawned actor"), hit.GetActor() == spawnedCube);
+
+    spawnedCube->Destroy();
+    cache->UpdateScenes();
+    cache->Raycast(CHANNEL, origin, origin + RANGE * FVector::ForwardVector, traceParams, hit);
+    TestEqual(TEXT("Hit distance after destroying spawned actor"), hit.Distance, 975.f, TOLERANCE);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRRLidarStaticGeometryCacheStationaryTest,
+                                 "RapyutaSimulationPlugins.Sensors.LidarStaticGeometryCacheStationary",
+                                 RR_TEST_FLAGS)
+
+bool FRRLidarStaticGeometryCacheStationaryTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NUM_RAYS = 10000;
+
+    // Stationary objects can not move, and are skipped by lidar's dynamic physics queries, thus must be cached
+    FRRTestWorld world;
+    FRandomStream randomStream(0);
+    for (ARRTestCube* cube : SpawnRoom(world, randomStream))
+    {
+        cube->GetStaticMeshComponent()->SetMobility(EComponentMobility::Stationary);
+    }
+    world.BeginPlay();
+    world.Tick(2);
+
+    URRLidarStaticGeometryCache* cache = world.Get()->GetSubsystem<URRLidarStaticGeometryCache>();
+    if (!TestNotNull(TEXT("Static geometry cache"), cache))
+    {
+        return false;
+    }
+    cache->RegisterChannel(CHANNEL);
+    TestTrue(TEXT("All stationary geometry is cached"), cache->IsSceneComplete(CHANNEL));
+    TestTrue(TEXT("Stationary geometry has triangles"), cache->NumTriangles > 0);
+
+    FCollisionQueryParams traceParams(TEXT("StaticGeometryCacheTest"), true);
+    traceParams.bReturnPhysicalMaterial = true;
+    int32 nHits = 0;
+    const int32 nMismatches =
+        CountMismatchingRays(world.Get(), cache, FVector(0.f, 0.f, 100.f), NUM_RAYS, traceParams, randomStream, nHits);
+    AddInfo(FString::Printf(TEXT("%d / %d random rays, %d physics hits, mismatch"), nMismatches, NUM_RAYS, nHits));
+    TestTrue(TEXT("Random rays hit stationary geometry"), nHits > 0);
+    TestEqual(TEXT("Random rays mismatching physics"), nMismatches, 0);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRRLidarStaticGeometryCacheSimpleAsComplexTest,
+                                 "RapyutaSimulationPlugins.Sensors.LidarStaticGeometryCacheSimpleAsComplex",
+                                 RR_TEST_FLAGS)
+
+bool FRRLidarStaticGeometryCacheSimpleAsComplexTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NUM_RAYS = 10000;
+
+    // Trace flag of engine meshes is changed for bodies created by this test only
+    UStaticMesh* cubeMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+    UStaticMesh* sphereMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Sphere.Sphere"));
+    if (!TestNotNull(TEXT("Cube mesh"), cubeMesh) || !TestNotNull(TEXT("Sphere mesh"), sphereMesh))
+    {
+        return false;
+    }
+    UBodySetup* cubeBodySetup = cubeMesh->GetBodySetup();
+    UBodySetup* sphereBodySetup = sphereMesh->GetBodySetup();
+    const TEnumAsByte<ECollisionTraceFlag> cubeTraceFlag = cubeBodySetup->CollisionTraceFlag;
+    const TEnumAsByte<ECollisionTraceFlag> sphereTraceFlag = sphereBodySetup->CollisionTraceFlag;
+    ON_SCOPE_EXIT
+    {
+        cubeBodySetup->CollisionTraceFlag = cubeTraceFlag;
+        sphereBodySetup->CollisionTraceFlag = sphereTraceFlag;
+    };
+    cubeBodySetup->CollisionTraceFlag = CTF_UseSimpleAsComplex;
+    sphereBodySetup->CollisionTraceFlag = CTF_UseSimpleAsComplex;
+
+    FCollisionQueryParams traceParams(TEXT("StaticGeometryCacheTest"), true);
+    traceParams.bReturnPhysicalMaterial = true;
+
+    // Boxes of simple collision are cached as triangles
+    {
+        FRRTestWorld world;
+        FRandomStream randomStream(0);
+        SpawnRoom(world, randomStream);
+        world.BeginPlay();
+        world.Tick(2);
+
+        URRLidarStaticGeometryCache* cache = world.Get()->GetSubsystem<URRLidarStaticGeometryCache>();
+        if (!TestNotNull(TEXT("Static geometry cache"), cache))
+        {
+            return false;
+        }
+        cache->RegisterChannel(CHANNEL);
+        TestTrue(TEXT("All simple collision boxes are cached"), cache->IsSceneComplete(CHANNEL));
+
+        int32 nHits = 0;
+        const int32 nMismatches =
+            CountMismatchingRays(world.Get(), cache, FVector(0.f, 0.f, 100.f), NUM_RAYS, traceParams, randomStream, nHits);
+        AddInfo(FString::Printf(TEXT("%d / %d random rays, %d physics hits, mismatch"), nMismatches, NUM_RAYS, nHits));
+        TestTrue(TEXT("Random rays hit simple collision"), nHits > 0);
+        TestEqual(TEXT("Random rays mismatching physics"), nMismatches, 0);
+    }
+
+    // Sphere of simple collision can not be triangulated exactly, thus is left to physics scene
+    {
+        FRRTestWorld world;
+        AActor* actor = world.Get()->SpawnActor<AActor>(AActor::StaticClass(), FTransform(FVector(500.f, 0.f, 0.f)));
+        UStaticMeshComponent* sphere = NewObject<UStaticMeshComponent>(actor);
+        sphere->SetMobility(EComponentMobility::Static);
+        sphere->SetStaticMesh(sphereMesh);
+        sphere->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+        actor->SetRootComponent(sphere);
+        sphere->RegisterComponent();
+        world.BeginPlay();
+        world.Tick(2);
+
+        URRLidarStaticGeometryCache* cache = world.Get()->GetSubsystem<URRLidarStaticGeometryCache>();
+        if (!TestNotNull(TEXT("Static geometry cache"), cache))
+        {
+            return false;
+        }
+        cache->RegisterChannel(CHANNEL);
+        TestFalse(TEXT("Simple collision sphere is cached"), cache->IsSceneComplete(CHANNEL));
+
+        FHitResult physicsHit, cacheHit;
+        const FVector end = RANGE * FVector::ForwardVector;
+        world.Get()->LineTraceSingleByChannel(physicsHit, FVector::ZeroVector, end, CHANNEL, traceParams);
+        TestTrue(TEXT("Physics hits simple collision sphere"), physicsHit.bBlockingHit);
+        TestFalse(TEXT("Cache hits simple collision sphere"),
+                  cache->Raycast(CHANNEL, FVector::ZeroVector, end, traceParams, cacheHit));
+    }
+
+    return true;
+}
+
+#endif    // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,143 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+// UE
+#include "Misc/AutomationTest.h"
+
+// RapyutaSimulationPlugins
+#include "Sensors/RRRenderRequestRing.h"
+
+#include "RRTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+//! Fake GPU readback: image is written by "render thread" and becomes ready later, possibly out of issue order
+struct FRRFakeReadbackRequest
+{
+    TArray<FColor> Image;
+    int32 FrameIndex = INDEX_NONE;
+    bool bReady = false;
+    int32 NumInits = 0;
+};
+}    // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRRRenderRequestRingTest, "RapyutaSimulationPlugins.Sensors.RenderRequestRing", RR_TEST_FLAGS)
+
+bool FRRRenderRequestRingTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 DEPTH = 3;
+    static constexpr int32 NUM_PIXELS = 64;
+    static constexpr int32 NUM_FRAMES = 100;
+
+    TRRRenderRequestRing<FRRFakeReadbackRequest> ring;
+    ring.Init(DEPTH,
+              [](FRRFakeReadbackRequest& InRequest)
+              {
+                  InRequest.Image.SetNumUninitialized(NUM_PIXELS);
+                  ++InRequest.NumInits;
+              });
+    TestEqual(TEXT("Depth"), ring.GetDepth(), DEPTH);
+    TestEqual(TEXT("Requests in flight after init"), ring.GetNumInFlight(), 0);
+    TestNull(TEXT("Oldest request after init"), ring.PeekOldest());
+
+    // Fill with fake readback data of given frame, as a render command would
+    auto issue = [](TRRRenderRequestRing<FRRFakeReadbackRequest>& InOutRing,
+                    const int32 InFrameIndex) -> FRRFakeReadbackRequest&
+    {
+        FRRFakeReadbackRequest& request = InOutRing.Push();
+        request.FrameIndex = InFrameIndex;
+        request.bReady = false;
+        for (FColor& pixel : request.Image)
+        {
+            pixel = FColor(InFrameIndex & 0xff, 0, 0);
+        }
+        return request;
+    };
+
+    // Slot reuse: each slot keeps its storage, and a popped slot is the next one pushed once the ring has wrapped around
+    TArray<FRRFakeReadbackRequest*> slots;
+    TArray<const FColor*> imageData;
+    for (int32 i = 0; i < DEPTH; ++i)
+    {
+        FRRFakeReadbackRequest& request = issue(ring, i);
+        slots.Add(&request);
+        imageData.Add(request.Image.GetData());
+    }
+    TestEqual(TEXT("Distinct slots"), TSet<FRRFakeReadbackRequest*>(slots).Num(), DEPTH);
+    TestEqual(TEXT("Requests in flight when full"), ring.GetNumInFlight(), DEPTH);
+    TestTrue(TEXT("Oldest request is the first pushed"), ring.PeekOldest() == slots[0]);
+
+    ring.PopOldest();
+    FRRFakeReadbackRequest& reused = issue(ring, DEPTH);
+    TestTrue(TEXT("Popped slot is reused"), &reused == slots[0]);
+    TestTrue(TEXT("Reused slot keeps its storage"), reused.Image.GetData() == imageData[0]);
+    TestEqual(TEXT("Dropped requests without overflow"), ring.GetNumDropped(), 0);
+
+    // Full ring: the oldest in flight (frame 1) is dropped and its slot is overwritten by the new frame
+    FRRFakeReadbackRequest& overwritten = issue(ring, DEPTH + 1);
+    TestTrue(TEXT("Dropped slot is overwritten"), &overwritten == slots[1]);
+    TestEqual(TEXT("Dropped requests"), ring.GetNumDropped(), 1);
+    TestEqual(TEXT("Requests in flight after drop"), ring.GetNumInFlight(), DEPTH);
+    TestEqual(TEXT("Oldest frame after drop"), ring.PeekOldest()->FrameIndex, 2);
+    TestEqual(TEXT("Requests initialized once"), slots[0]->NumInits + slots[1]->NumInits + slots[2]->NumInits, DEPTH);
+
+    // Wrap-around with fake readbacks completing out of order: frames are consumed in issue order, once they are ready
+    TRRRenderRequestRing<FRRFakeReadbackRequest> pipelineRing;
+    pipelineRing.Init(DEPTH, [](FRRFakeReadbackRequest& InRequest) { InRequest.Image.SetNumUninitialized(NUM_PIXELS); });
+    TArray<FRRFakeReadbackRequest*> pipelineSlots;
+    FRandomStream randomStream(0);
+    TArray<int32> consumedFrames;
+    int32 nWrongImages = 0;
+    int32 nWrongSlots = 0;
+    for (int32 frame = 0; frame < NUM_FRAMES; ++frame)
+    {
+        FRRFakeReadbackRequest& request = issue(pipelineRing, frame);
+        if (frame < DEPTH)
+        {
+            pipelineSlots.Add(&request);
+        }
+        nWrongSlots += (&request != pipelineSlots[frame % DEPTH]);
+
+        // Any request in flight may complete this frame
+        for (FRRFakeReadbackRequest* slot : pipelineSlots)
+        {
+            slot->bReady |= (slot->FrameIndex >= 0) && (randomStream.FRand() < 0.4f);
+        }
+        while (FRRFakeReadbackRequest* oldest = pipelineRing.PeekOldest())
+        {
+            if (!oldest->bReady)
+            {
+                break;
+            }
+            const uint8 expectedRed = oldest->FrameIndex & 0xff;
+            nWrongImages += oldest->Image.ContainsByPredicate([expectedRed](const FColor& InPixel)
+                                                              { return InPixel.R != expectedRed; });
+            consumedFrames.Add(oldest->FrameIndex);
+            oldest->FrameIndex = INDEX_NONE;
+            pipelineRing.PopOldest();
+        }
+    }
+    TestEqual(TEXT("Slots visited out of ring order"), nWrongSlots, 0);
+    TestEqual(TEXT("Consumed images of wrong frame"), nWrongImages, 0);
+    TestTrue(TEXT("Frames are consumed"), consumedFrames.Num() > 0);
+    bool bInOrder = true;
+    for (int32 i = 1; i < consumedFrames.Num(); ++i)
+    {
+        bInOrder &= (consumedFrames[i] > consumedFrames[i - 1]);
+    }
+    TestTrue(TEXT("Frames are consumed in issue order"), bInOrder);
+    TestEqual(TEXT("Issued frames are consumed, dropped or in flight"),
+              consumedFrames.Num() + pipelineRing.GetNumDropped() + pipelineRing.GetNumInFlight(),
+              NUM_FRAMES);
+    AddInfo(FString::Printf(TEXT("%d frames through a ring of %d: %d consumed, %d dropped, %d in flight"),
+                            NUM_FRAMES,
+                            DEPTH,
+                            consumedFrames.Num(),
+                            pipelineRing.GetNumDropped(),
+                            pipelineRing.GetNumInFlight()));
+
+    return true;
+}
+
+#endif    // WITH_DEV_AUTOMATION_TESTS
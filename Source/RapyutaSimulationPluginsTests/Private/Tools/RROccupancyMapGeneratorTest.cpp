@@ -0,0 +1,346 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+// UE
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// RapyutaSimulationPlugins
+#include "Tools/OccupancyMapGenerator.h"
+
+#include "RRTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+//! Platform file counting files opened under a directory, installed on top of the current one while in scope
+class FRRScopedFileOpenCounter : public IPlatformFile
+{
+public:
+    explicit FRRScopedFileOpenCounter(const FString& InDirectory)
+        : Directory(InDirectory), LowerLevel(&FPlatformFileManager::Get().GetPlatformFile())
+    {
+        FPlatformFileManager::Get().SetPlatformFile(*this);
+    }
+
+    virtual ~FRRScopedFileOpenCounter()
+    {
+        FPlatformFileManager::Get().SetPlatformFile(*LowerLevel);
+    }
+
+    UE_NONCOPYABLE(FRRScopedFileOpenCounter);
+
+    int32 NumOpens = 0;
+
+    virtual bool Initialize(IPlatformFile* Inner, const TCHAR* CmdLine) override
+    {
+        LowerLevel = Inner;
+        return true;
+    }
+    virtual IPlatformFile* GetLowerLevel() override
+    {
+        return LowerLevel;
+    }
+    virtual void SetLowerLevel(IPlatformFile* NewLowerLevel) override
+    {
+        LowerLevel = NewLowerLevel;
+    }
+    virtual const TCHAR* GetName() const override
+    {
+        return TEXT("RRFileOpenCounter");
+    }
+
+    virtual IFileHandle* OpenRead(const TCHAR* Filename, bool bAllowWrite) override
+    {
+        CountOpen(Filename);
+        return LowerLevel->OpenRead(Filename, bAllowWrite);
+    }
+    virtual IFileHandle* OpenWrite(const TCHAR* Filename, bool bAppend, bool bAllowRead) override
+    {
+        CountOpen(Filename);
+        return LowerLevel->OpenWrite(Filename, bAppend, bAllowRead);
+    }
+
+    // Others are forwarded as is
+    using IPlatformFile::IterateDirectory;
+    using IPlatformFile::IterateDirectoryStat;
+    virtual bool FileExists(const TCHAR* Filename) override
+    {
+        return LowerLevel->FileExists(Filename);
+    }
+    virtual int64 FileSize(const TCHAR* Filename) override
+    {
+        return LowerLevel->FileSize(Filename);
+    }
+    virtual bool DeleteFile(const TCHAR* Filename) override
+    {
+        return LowerLevel->DeleteFile(Filename);
+    }
+    virtual bool IsReadOnly(const TCHAR* Filename) override
+    {
+        return LowerLevel->IsReadOnly(Filename);
+    }
+    virtual bool MoveFile(const TCHAR* To, const TCHAR* From) override
+    {
+        return LowerLevel->MoveFile(To, From);
+    }
+    virtual bool SetReadOnly(const TCHAR* Filename, bool bNewReadOnlyValue) override
+    {
+        return LowerLevel->SetReadOnly(Filename, bNewReadOnlyValue);
+    }
+    virtual FDateTime GetTimeStamp(const TCHAR* Filename) override
+    {
+        return LowerLevel->GetTimeStamp(Filename);
+    }
+    virtual void SetTimeStamp(const TCHAR* Filename, FDateTime DateTime) override
+    {
+        LowerLevel->SetTimeStamp(Filename, DateTime);
+    }
+    virtual FDateTime GetAccessTimeStamp(const TCHAR* Filename) override
+    {
+        return LowerLevel->GetAccessTimeStamp(Filename);
+    }
+    virtual FString GetFilenameOnDisk(const TCHAR* Filename) override
+    {
+        return LowerLevel->GetFilenameOnDisk(Filename);
+    }
+    virtual IAsyncReadFileHandle* OpenAsyncRead(const TCHAR* Filename) override
+    {
+        return LowerLevel->OpenAsyncRead(Filename);
+    }
+    virtual IMappedFileHandle* OpenMapped(const TCHAR* Filename) override
+    {
+        return LowerLevel->OpenMapped(Filename);
+    }
+    virtual bool DirectoryExists(const TCHAR* InDirectory) override
+    {
+        return LowerLevel->DirectoryExists(InDirectory);
+    }
+    virtual bool CreateDirectory(const TCHAR* InDirectory) override
+    {
+        return LowerLevel->CreateDirectory(InDirectory);
+    }
+    virtual bool DeleteDirectory(const TCHAR* InDirectory) override
+    {
+        return LowerLevel->DeleteDirectory(InDirectory);
+    }
+    virtual FFileStatData GetStatData(const TCHAR* FilenameOrDirectory) override
+    {
+        return LowerLevel->GetStatData(FilenameOrDirectory);
+    }
+    virtual bool IterateDirectory(const TCHAR* InDirectory, FDirectoryVisitor& Visitor) override
+    {
+        return LowerLevel->IterateDirectory(InDirectory, Visitor);
+    }
+    virtual bool IterateDirectoryStat(const TCHAR* InDirectory, FDirectoryStatVisitor& Visitor) override
+    {
+        return LowerLevel->IterateDirectoryStat(InDirectory, Visitor);
+    }
+
+private:
+    //! Files opened elsewhere, e.g. by other threads, are not counted
+    void CountOpen(const TCHAR* InFilename)
+    {
+        if (FPaths::IsUnderDirectory(InFilename, Directory))
+        {
+            ++NumOpens;
+        }
+    }
+
+    FString Directory;
+
+    IPlatformFile* LowerLevel = nullptr;
+};
+}    // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRROccupancyMapGeneratorTraceTest,
+                                 "RapyutaSimulationPlugins.Tools.OccupancyMapGeneratorTrace",
+                                 RR_TEST_FLAGS)
+
+bool FRROccupancyMapGeneratorTraceTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NUM_OBSTACLES = 1000;
+    // [m]
+    static constexpr float MAP_SIZE = 40.f;
+
+    // Ground of MAP_SIZE x MAP_SIZE whose top is at z = 0, with obstacles randomly placed above it, within the traced height
+    FRRTestWorld world;
+    ARRTestCube* ground = world.SpawnCube(FVector(0.f, 0.f, -50.f), FVector(MAP_SIZE, MAP_SIZE, 1.f));
+    FRandomStream randomStream(0);
+    const float halfMapSize = MAP_SIZE * 50.f;
+    for (int32 i = 0; i < NUM_OBSTACLES; ++i)
+    {
+        world.SpawnCube(FVector(randomStream.FRandRange(-halfMapSize, halfMapSize),
+                                randomStream.FRandRange(-halfMapSize, halfMapSize),
+                                100.f),
+                        FVector(randomStream.FRandRange(0.2f, 3.f), randomStream.FRandRange(0.2f, 3.f), 1.f),
+                        FRotator(0.f, randomStream.FRandRange(0.f, 90.f), 0.f));
+    }
+    world.Tick(2);
+
+    AOccupancyMapGenerator* generator = world.Get()->SpawnActor<AOccupancyMapGenerator>();
+    if (!TestNotNull(TEXT("OccupancyMapGenerator"), generator))
+    {
+        return false;
+    }
+    generator->Map = ground;
+
+    // Trace one tile after another, then in parallel, which should give identical grids
+    generator->bParallelTrace = false;
+    double startTime = FPlatformTime::Seconds();
+    TestTrue(TEXT("Serial trace"), generator->GenerateOccupancyGrid());
+    const double serialTime = FPlatformTime::Seconds() - startTime;
+    const TArray<uint8> serialGrid = generator->OccupancyGrid;
+
+    generator->bParallelTrace = true;
+    startTime = FPlatformTime::Seconds();
+    TestTrue(TEXT("Parallel trace"), generator->GenerateOccupancyGrid());
+    const double parallelTime = FPlatformTime::Seconds() - startTime;
+    AddInfo(FString::Printf(TEXT("Traced %d cells with %d obstacles: serial %.3fs, parallel %.3fs, speedup x%.2f"),
+                            serialGrid.Num(),
+                            NUM_OBSTACLES,
+                            serialTime,
+                            parallelTime,
+                            (parallelTime > 0.0) ? serialTime / parallelTime : 0.0));
+
+    // Number of cells per side is truncated, thus may be one less due to float rounding
+    const int32 nSideCells = FMath::RoundToInt(MAP_SIZE / generator->GridRes);
+    TestTrue(TEXT("Grid cells"),
+             (serialGrid.Num() >= FMath::Square(nSideCells - 1)) && (serialGrid.Num() <= FMath::Square(nSideCells)));
+    TestTrue(TEXT("Parallel grid is identical to serial one"), generator->OccupancyGrid == serialGrid);
+    TestTrue(TEXT("Grid has occupied cells"), serialGrid.Contains(0));
+    TestTrue(TEXT("Grid has free cells"), serialGrid.Contains(255));
+
+    // Asynchronous generation traces into its own grid, which is swapped into OccupancyGrid on game thread once done.
+    // World does not begin play, thus generation is waited for here rather than finished on Tick or EndPlay.
+    generator->OccupancyGrid.Reset();
+    TestTrue(TEXT("Asynchronous generation started"), generator->GenerateOccupancyGridAsync());
+    TestEqual(TEXT("Occupancy grid cells during asynchronous generation"), generator->OccupancyGrid.Num(), 0);
+    TestTrue(TEXT("Asynchronous generation"), generator->WaitForGeneration());
+    TestFalse(TEXT("Generating after wait"), generator->IsGenerating());
+    TestTrue(TEXT("Asynchronous grid is identical to serial one"), generator->OccupancyGrid == serialGrid);
+
+    // Cancelled once its first tile is traced, serial trace skips the remaining tiles and keeps OccupancyGrid as is
+    generator->bParallelTrace = false;
+    TestTrue(TEXT("Asynchronous generation to cancel started"), generator->GenerateOccupancyGridAsync());
+    while (generator->GetGenerationProgress() <= 0.f)
+    {
+        FPlatformProcess::Sleep(0.f);
+    }
+    generator->CancelGeneration();
+    TestFalse(TEXT("Cancelled generation"), generator->WaitForGeneration());
+    const float cancelledProgress = generator->GetGenerationProgress();
+    AddInfo(FString::Printf(TEXT("Generation cancelled at %.1f%%"), cancelledProgress * 100.f));
+    TestTrue(TEXT("Partial progress of cancelled generation"), (cancelledProgress > 0.f) && (cancelledProgress < 1.f));
+    TestTrue(TEXT("Occupancy grid kept after cancel"), generator->OccupancyGrid == serialGrid);
+    TestFalse(TEXT("Generating after cancel"), generator->IsGenerating());
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRROccupancyMapGeneratorWriteTest,
+                                 "RapyutaSimulationPlugins.Tools.OccupancyMapGeneratorWrite",
+                                 RR_TEST_FLAGS)
+
+bool FRROccupancyMapGeneratorWriteTest::RunTest(const FString& Parameters)
+{
+    const FString directory = FPaths::ProjectSavedDir() / TEXT("OccupancyMapGeneratorTest");
+    IFileManager& fileManager = IFileManager::Get();
+    const AOccupancyMapGenerator* generator = GetDefault<AOccupancyMapGenerator>();
+    for (const int32 gridSize : {1000, 4000, 10000})
+    {
+        // Synthetic map of blocks, which is neither incompressible nor trivial to compress
+        const int32 nCells = gridSize * gridSize;
+        TArray<uint8> grid;
+        grid.SetNumUninitialized(nCells);
+        for (int32 j = 0; j < gridSize; ++j)
+        {
+            for (int32 i = 0; i < gridSize; ++i)
+            {
+                grid[j * gridSize + i] = (((i / 37) + (j / 53)) % 3 == 0) ? 0 : 255;
+            }
+        }
+
+        const FString filename = FString::Printf(TEXT("map_%d"), gridSize);
+        const FString pgmFile = directory / filename + TEXT(".pgm");
+        const FString pngFile = directory / filename + TEXT(".png");
+        const FString pgmHeader = FString::Printf(TEXT("P5\n%d %d\n255\n"), gridSize, gridSize);
+        auto addWriteInfo = [&](const TCHAR* InMethod, const double InTime, const int32 InNumOpens, const FString& InFile)
+        {
+            AddInfo(FString::Printf(TEXT("Wrote %dx%d map %s in %.3fms, %d file opens, %lld bytes"),
+                                    gridSize,
+                                    gridSize,
+                                    InMethod,
+                                    InTime * 1000.0,
+                                    InNumOpens,
+                                    fileManager.FileSize(*InFile)));
+        };
+
+        // Row by row, reopening the file for each row as WriteToFile used to
+        int32 nOpens = 0;
+        double startTime = FPlatformTime::Seconds();
+        bool bWritten = false;
+        {
+            FRRScopedFileOpenCounter openCounter(directory);
+            bWritten = FFileHelper::SaveStringToFile(pgmHeader, *pgmFile, FFileHelper::EEncodingOptions::ForceAnsi);
+            TArrayView<uint8> data = grid;
+            for (int32 j = 0; j < gridSize; ++j)
+            {
+                bWritten &=
+                    FFileHelper::SaveArrayToFile(data.Slice(j * gridSize, gridSize), *pgmFile, &fileManager, FILEWRITE_Append);
+            }
+            nOpens = openCounter.NumOpens;
+        }
+        addWriteInfo(TEXT("as PGM row by row"), FPlatformTime::Seconds() - startTime, nOpens, pgmFile);
+        TestTrue(TEXT("PGM written row by row"), bWritten);
+        TestEqual(TEXT("File opens of PGM written row by row"), nOpens, gridSize + 1);
+        TArray<uint8> rowByRowPGM;
+        FFileHelper::LoadFileToArray(rowByRowPGM, *pgmFile);
+
+        // Single stream, with .yaml
+        startTime = FPlatformTime::Seconds();
+        {
+            FRRScopedFileOpenCounter openCounter(directory);
+            bWritten =
+                generator->WriteMapFiles(grid, gridSize, gridSize, 0.f, 0.f, directory, filename, ERROccupancyMapFormat::PGM);
+            nOpens = openCounter.NumOpens;
+        }
+        addWriteInfo(TEXT("as PGM stream"), FPlatformTime::Seconds() - startTime, nOpens, pgmFile);
+        TestTrue(TEXT("PGM written"), bWritten);
+        TestEqual(TEXT("File opens of PGM stream and .yaml"), nOpens, 2);
+        TArray<uint8> streamPGM;
+        FFileHelper::LoadFileToArray(streamPGM, *pgmFile);
+        TestEqual(TEXT("PGM size"), streamPGM.Num(), pgmHeader.Len() + nCells);
+        TestTrue(TEXT("PGM stream is identical to PGM written row by row"), streamPGM == rowByRowPGM);
+
+        startTime = FPlatformTime::Seconds();
+        {
+            FRRScopedFileOpenCounter openCounter(directory);
+            bWritten =
+                generator->WriteMapFiles(grid, gridSize, gridSize, 0.f, 0.f, directory, filename, ERROccupancyMapFormat::PNG);
+            nOpens = openCounter.NumOpens;
+        }
+        addWriteInfo(TEXT("as PNG"), FPlatformTime::Seconds() - startTime, nOpens, pngFile);
+        TestTrue(TEXT("PNG written"), bWritten);
+        TestEqual(TEXT("File opens of PNG and .yaml"), nOpens, 2);
+        TestTrue(TEXT("PNG is smaller than PGM"), fileManager.FileSize(*pngFile) < streamPGM.Num());
+        TestTrue(TEXT("YAML written"), fileManager.FileExists(*(directory / filename + TEXT(".yaml"))));
+    }
+
+    // Image fails to be written into a directory of the same name, thus .yaml is not written either
+    const FString blockedFilename = TEXT("map_blocked");
+    const TArray<uint8> blockedGrid = {0, 255, 255, 0};
+    fileManager.MakeDirectory(*(directory / blockedFilename + TEXT(".pgm")), true);
+    AddExpectedError(TEXT("is not written"), EAutomationExpectedErrorFlags::Contains, 1);
+    TestFalse(TEXT("Map written with image blocked"),
+              generator->WriteMapFiles(blockedGrid, 2, 2, 0.f, 0.f, directory, blockedFilename, ERROccupancyMapFormat::PGM));
+    TestFalse(TEXT("YAML written without image"), fileManager.FileExists(*(directory / blockedFilename + TEXT(".yaml"))));
+    fileManager.DeleteDirectory(*directory, false, true);
+
+    return true;
+}
+
+#endif    // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,253 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+// UE
+#include "Editor.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "EngineUtils.h"
+#include "Misc/AutomationTest.h"
+#include "Settings/LevelEditorPlaySettings.h"
+#include "UObject/StrongObjectPtr.h"
+
+// RapyutaSimulationPlugins
+#include "Tools/SimulationState.h"
+
+#include "RRTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+//! First PIE world of given net mode
+UWorld* FindPIEWorld(const ENetMode InNetMode)
+{
+    for (const FWorldContext& worldContext : GEngine->GetWorldContexts())
+    {
+        UWorld* world = worldContext.World();
+        if ((worldContext.WorldType == EWorldType::PIE) && (world != nullptr) && (world->GetNetMode() == InNetMode))
+        {
+            return world;
+        }
+    }
+    return nullptr;
+}
+
+//! Bytes sent by server to all its clients so far
+uint64 GetServerOutBytes(UWorld* InServerWorld)
+{
+    uint64 outBytes = 0;
+    if (UNetDriver* netDriver = InServerWorld->GetNetDriver())
+    {
+        for (const UNetConnection* connection : netDriver->ClientConnections)
+        {
+            outBytes += connection ? connection->OutTotalBytes : 0;
+        }
+    }
+    return outBytes;
+}
+
+//! Number of plain replicated actors, as spawned by #FRRSimulationStateEntityListReplicationTest, in given world
+int32 CountPlainActors(UWorld* InWorld)
+{
+    int32 nActors = 0;
+    for (TActorIterator<AActor> it(InWorld); it; ++it)
+    {
+        if (it->GetClass() == AActor::StaticClass())
+        {
+            ++nActors;
+        }
+    }
+    return nActors;
+}
+
+//! State shared by latent commands of #FRRSimulationStateEntityListReplicationTest
+struct FRREntityListReplicationTestState
+{
+    TStrongObjectPtr<ULevelEditorPlaySettings> PlaySettings;
+    TWeakObjectPtr<UWorld> ServerWorld;
+    TWeakObjectPtr<UWorld> ClientWorld;
+    TWeakObjectPtr<ASimulationState> ServerSimState;
+    TWeakObjectPtr<ASimulationState> ClientSimState;
+    TArray<TWeakObjectPtr<AActor>> Actors;
+    int32 NumServerEntities = 0;
+    int32 NumClientEntities = 0;
+    double PhaseStartTime = 0.0;
+    uint64 PhaseStartBytes = 0;
+    double BaselineBytesPerSecond = 0.0;
+    bool bFailed = false;
+};
+}    // namespace
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRRSimulationStateEntityListReplicationTest,
+                                 "RapyutaSimulationPlugins.Tools.SimulationStateEntityListReplication",
+                                 RR_TEST_FLAGS)
+
+bool FRRSimulationStateEntityListReplicationTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NUM_ENTITIES[] = {1000, 10000};
+    // [s]
+    static constexpr double BASELINE_DURATION = 2.0;
+    static constexpr double TIMEOUT = 30.0;
+
+    if (!TestNotNull(TEXT("Editor"), GEditor) || !TestFalse(TEXT("Play session in progress"), GEditor->IsPlaySessionInProgress()))
+    {
+        return false;
+    }
+
+    // Listen server with one client in this process, connected through loopback
+    TSharedRef<FRREntityListReplicationTestState> state = MakeShared<FRREntityListReplicationTestState>();
+    state->PlaySettings.Reset(NewObject<ULevelEditorPlaySettings>());
+    state->PlaySettings->SetPlayNetMode(EPlayNetMode::PIE_ListenServer);
+    state->PlaySettings->SetPlayNumberOfClients(2);
+    state->PlaySettings->SetRunUnderOneProcess(true);
+    FRequestPlaySessionParams playSessionParams;
+    playSessionParams.WorldType = EPlaySessionWorldType::PlayInEditor;
+    playSessionParams.EditorPlaySettings = state->PlaySettings.Get();
+    GEditor->RequestPlaySession(playSessionParams);
+
+    // Wait with timeout for InCondition, which is false if it fails
+    auto waitFor = [this, state](const TCHAR* InWhat, TFunction<bool()> InCondition)
+    {
+        ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand(
+            [this, state, InWhat, InCondition, startTime = TOptional<double>()]() mutable
+            {
+                if (state->bFailed || InCondition())
+                {
+                    return true;
+                }
+                if (!startTime.IsSet())
+                {
+                    startTime = FPlatformTime::Seconds();
+                }
+                else if ((FPlatformTime::Seconds() - startTime.GetValue()) > TIMEOUT)
+                {
+                    AddError(FString::Printf(TEXT("Timed out waiting for %s"), InWhat));
+                    state->bFailed = true;
+                    return true;
+                }
+                return false;
+            }));
+    };
+    auto run = [state](TFunction<void()> InFunction)
+    {
+        ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand(
+            [state, InFunction]()
+            {
+                if (!state->bFailed)
+                {
+                    InFunction();
+                }
+                return true;
+            }));
+    };
+    auto getClientEntities = [state]()
+    { return state->ClientSimState.IsValid() ? state->ClientSimState->Entities.Num() - state->NumClientEntities : 0; };
+
+    waitFor(TEXT("client connection"),
+            [state]()
+            {
+                state->ServerWorld = FindPIEWorld(NM_ListenServer);
+                state->ClientWorld = FindPIEWorld(NM_Client);
+                return state->ServerWorld.IsValid() && state->ClientWorld.IsValid() &&
+                       state->ServerWorld->GetNetDriver() && (state->ServerWorld->GetNetDriver()->ClientConnections.Num() > 0);
+            });
+    run([state]() { state->ServerSimState = state->ServerWorld->SpawnActor<ASimulationState>(); });
+
+    for (const int32 nEntities : NUM_ENTITIES)
+    {
+        // 1- Spawn replicated actors, and wait for them on client so that their own replication is not measured
+        run(
+            [state, nEntities]()
+            {
+                UWorld* serverWorld = state->ServerWorld.Get();
+                state->Actors.Reset(nEntities);
+                for (int32 i = 0; i < nEntities; ++i)
+                {
+                    AActor* actor = serverWorld->SpawnActor<AActor>();
+                    actor->bAlwaysRelevant = true;
+                    actor->SetReplicates(true);
+                    state->Actors.Emplace(actor);
+                }
+            });
+        waitFor(TEXT("replicated actors"),
+                [state, nEntities]()
+                {
+                    for (TActorIterator<ASimulationState> it(state->ClientWorld.Get()); it; ++it)
+                    {
+                        state->ClientSimState = *it;
+                    }
+                    return state->ClientSimState.IsValid() && (CountPlainActors(state->ClientWorld.Get()) >= nEntities);
+                });
+
+        // 2- Measure traffic without change as baseline
+        run(
+            [state]()
+            {
+                state->NumServerEntities = state->ServerSimState->EntityList.Num();
+                state->NumClientEntities = state->ClientSimState->Entities.Num();
+                state->PhaseStartTime = FPlatformTime::Seconds();
+                state->PhaseStartBytes = GetServerOutBytes(state->ServerWorld.Get());
+            });
+        waitFor(TEXT("baseline"),
+                [state]() { return (FPlatformTime::Seconds() - state->PhaseStartTime) >= BASELINE_DURATION; });
+
+        // 3- Measure traffic of adding all actors, until they are all in client's Entities
+        run(
+            [state]()
+            {
+                const double now = FPlatformTime::Seconds();
+                const uint64 outBytes = GetServerOutBytes(state->ServerWorld.Get());
+                state->BaselineBytesPerSecond = (outBytes - state->PhaseStartBytes) / (now - state->PhaseStartTime);
+                state->PhaseStartTime = now;
+                state->PhaseStartBytes = outBytes;
+                for (const auto& actor : state->Actors)
+                {
+                    state->ServerSimState->ServerAddEntity(actor.Get());
+                }
+            });
+        waitFor(TEXT("entities added on client"),
+                [getClientEntities, nEntities]() { return getClientEntities() >= nEntities; });
+        run(
+            [this, state, getClientEntities, nEntities]()
+            {
+                const double duration = FPlatformTime::Seconds() - state->PhaseStartTime;
+                const uint64 addBytes = GetServerOutBytes(state->ServerWorld.Get()) - state->PhaseStartBytes;
+                AddInfo(FString::Printf(TEXT("Adding %d entities sent %llu bytes in %.3fs, %.0f bytes/s without change: "
+                                             "%.2f bytes per entity"),
+                                        nEntities,
+                                        addBytes,
+                                        duration,
+                                        state->BaselineBytesPerSecond,
+                                        (addBytes - state->BaselineBytesPerSecond * duration) / nEntities));
+                TestEqual(TEXT("Client entities"), getClientEntities(), nEntities);
+
+                // 4- Delete them as a ROS 2 request would, thus actor channels may be closed before items are removed
+                for (const auto& actor : state->Actors)
+                {
+                    if (AActor* addedActor = actor.Get())
+                    {
+                        FROSDeleteEntityReq request;
+                        request.Name = addedActor->GetName();
+                        state->ServerSimState->ServerDeleteEntity(request);
+                    }
+                }
+                TestEqual(TEXT("Server entity list items after delete"),
+                          state->ServerSimState->EntityList.Num(),
+                          state->NumServerEntities);
+            });
+        waitFor(TEXT("entities removed on client"),
+                [state, getClientEntities]()
+                { return (getClientEntities() == 0) && (CountPlainActors(state->ClientWorld.Get()) == 0); });
+    }
+
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand(
+        [state]()
+        {
+            GEditor->RequestEndPlayMap();
+            return true;
+        }));
+
+    return true;
+}
+
+#endif    // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,171 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+// UE
+#include "GameFramework/RotatingMovementComponent.h"
+#include "Misc/AutomationTest.h"
+
+// RapyutaSimulationPlugins
+#include "Tools/SimulationState.h"
+
+#include "RRTestUtils.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRRSimulationStateAddEntitiesTest,
+                                 "RapyutaSimulationPlugins.Tools.SimulationStateAddEntities",
+                                 RR_TEST_FLAGS)
+
+bool FRRSimulationStateAddEntitiesTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NUM_ENTITIES = 10000;
+    // Timer resolution and cache effects dominate below 1ms
+    static constexpr double MAX_HALF_TIME_RATIO = 2.0;
+    static constexpr double MIN_MEASURED_TIME = 1e-3;
+
+    FRRTestWorld world;
+    ASimulationState* simState = world.Get()->SpawnActor<ASimulationState>();
+    if (!TestNotNull(TEXT("SimulationState"), simState))
+    {
+        return false;
+    }
+
+    TArray<AActor*> actors;
+    actors.Reserve(NUM_ENTITIES);
+    for (int32 i = 0; i < NUM_ENTITIES; ++i)
+    {
+        actors.Emplace(world.Get()->SpawnActor<AActor>());
+    }
+
+    const int32 nSpawnableInfos = simState->SpawnableEntityInfoList.Num();
+    const SIZE_T spawnableInfosSize = simState->SpawnableEntityInfoList.Items.GetAllocatedSize();
+    const int32 nEntities = simState->EntityList.Num();
+
+    // Time both halves, as time per entity of the second half would be larger if adding grew with the number of entities
+    const int32 half = NUM_ENTITIES / 2;
+    double startTime = FPlatformTime::Seconds();
+    for (int32 i = 0; i < half; ++i)
+    {
+        simState->ServerAddEntity(actors[i]);
+    }
+    const double firstHalfTime = FPlatformTime::Seconds() - startTime;
+    startTime = FPlatformTime::Seconds();
+    for (int32 i = half; i < NUM_ENTITIES; ++i)
+    {
+        simState->ServerAddEntity(actors[i]);
+    }
+    const double secondHalfTime = FPlatformTime::Seconds() - startTime;
+    AddInfo(FString::Printf(TEXT("Added %d entities in %.3fms + %.3fms"),
+                            NUM_ENTITIES,
+                            firstHalfTime * 1000.0,
+                            secondHalfTime * 1000.0));
+
+    TestEqual(TEXT("Spawnable entity infos"), simState->SpawnableEntityInfoList.Num(), nSpawnableInfos);
+    TestTrue(TEXT("Spawnable entity infos have not grown"),
+             simState->SpawnableEntityInfoList.Items.GetAllocatedSize() == spawnableInfosSize);
+    TestEqual(TEXT("Entities"), simState->EntityList.Num(), nEntities + NUM_ENTITIES);
+    TestTrue(TEXT("Adding entities is linear"),
+             secondHalfTime <= FMath::Max(MAX_HALF_TIME_RATIO * firstHalfTime, MIN_MEASURED_TIME));
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRRSimulationStateEntityPoolingTest,
+                                 "RapyutaSimulationPlugins.Tools.SimulationStateEntityPooling",
+                                 RR_TEST_FLAGS)
+
+bool FRRSimulationStateEntityPoolingTest::RunTest(const FString& Parameters)
+{
+    static constexpr int32 NUM_SPAWNS = 1000;
+    static const FString ENTITY_TYPE_NAME = TEXT("RRTestCube");
+
+    FRRTestWorld world;
+    ASimulationState* simState = world.Get()->SpawnActor<ASimulationState>();
+    if (!TestNotNull(TEXT("SimulationState"), simState))
+    {
+        return false;
+    }
+    simState->SpawnableEntityTypes.Emplace(ENTITY_TYPE_NAME, ARRTestCube::StaticClass());
+
+    // Spawn and delete entities one after another, thus with pooling every spawn but the first one reuses the entity deleted
+    // right before
+    FROSSpawnEntityReq spawnRequest;
+    spawnRequest.Xml = ENTITY_TYPE_NAME;
+    FROSDeleteEntityReq deleteRequest;
+    TArray<double> spawnTimes;
+    spawnTimes.Reserve(NUM_SPAWNS);
+    for (const bool bPooling : {false, true})
+    {
+        simState->bEnableEntityPooling = bPooling;
+        spawnTimes.Reset();
+        int32 nSpawnedEntities = 0;
+        int32 nReusedEntities = 0;
+        int32 nDestroyedEntities = 0;
+        int32 nTickingEntities = 0;
+        for (int32 i = 0; i < NUM_SPAWNS; ++i)
+        {
+            spawnRequest.State.Name = FString::Printf(TEXT("PoolingTest_%d_%d"), bPooling, i);
+            const int32 nPooledEntities = simState->GetNumPooledEntities(ENTITY_TYPE_NAME);
+            const double startTime = FPlatformTime::Seconds();
+            AActor* entity = simState->ServerSpawnEntity(spawnRequest, 0);
+            spawnTimes.Emplace(FPlatformTime::Seconds() - startTime);
+            if (entity == nullptr)
+            {
+                continue;
+            }
+            ++nSpawnedEntities;
+            if (simState->GetNumPooledEntities(ENTITY_TYPE_NAME) < nPooledEntities)
+            {
+                ++nReusedEntities;
+            }
+
+            // Component tick is disabled while pooled, and restored on reuse
+            URotatingMovementComponent* tickingComponent = entity->FindComponentByClass<URotatingMovementComponent>();
+            if (tickingComponent == nullptr)
+            {
+                tickingComponent = NewObject<URotatingMovementComponent>(entity);
+                tickingComponent->RegisterComponent();
+            }
+            else if (tickingComponent->IsComponentTickEnabled())
+            {
+                ++nTickingEntities;
+            }
+
+            deleteRequest.Name = spawnRequest.State.Name;
+            simState->ServerDeleteEntity(deleteRequest);
+            if (!IsValid(entity))
+            {
+                ++nDestroyedEntities;
+            }
+            else if (bPooling)
+            {
+                TestFalse(TEXT("Pooled entity component tick"), tickingComponent->IsComponentTickEnabled());
+                TestFalse(TEXT("Pooled entity tick"), entity->IsActorTickEnabled());
+            }
+        }
+
+        TestEqual(TEXT("Spawned entities"), nSpawnedEntities, NUM_SPAWNS);
+        if (bPooling)
+        {
+            TestEqual(TEXT("Reused entities"), nReusedEntities, NUM_SPAWNS - 1);
+            TestEqual(TEXT("Reused entities with component tick"), nTickingEntities, NUM_SPAWNS - 1);
+        }
+        else
+        {
+            TestEqual(TEXT("Destroyed entities"), nDestroyedEntities, NUM_SPAWNS);
+        }
+
+        spawnTimes.Sort();
+        auto getPercentileMs = [&spawnTimes](const double InRatio)
+        { return 1000.0 * spawnTimes[FMath::Min(FMath::FloorToInt(InRatio * spawnTimes.Num()), spawnTimes.Num() - 1)]; };
+        AddInfo(FString::Printf(TEXT("Spawn latency with pooling %s: p50 %.3fms, p90 %.3fms, p99 %.3fms, max %.3fms"),
+                                bPooling ? TEXT("on") : TEXT("off"),
+                                getPercentileMs(0.5),
+                                getPercentileMs(0.9),
+                                getPercentileMs(0.99),
+                                getPercentileMs(1.0)));
+    }
+
+    return true;
+}
+
+#endif    // WITH_DEV_AUTOMATION_TESTS
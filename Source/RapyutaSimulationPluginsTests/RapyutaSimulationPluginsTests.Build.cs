@@ -0,0 +1,18 @@
+// Copyright 2020-2023 Rapyuta Robotics Co., Ltd.
+
+using UnrealBuildTool;
+
+// Automation tests of RapyutaSimulationPlugins, run headless with
+// UnrealEditor-Cmd <project> -ExecCmds="Automation RunTests RapyutaSimulationPlugins;Quit" -nullrhi -unattended
+public class RapyutaSimulationPluginsTests : ModuleRules
+{
+    public RapyutaSimulationPluginsTests(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+        CppStandard = CppStandardVersion.Cpp17;
+        bEnableExceptions = true;
+
+        PrivateDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "UnrealEd",
+                                                             "rclUE", "RapyutaSimulationPlugins" });
+    }
+}